@@ -0,0 +1,168 @@
+
+#include "Harness.h"
+
+#include "Mutex/BlockingBarrier.h"
+#include "Mutex/CombiningTreeBarrier.h"
+#include "Mutex/CyclicSpinBarrier.h"
+#include "Mutex/SenseReversingBarrier.h"
+#include "Mutex/SpinBarrier.h"
+
+#include <condition_variable>
+#include <limits>
+#include <memory>
+#include <mutex>
+
+namespace DX
+{
+namespace Bench
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    namespace
+    {
+        // The baseline: a generation counter behind a std::mutex and std::condition_variable
+        class CondVarBarrier
+        {
+        public:
+            explicit CondVarBarrier(size_t numThreads) : m_expected(numThreads), m_count(numThreads), m_generation(0)
+            {
+            }
+
+            void wait()
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                const size_t generation = m_generation;
+                if(--m_count == 0)
+                {
+                    m_count = m_expected;
+                    ++m_generation;
+                    m_condition.notify_all();
+                    return;
+                }
+                m_condition.wait(lock, [&]() { return m_generation != generation; });
+            }
+
+        private:
+            std::mutex              m_mutex;
+            std::condition_variable m_condition;
+            const size_t            m_expected;
+            size_t                  m_count;
+            size_t                  m_generation;
+        };
+
+        // Every round on the same reusable barrier
+        template <typename BarrierT>
+        struct Cyclic
+        {
+            BarrierT& barrier;
+            void wait(size_t, size_t) { barrier.wait(); }
+        };
+
+        struct Tree
+        {
+            CombiningTreeBarrier& barrier;
+            void wait(size_t, size_t threadIndex) { barrier.wait(threadIndex); }
+        };
+
+        // SpinBarrier is single use, so every round gets a fresh one
+        struct OneShot
+        {
+            std::vector<std::unique_ptr<SpinBarrier>>& barriers;
+            void wait(size_t round, size_t) { barriers[round]->wait(); }
+        };
+
+        template <typename Source>
+        struct BarrierBody
+        {
+            Source&                 source;
+            std::atomic<size_t>&    stopRound;
+            size_t                  maxRounds;
+
+            uint64_t operator()(size_t threadIndex, const std::atomic<bool>& stop)
+            {
+                /*
+                    Every thread has to agree on the last round or somebody is left waiting forever.
+                    Thread 0 picks it before arriving, so the barrier itself publishes it to everybody
+                    leaving that round.
+                */
+                for(size_t round = 0;; ++round)
+                {
+                    if(threadIndex == 0 && stopRound.load(std::memory_order_relaxed) == std::numeric_limits<size_t>::max()
+                        && (stop.load(std::memory_order_relaxed) || round + 1 == maxRounds))
+                    {
+                        stopRound.store(round, std::memory_order_relaxed);
+                    }
+                    source.wait(round, threadIndex);
+                    if(round >= stopRound.load(std::memory_order_relaxed))
+                        return round + 1;
+                }
+            }
+        };
+
+        template <typename Source>
+        void benchmarkBarrier(const Options& options, const char* primitive, size_t threads, Source& source,
+            std::ostream& out)
+        {
+            std::atomic<size_t> stopRound(std::numeric_limits<size_t>::max());
+            BarrierBody<Source> body = { source, stopRound, options.barrierRounds };
+            Result result;
+            result.suite = "barrier";
+            result.primitive = primitive;
+            runTimed(threads, options.durationMs, body, result);
+            writeCsvRow(out, result);
+        }
+    }
+
+    void runBarrierBenchmarks(const Options& options, std::ostream& out)
+    {
+        if(!runsSuite(options, "barrier"))
+            return;
+
+        for(size_t i = 0; i < options.threads.size(); ++i)
+        {
+            const size_t threads = options.threads[i];
+            if(runsPrimitive(options, "SpinBarrier"))
+            {
+                std::vector<std::unique_ptr<SpinBarrier>> barriers;
+                for(size_t round = 0; round < options.barrierRounds; ++round)
+                    barriers.push_back(std::unique_ptr<SpinBarrier>(new SpinBarrier(threads)));
+                OneShot source = { barriers };
+                benchmarkBarrier(options, "SpinBarrier", threads, source, out);
+            }
+            if(runsPrimitive(options, "CyclicSpinBarrier"))
+            {
+                CyclicSpinBarrier barrier(threads);
+                Cyclic<CyclicSpinBarrier> source = { barrier };
+                benchmarkBarrier(options, "CyclicSpinBarrier", threads, source, out);
+            }
+            if(runsPrimitive(options, "SenseReversingBarrier"))
+            {
+                SenseReversingBarrier barrier(threads);
+                Cyclic<SenseReversingBarrier> source = { barrier };
+                benchmarkBarrier(options, "SenseReversingBarrier", threads, source, out);
+            }
+            if(runsPrimitive(options, "CombiningTreeBarrier"))
+            {
+                CombiningTreeBarrier barrier(threads);
+                Tree source = { barrier };
+                benchmarkBarrier(options, "CombiningTreeBarrier", threads, source, out);
+            }
+            if(runsPrimitive(options, "BlockingBarrier"))
+            {
+                BlockingBarrier barrier(threads);
+                Cyclic<BlockingBarrier> source = { barrier };
+                benchmarkBarrier(options, "BlockingBarrier", threads, source, out);
+            }
+            if(runsPrimitive(options, "std::condition_variable"))
+            {
+                CondVarBarrier barrier(threads);
+                Cyclic<CondVarBarrier> source = { barrier };
+                benchmarkBarrier(options, "std::condition_variable", threads, source, out);
+            }
+        }
+    }
+
+}
+}
\ No newline at end of file
@@ -0,0 +1,17 @@
+
+#include "Harness.h"
+
+#include <iostream>
+
+int main(int argc, char** argv)
+{
+    DX::Bench::Options options;
+    if(!DX::Bench::parseOptions(argc, argv, options, std::cerr))
+        return 1;
+
+    DX::Bench::writeCsvHeader(std::cout);
+    DX::Bench::runMutexBenchmarks(options, std::cout);
+    DX::Bench::runQueueBenchmarks(options, std::cout);
+    DX::Bench::runBarrierBenchmarks(options, std::cout);
+    return 0;
+}
\ No newline at end of file
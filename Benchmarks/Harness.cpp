@@ -0,0 +1,340 @@
+
+#include "Harness.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <thread>
+
+#if defined(__linux__)
+    #include <pthread.h>
+    #include <sched.h>
+#elif defined(_WIN32)
+    #define NOMINMAX
+    #include <Windows.h>
+#endif
+
+namespace DX
+{
+namespace Bench
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    namespace
+    {
+        // Powers of two up to the hardware thread count, plus the hardware thread count itself
+        std::vector<size_t> defaultThreads()
+        {
+            const size_t hardware = std::max<size_t>(2, std::thread::hardware_concurrency());
+            std::vector<size_t> threads;
+            for(size_t count = 1; count < hardware; count *= 2)
+                threads.push_back(count);
+            threads.push_back(hardware);
+            return threads;
+        }
+
+        double jain(std::vector<uint64_t>::const_iterator begin, std::vector<uint64_t>::const_iterator end)
+        {
+            double sum = 0.0;
+            double sumOfSquares = 0.0;
+            size_t count = 0;
+            for(; begin != end; ++begin, ++count)
+            {
+                const double value = static_cast<double>(*begin);
+                sum += value;
+                sumOfSquares += value * value;
+            }
+            if(count == 0 || sumOfSquares == 0.0)
+                return 1.0;
+            return (sum * sum) / (static_cast<double>(count) * sumOfSquares);
+        }
+    }
+
+    std::vector<std::string> splitList(const char* list)
+    {
+        std::vector<std::string> items;
+        std::stringstream stream(list);
+        std::string item;
+        while(std::getline(stream, item, ','))
+        {
+            if(!item.empty())
+                items.push_back(item);
+        }
+        return items;
+    }
+
+    bool parseNumber(const std::string& text, unsigned long long& out)
+    {
+        if(text.empty())
+            return false;
+        char* end = nullptr;
+        out = std::strtoull(text.c_str(), &end, 10);
+        return *end == '\0';
+    }
+
+    bool parseNumberList(const std::string& text, std::vector<size_t>& out)
+    {
+        std::vector<std::string> items = splitList(text.c_str());
+        std::vector<size_t> numbers;
+        for(size_t i = 0; i < items.size(); ++i)
+        {
+            unsigned long long number = 0;
+            if(!parseNumber(items[i], number))
+                return false;
+            numbers.push_back(static_cast<size_t>(number));
+        }
+        if(numbers.empty())
+            return false;
+        out = numbers;
+        return true;
+    }
+
+    Options::Options()
+        : threads(defaultThreads()), durationMs(200), criticalWork(16), outsideWork(0),
+          queueBound(1 << 16), barrierRounds(100000)
+    {
+        suites.push_back("mutex");
+        suites.push_back("rwmutex");
+        suites.push_back("queue");
+        suites.push_back("barrier");
+        readPercents.push_back(50);
+        readPercents.push_back(90);
+        readPercents.push_back(99);
+    }
+
+    void printUsage(std::ostream& out)
+    {
+        out << "Usage: ConcurrentDXBench [options]\n"
+            << "Writes one CSV row per primitive and configuration to stdout.\n\n"
+            << "  --suites=LIST         mutex,rwmutex,queue,barrier (default: all)\n"
+            << "  --threads=LIST        thread counts to sweep (default: powers of two up to the core count)\n"
+            << "  --duration-ms=N       how long each configuration runs (default: 200)\n"
+            << "  --filter=TEXT         only run primitives whose name contains TEXT\n"
+            << "  --critical-work=N     busy iterations inside each critical section (default: 16)\n"
+            << "  --outside-work=N      busy iterations between critical sections (default: 0)\n"
+            << "  --read-percents=LIST  read-side mixes for the rwmutex suite (default: 50,90,99)\n"
+            << "  --queue-bound=N       producers back off above this many queued elements (default: 65536)\n"
+            << "  --barrier-rounds=N    most barrier phases per configuration (default: 100000)\n"
+            << "  --help\n";
+    }
+
+    bool parseOptions(int argc, char** argv, Options& out, std::ostream& err)
+    {
+        for(int i = 1; i < argc; ++i)
+        {
+            const std::string argument = argv[i];
+            const size_t equals = argument.find('=');
+            const std::string name = argument.substr(0, equals);
+            const std::string value = equals == std::string::npos ? std::string() : argument.substr(equals + 1);
+            unsigned long long number = 0;
+
+            if(name == "--help")
+            {
+                printUsage(err);
+                return false;
+            }
+            else if(name == "--suites")
+            {
+                out.suites = splitList(value.c_str());
+            }
+            else if(name == "--filter")
+            {
+                out.filter = value;
+            }
+            else if(name == "--threads" || name == "--read-percents")
+            {
+                std::vector<size_t> numbers;
+                if(!parseNumberList(value, numbers)
+                    || (name == "--threads" ? *std::min_element(numbers.begin(), numbers.end()) == 0
+                                            : *std::max_element(numbers.begin(), numbers.end()) > 100))
+                {
+                    err << "Bad value in " << argument << "\n";
+                    return false;
+                }
+                if(name == "--threads")
+                    out.threads = numbers;
+                else
+                    out.readPercents.assign(numbers.begin(), numbers.end());
+            }
+            else if(name == "--duration-ms" || name == "--critical-work" || name == "--outside-work"
+                || name == "--queue-bound" || name == "--barrier-rounds")
+            {
+                if(!parseNumber(value, number))
+                {
+                    err << "Bad number in " << argument << "\n";
+                    return false;
+                }
+                if(name == "--duration-ms")
+                    out.durationMs = static_cast<unsigned>(number);
+                else if(name == "--critical-work")
+                    out.criticalWork = static_cast<size_t>(number);
+                else if(name == "--outside-work")
+                    out.outsideWork = static_cast<size_t>(number);
+                else if(name == "--queue-bound")
+                    out.queueBound = static_cast<size_t>(number);
+                else
+                    out.barrierRounds = std::max<size_t>(1, static_cast<size_t>(number));
+            }
+            else
+            {
+                err << "Unknown option " << argument << "\n";
+                printUsage(err);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool runsSuite(const Options& options, const char* suite)
+    {
+        return std::find(options.suites.begin(), options.suites.end(), suite) != options.suites.end();
+    }
+
+    bool runsPrimitive(const Options& options, const std::string& primitive)
+    {
+        return options.filter.empty() || primitive.find(options.filter) != std::string::npos;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    Result::Result() : producers(0), consumers(0), readPercent(0), seconds(0.0)
+    {
+    }
+
+    size_t Result::threads() const
+    {
+        return threadOps.size();
+    }
+
+    uint64_t Result::ops() const
+    {
+        // A queue operation is an element making it from a producer to a consumer
+        uint64_t total = 0;
+        for(size_t i = producers; i < threadOps.size(); ++i)
+            total += threadOps[i];
+        return total;
+    }
+
+    double Result::fairness() const
+    {
+        if(producers == 0)
+            return jain(threadOps.begin(), threadOps.end());
+        return std::min(jain(threadOps.begin(), threadOps.begin() + producers),
+            jain(threadOps.begin() + producers, threadOps.end()));
+    }
+
+    void writeCsvHeader(std::ostream& out)
+    {
+        out << "suite,primitive,threads,producers,consumers,readPercent,ops,seconds,opsPerSec,"
+            << "minThreadOps,maxThreadOps,fairness\n";
+    }
+
+    void writeCsvRow(std::ostream& out, const Result& result)
+    {
+        uint64_t minOps = 0;
+        uint64_t maxOps = 0;
+        // Queue rows only compare consumers, producers are throttled by the bound
+        const size_t first = result.producers;
+        for(size_t i = first; i < result.threadOps.size(); ++i)
+        {
+            minOps = i == first ? result.threadOps[i] : std::min(minOps, result.threadOps[i]);
+            maxOps = std::max(maxOps, result.threadOps[i]);
+        }
+
+        const uint64_t ops = result.ops();
+        out << result.suite << ',' << result.primitive << ',' << result.threads() << ','
+            << result.producers << ',' << result.consumers << ',' << result.readPercent << ','
+            << ops << ',' << std::fixed << std::setprecision(6) << result.seconds << ','
+            << std::setprecision(0) << (result.seconds > 0.0 ? static_cast<double>(ops) / result.seconds : 0.0) << ','
+            << minOps << ',' << maxOps << ',' << std::setprecision(4) << result.fairness() << '\n';
+        out.flush();
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    void runTimed(size_t numThreads, unsigned durationMs, ThreadBody body, void* context, Result& result)
+    {
+        typedef std::chrono::steady_clock Clock;
+
+        std::atomic<size_t> ready(0);
+        std::atomic<size_t> finished(0);
+        std::atomic<bool> start(false);
+        std::atomic<bool> stop(false);
+        std::vector<uint64_t> threadOps(numThreads, 0);
+        std::vector<Clock::time_point> threadEnds(numThreads);
+        std::vector<std::thread> workers;
+
+        for(size_t i = 0; i < numThreads; ++i)
+        {
+            workers.push_back(std::thread([&, i]()
+            {
+                ++ready;
+                while(!start.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+                threadOps[i] = body(context, i, stop);
+                threadEnds[i] = Clock::now();
+                ++finished;
+            }));
+        }
+
+        while(ready.load() != numThreads)
+            std::this_thread::yield();
+
+        const Clock::time_point begin = Clock::now();
+        const Clock::time_point deadline = begin + std::chrono::milliseconds(durationMs);
+        start.store(true, std::memory_order_release);
+        // Bodies may finish early on their own (e.g. barriers running out of rounds)
+        while(finished.load() != numThreads && Clock::now() < deadline)
+            std::this_thread::sleep_for(std::min<Clock::duration>(deadline - Clock::now(), std::chrono::milliseconds(1)));
+        stop.store(true, std::memory_order_release);
+        for(size_t i = 0; i < workers.size(); ++i)
+            workers[i].join();
+
+        result.threadOps = threadOps;
+        result.seconds = std::chrono::duration<double>(*std::max_element(threadEnds.begin(), threadEnds.end()) - begin).count();
+    }
+
+    uint64_t nowNanoseconds()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    bool pinCurrentThread(size_t cpu)
+    {
+        #if defined(__linux__)
+            if(cpu >= CPU_SETSIZE)
+                return false;
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(cpu, &cpus);
+            return pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+        #elif defined(_WIN32)
+            if(cpu >= sizeof(DWORD_PTR) * 8)
+                return false;
+            return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) != 0;
+        #else
+            (void)cpu;
+            return false;
+        #endif
+    }
+
+    void spinWork(size_t iterations)
+    {
+        volatile size_t sink = 0;
+        for(size_t i = 0; i < iterations; ++i)
+            sink = sink + i;
+    }
+
+}
+}
\ No newline at end of file
@@ -0,0 +1,130 @@
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace DX
+{
+namespace Bench
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief Command line settings shared by every suite, see printUsage()
+    */
+    struct Options
+    {
+        Options();
+
+        std::vector<std::string>    suites;
+        std::vector<size_t>         threads;
+        std::vector<unsigned>       readPercents;
+        std::string                 filter;
+        unsigned                    durationMs;
+        size_t                      criticalWork;
+        size_t                      outsideWork;
+        size_t                      queueBound;
+        size_t                      barrierRounds;
+    };
+
+    std::vector<std::string> splitList(const char* list);
+    bool parseNumber(const std::string& text, unsigned long long& out);
+    /*! \brief Parses a comma separated list of numbers, false if any is malformed or there are none
+    */
+    bool parseNumberList(const std::string& text, std::vector<size_t>& out);
+
+    bool parseOptions(int argc, char** argv, Options& out, std::ostream& err);
+    void printUsage(std::ostream& out);
+
+    bool runsSuite(const Options& options, const char* suite);
+    bool runsPrimitive(const Options& options, const std::string& primitive);
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief One CSV row: a primitive at one thread count / producer-consumer split / read mix
+    */
+    struct Result
+    {
+        Result();
+
+        std::string             suite;
+        std::string             primitive;
+        size_t                  producers;
+        size_t                  consumers;
+        unsigned                readPercent;
+        double                  seconds;
+        // Operations each thread completed. Producers come first, then consumers.
+        std::vector<uint64_t>   threadOps;
+
+        size_t   threads() const;
+        uint64_t ops() const;
+        /*! \brief Jain's fairness index over threads of the same role, 1 is perfectly fair and
+            1/n means one thread did all the work. Queues report the worse of producers and
+            consumers.
+        */
+        double   fairness() const;
+    };
+
+    void writeCsvHeader(std::ostream& out);
+    void writeCsvRow(std::ostream& out, const Result& result);
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief Body of a timed benchmark thread. Runs until stop is set and returns how many
+        operations it completed.
+    */
+    typedef uint64_t (*ThreadBody)(void* context, size_t threadIndex, const std::atomic<bool>& stop);
+
+    /*! \brief Starts numThreads threads together, lets them run for durationMs and stops them.
+        Fills result.threadOps and result.seconds.
+    */
+    void runTimed(size_t numThreads, unsigned durationMs, ThreadBody body, void* context, Result& result);
+
+    template <typename Body>
+    void runTimed(size_t numThreads, unsigned durationMs, Body& body, Result& result);
+
+    /*! \brief Burns roughly iterations cycles without touching shared memory
+    */
+    void spinWork(size_t iterations);
+
+    /*! \brief Monotonic timestamp in nanoseconds
+    */
+    uint64_t nowNanoseconds();
+
+    /*! \brief Pins the calling thread to one cpu. Returns false if the cpu doesn't exist or the
+        platform can't pin.
+    */
+    bool pinCurrentThread(size_t cpu);
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    void runMutexBenchmarks(const Options& options, std::ostream& out);
+    void runQueueBenchmarks(const Options& options, std::ostream& out);
+    void runBarrierBenchmarks(const Options& options, std::ostream& out);
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    template <typename Body>
+    uint64_t invokeBody(void* context, size_t threadIndex, const std::atomic<bool>& stop)
+    {
+        return (*static_cast<Body*>(context))(threadIndex, stop);
+    }
+
+    template <typename Body>
+    void runTimed(size_t numThreads, unsigned durationMs, Body& body, Result& result)
+    {
+        runTimed(numThreads, durationMs, &invokeBody<Body>, &body, result);
+    }
+
+}
+}
\ No newline at end of file
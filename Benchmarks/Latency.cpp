@@ -0,0 +1,210 @@
+
+#include "Latency.h"
+#include "Harness.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include <thread>
+
+namespace DX
+{
+namespace Bench
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    // Closer than this to the next operation we spin, further away we yield the core
+    #ifndef LATENCY_SPIN_WINDOW_NS
+        #define LATENCY_SPIN_WINDOW_NS 50000
+    #endif
+
+    LatencyOptions::LatencyOptions()
+        : pin(true), durationMs(1000), warmupMs(100), rate(100000), producers(1), consumers(1),
+          criticalWork(16), readPercent(90)
+    {
+        suites.push_back("queue");
+        suites.push_back("lock");
+
+        const size_t hardware = std::max<size_t>(1, std::thread::hardware_concurrency());
+        threads.push_back(2);
+        if(hardware > 2)
+            threads.push_back(hardware);
+        for(size_t cpu = 0; cpu < hardware; ++cpu)
+            cpus.push_back(cpu);
+    }
+
+    size_t LatencyOptions::cpuFor(size_t threadIndex) const
+    {
+        return cpus[threadIndex % cpus.size()];
+    }
+
+    bool LatencyOptions::runsSuite(const char* suite) const
+    {
+        return std::find(suites.begin(), suites.end(), suite) != suites.end();
+    }
+
+    bool LatencyOptions::runsPrimitive(const std::string& primitive) const
+    {
+        return filter.empty() || primitive.find(filter) != std::string::npos;
+    }
+
+    void printLatencyUsage(std::ostream& out)
+    {
+        out << "Usage: ConcurrentDXLatency [options]\n"
+            << "Drives each primitive at a fixed rate and writes latency percentiles as CSV to stdout.\n\n"
+            << "  --suites=LIST         queue,lock (default: both)\n"
+            << "  --rate=N              operations per second over all threads (default: 100000)\n"
+            << "  --duration-ms=N       how long each configuration runs (default: 1000)\n"
+            << "  --warmup-ms=N         operations scheduled in this first stretch aren't recorded (default: 100)\n"
+            << "  --producers=N         queue producers (default: 1)\n"
+            << "  --consumers=N         queue consumers (default: 1)\n"
+            << "  --threads=LIST        thread counts contending for the locks (default: 2 and the core count)\n"
+            << "  --critical-work=N     busy iterations while holding a lock (default: 16)\n"
+            << "  --read-percent=N      share of shared acquisitions on reader-writer locks (default: 90)\n"
+            << "  --cpus=LIST           cpus to pin threads to, round robin (default: every cpu)\n"
+            << "  --no-pin              let the scheduler place threads\n"
+            << "  --filter=TEXT         only run primitives whose name contains TEXT\n"
+            << "  --help\n";
+    }
+
+    bool parseLatencyOptions(int argc, char** argv, LatencyOptions& out, std::ostream& err)
+    {
+        for(int i = 1; i < argc; ++i)
+        {
+            const std::string argument = argv[i];
+            const size_t equals = argument.find('=');
+            const std::string name = argument.substr(0, equals);
+            const std::string value = equals == std::string::npos ? std::string() : argument.substr(equals + 1);
+            unsigned long long number = 0;
+
+            if(name == "--help")
+            {
+                printLatencyUsage(err);
+                return false;
+            }
+            else if(name == "--no-pin")
+            {
+                out.pin = false;
+            }
+            else if(name == "--suites")
+            {
+                out.suites = splitList(value.c_str());
+            }
+            else if(name == "--filter")
+            {
+                out.filter = value;
+            }
+            else if(name == "--threads" || name == "--cpus")
+            {
+                std::vector<size_t> numbers;
+                if(!parseNumberList(value, numbers)
+                    || (name == "--threads" && *std::min_element(numbers.begin(), numbers.end()) == 0))
+                {
+                    err << "Bad value in " << argument << "\n";
+                    return false;
+                }
+                if(name == "--threads")
+                    out.threads = numbers;
+                else
+                    out.cpus = numbers;
+            }
+            else if(name == "--rate" || name == "--duration-ms" || name == "--warmup-ms" || name == "--producers"
+                || name == "--consumers" || name == "--critical-work" || name == "--read-percent")
+            {
+                if(!parseNumber(value, number)
+                    || (number == 0 && (name == "--rate" || name == "--producers" || name == "--consumers"))
+                    || (number > 100 && name == "--read-percent"))
+                {
+                    err << "Bad number in " << argument << "\n";
+                    return false;
+                }
+                if(name == "--rate")
+                    out.rate = number;
+                else if(name == "--duration-ms")
+                    out.durationMs = static_cast<unsigned>(number);
+                else if(name == "--warmup-ms")
+                    out.warmupMs = static_cast<unsigned>(number);
+                else if(name == "--producers")
+                    out.producers = static_cast<size_t>(number);
+                else if(name == "--consumers")
+                    out.consumers = static_cast<size_t>(number);
+                else if(name == "--critical-work")
+                    out.criticalWork = static_cast<size_t>(number);
+                else
+                    out.readPercent = static_cast<unsigned>(number);
+            }
+            else
+            {
+                err << "Unknown option " << argument << "\n";
+                printLatencyUsage(err);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    LatencyResult::LatencyResult()
+        : threads(0), producers(0), consumers(0), readPercent(0), targetRate(0), issued(0), seconds(0.0)
+    {
+    }
+
+    void writeLatencyCsvHeader(std::ostream& out)
+    {
+        out << "suite,primitive,threads,producers,consumers,readPercent,targetRate,achievedRate,samples,"
+            << "meanNs,p50Ns,p90Ns,p99Ns,p999Ns,p9999Ns,maxNs,serviceP50Ns,serviceP99Ns,serviceP999Ns,serviceMaxNs\n";
+    }
+
+    void writeLatencyCsvRow(std::ostream& out, const LatencyResult& result)
+    {
+        const LatencyHistogram& latency = result.latency;
+        const LatencyHistogram& service = result.service;
+        out << result.suite << ',' << result.primitive << ',' << result.threads << ','
+            << result.producers << ',' << result.consumers << ',' << result.readPercent << ','
+            << result.targetRate << ',' << std::fixed << std::setprecision(0)
+            << (result.seconds > 0.0 ? static_cast<double>(result.issued) / result.seconds : 0.0) << ','
+            << latency.count() << ',' << latency.mean() << ','
+            << latency.percentile(0.5) << ',' << latency.percentile(0.9) << ','
+            << latency.percentile(0.99) << ',' << latency.percentile(0.999) << ','
+            << latency.percentile(0.9999) << ',' << latency.max() << ','
+            << service.percentile(0.5) << ',' << service.percentile(0.99) << ','
+            << service.percentile(0.999) << ',' << service.max() << '\n';
+        out.flush();
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    Schedule::Schedule(uint64_t rate)
+        : m_start(nowNanoseconds()), m_interval(1e9 / static_cast<double>(rate)), m_issued(0)
+    {
+    }
+
+    uint64_t Schedule::start() const
+    {
+        return m_start;
+    }
+
+    uint64_t Schedule::next()
+    {
+        const uint64_t due = m_start + static_cast<uint64_t>(static_cast<double>(m_issued) * m_interval);
+        ++m_issued;
+        for(;;)
+        {
+            const uint64_t now = nowNanoseconds();
+            if(now >= due)
+                return due;
+            if(due - now > LATENCY_SPIN_WINDOW_NS)
+                std::this_thread::yield();
+            // Spin out
+        }
+    }
+
+}
+}
\ No newline at end of file
@@ -0,0 +1,107 @@
+
+#pragma once
+
+#include "LatencyHistogram.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace DX
+{
+namespace Bench
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief Command line settings of ConcurrentDXLatency, see printLatencyUsage()
+    */
+    struct LatencyOptions
+    {
+        LatencyOptions();
+
+        std::vector<std::string>    suites;
+        std::vector<size_t>         threads;
+        std::vector<size_t>         cpus;
+        std::string                 filter;
+        bool                        pin;
+        unsigned                    durationMs;
+        unsigned                    warmupMs;
+        uint64_t                    rate;
+        size_t                      producers;
+        size_t                      consumers;
+        size_t                      criticalWork;
+        unsigned                    readPercent;
+
+        /*! \brief Cpu the thread with the given index gets pinned to
+        */
+        size_t cpuFor(size_t threadIndex) const;
+        bool   runsSuite(const char* suite) const;
+        bool   runsPrimitive(const std::string& primitive) const;
+    };
+
+    bool parseLatencyOptions(int argc, char** argv, LatencyOptions& out, std::ostream& err);
+    void printLatencyUsage(std::ostream& out);
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief One CSV row of ConcurrentDXLatency.
+
+        latency is measured from when each operation was scheduled to start, which is what a caller
+        of a fixed-rate service sees. service is measured from when the operation actually started,
+        which is what a closed-loop benchmark would report; it leaves out the time operations spent
+        stuck behind slow ones (coordinated omission), so it's only there for comparison.
+    */
+    struct LatencyResult
+    {
+        LatencyResult();
+
+        std::string         suite;
+        std::string         primitive;
+        size_t              threads;
+        size_t              producers;
+        size_t              consumers;
+        unsigned            readPercent;
+        uint64_t            targetRate;
+        uint64_t            issued;
+        double              seconds;
+        LatencyHistogram    latency;
+        LatencyHistogram    service;
+    };
+
+    void writeLatencyCsvHeader(std::ostream& out);
+    void writeLatencyCsvRow(std::ostream& out, const LatencyResult& result);
+
+    /*! \brief Open-loop schedule: the n-th operation of a thread is due at start + n * interval,
+        no matter how long the previous ones took
+    */
+    class Schedule
+    {
+    public:
+        /*! \param[in] rate Operations per second for this thread
+        */
+        explicit Schedule(uint64_t rate);
+
+        /*! \brief Waits until the next operation is due and returns when it was due. Returns
+            immediately if we're already late.
+        */
+        uint64_t next();
+        uint64_t start() const;
+
+    private:
+        uint64_t    m_start;
+        double      m_interval;
+        uint64_t    m_issued;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    void runQueueLatency(const LatencyOptions& options, std::ostream& out);
+    void runLockLatency(const LatencyOptions& options, std::ostream& out);
+
+}
+}
\ No newline at end of file
@@ -0,0 +1,297 @@
+
+#include "Latency.h"
+#include "Harness.h"
+#include "Primitives.h"
+
+#include "Containers/ConcurrentQueue.h"
+#include "Containers/ConcurrentStream.h"
+#include "Mutex/SpinMutex.h"
+#include "Mutex/SpinRWMutex.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <utility>
+
+namespace DX
+{
+namespace Bench
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    namespace
+    {
+        // What travels through the queues: when it was due, when it was really pushed
+        struct Stamp
+        {
+            uint64_t    due;
+            uint64_t    sent;
+            bool        measured;
+        };
+
+        // Per-thread histograms, merged once everybody has stopped
+        struct Recorders
+        {
+            explicit Recorders(size_t threads) : latency(threads), service(threads) {}
+
+            void mergeInto(LatencyHistogram& mergedLatency, LatencyHistogram& mergedService) const
+            {
+                for(size_t i = 0; i < latency.size(); ++i)
+                {
+                    mergedLatency.merge(latency[i]);
+                    mergedService.merge(service[i]);
+                }
+            }
+
+            std::vector<LatencyHistogram> latency;
+            std::vector<LatencyHistogram> service;
+        };
+
+        uint64_t threadRate(const LatencyOptions& options, size_t threads)
+        {
+            return std::max<uint64_t>(1, options.rate / threads);
+        }
+
+        uint64_t warmupNanoseconds(const LatencyOptions& options)
+        {
+            return static_cast<uint64_t>(options.warmupMs) * 1000000;
+        }
+
+        template <typename QueueT>
+        struct QueueLatencyBody
+        {
+            QueueT&                 queue;
+            const LatencyOptions&   options;
+            size_t                  producers;
+            std::atomic<size_t>&    producersDone;
+            Recorders&              recorders;
+
+            uint64_t operator()(size_t threadIndex, const std::atomic<bool>& stop)
+            {
+                if(options.pin)
+                    pinCurrentThread(options.cpuFor(threadIndex));
+
+                if(threadIndex < producers)
+                {
+                    Schedule schedule(threadRate(options, producers));
+                    const uint64_t measureFrom = schedule.start() + warmupNanoseconds(options);
+                    uint64_t issued = 0;
+                    while(!stop.load(std::memory_order_relaxed))
+                    {
+                        Stamp stamp;
+                        stamp.due = schedule.next();
+                        stamp.measured = stamp.due >= measureFrom;
+                        stamp.sent = nowNanoseconds();
+                        queue.push(std::move(stamp));
+                        ++issued;
+                    }
+                    ++producersDone;
+                    return issued;
+                }
+
+                LatencyHistogram& latency = recorders.latency[threadIndex];
+                LatencyHistogram& service = recorders.service[threadIndex];
+                uint64_t received = 0;
+                size_t misses = 0;
+                Stamp stamp;
+                for(;;)
+                {
+                    if(queue.pop(stamp))
+                    {
+                        const uint64_t now = nowNanoseconds();
+                        if(stamp.measured)
+                        {
+                            latency.record(now - stamp.due);
+                            service.record(now - stamp.sent);
+                        }
+                        ++received;
+                        misses = 0;
+                        continue;
+                    }
+                    // Drain whatever the producers left behind before stopping
+                    if(producersDone.load() == producers && queue.isEmpty())
+                        break;
+                    // Poll hard, but let a producer sharing our core get a word in now and then
+                    if(++misses % 64 == 0)
+                        std::this_thread::yield();
+                }
+                return received;
+            }
+        };
+
+        template <typename QueueT>
+        void measureQueue(const LatencyOptions& options, const char* primitive, size_t producers, size_t consumers,
+            std::ostream& out)
+        {
+            if(!options.runsPrimitive(primitive))
+                return;
+
+            QueueT queue;
+            std::atomic<size_t> producersDone(0);
+            Recorders recorders(producers + consumers);
+            QueueLatencyBody<QueueT> body = { queue, options, producers, producersDone, recorders };
+
+            Result timed;
+            runTimed(producers + consumers, options.durationMs, body, timed);
+
+            LatencyResult result;
+            result.suite = "queue";
+            result.primitive = primitive;
+            result.threads = producers + consumers;
+            result.producers = producers;
+            result.consumers = consumers;
+            result.targetRate = threadRate(options, producers) * producers;
+            for(size_t i = 0; i < producers; ++i)
+                result.issued += timed.threadOps[i];
+            result.seconds = timed.seconds;
+            recorders.mergeInto(result.latency, result.service);
+            writeLatencyCsvRow(out, result);
+        }
+
+        // Only reader-writer locks have a shared side to take
+        template <typename LockT, bool ReaderWriter>
+        struct Acquire
+        {
+            static void lock(LockT& mutex, bool) { Exclusive<LockT>::lock(mutex); }
+            static void unlock(LockT& mutex, bool) { Exclusive<LockT>::unlock(mutex); }
+        };
+
+        template <typename LockT>
+        struct Acquire<LockT, true>
+        {
+            static void lock(LockT& mutex, bool isReader)
+            {
+                if(isReader)
+                    Shared<LockT>::lock(mutex);
+                else
+                    Exclusive<LockT>::lock(mutex);
+            }
+
+            static void unlock(LockT& mutex, bool isReader)
+            {
+                if(isReader)
+                    Shared<LockT>::unlock(mutex);
+                else
+                    Exclusive<LockT>::unlock(mutex);
+            }
+        };
+
+        template <typename LockT, bool ReaderWriter>
+        struct LockLatencyBody
+        {
+            LockT&                  mutex;
+            const LatencyOptions&   options;
+            size_t                  threads;
+            unsigned                readPercent;
+            Recorders&              writers;
+            Recorders&              readers;
+
+            uint64_t operator()(size_t threadIndex, const std::atomic<bool>& stop)
+            {
+                if(options.pin)
+                    pinCurrentThread(options.cpuFor(threadIndex));
+
+                Schedule schedule(threadRate(options, threads));
+                const uint64_t measureFrom = schedule.start() + warmupNanoseconds(options);
+                uint64_t random = 0x9E3779B97F4A7C15ULL * (threadIndex + 1);
+                uint64_t issued = 0;
+                while(!stop.load(std::memory_order_relaxed))
+                {
+                    const uint64_t due = schedule.next();
+                    const bool isReader = readPercent != 0 && xorshift(random) % 100 < readPercent;
+                    const uint64_t attempt = nowNanoseconds();
+                    Acquire<LockT, ReaderWriter>::lock(mutex, isReader);
+                    const uint64_t acquired = nowNanoseconds();
+                    spinWork(options.criticalWork);
+                    Acquire<LockT, ReaderWriter>::unlock(mutex, isReader);
+
+                    if(due >= measureFrom)
+                    {
+                        Recorders& recorders = isReader ? readers : writers;
+                        recorders.latency[threadIndex].record(acquired - due);
+                        recorders.service[threadIndex].record(acquired - attempt);
+                    }
+                    ++issued;
+                }
+                return issued;
+            }
+        };
+
+        /*
+            Exclusive locks get one row. Reader-writer locks get a "/read" and a "/write" row, since
+            readers and writers see very different tails.
+        */
+        template <typename LockT, bool ReaderWriter>
+        void measureLock(const LatencyOptions& options, const char* primitive, size_t threads, std::ostream& out)
+        {
+            if(!options.runsPrimitive(primitive))
+                return;
+
+            const unsigned readPercent = ReaderWriter ? options.readPercent : 0;
+            LockT mutex;
+            Recorders writers(threads);
+            Recorders readers(threads);
+            LockLatencyBody<LockT, ReaderWriter> body = { mutex, options, threads, readPercent, writers, readers };
+
+            Result timed;
+            runTimed(threads, options.durationMs, body, timed);
+
+            LatencyResult result;
+            result.suite = "lock";
+            result.threads = threads;
+            result.readPercent = readPercent;
+            result.targetRate = threadRate(options, threads) * threads;
+            result.issued = timed.ops();
+            result.seconds = timed.seconds;
+
+            if(!ReaderWriter)
+            {
+                result.primitive = primitive;
+                writers.mergeInto(result.latency, result.service);
+                writeLatencyCsvRow(out, result);
+                return;
+            }
+
+            LatencyResult reads = result;
+            reads.primitive = std::string(primitive) + "/read";
+            readers.mergeInto(reads.latency, reads.service);
+            writeLatencyCsvRow(out, reads);
+
+            result.primitive = std::string(primitive) + "/write";
+            writers.mergeInto(result.latency, result.service);
+            writeLatencyCsvRow(out, result);
+        }
+    }
+
+    void runQueueLatency(const LatencyOptions& options, std::ostream& out)
+    {
+        if(!options.runsSuite("queue"))
+            return;
+
+        // ConcurrentStream only supports one of each
+        measureQueue<ConcurrentStream<Stamp>>(options, "ConcurrentStream", 1, 1, out);
+        measureQueue<ConcurrentQueue<Stamp>>(options, "ConcurrentQueue", options.producers, options.consumers, out);
+        measureQueue<LockedStdQueue<Stamp>>(options, "std::queue+std::mutex", options.producers, options.consumers, out);
+    }
+
+    void runLockLatency(const LatencyOptions& options, std::ostream& out)
+    {
+        if(!options.runsSuite("lock"))
+            return;
+
+        for(size_t i = 0; i < options.threads.size(); ++i)
+        {
+            const size_t threads = options.threads[i];
+            measureLock<SpinMutex, false>(options, "SpinMutex", threads, out);
+            measureLock<std::mutex, false>(options, "std::mutex", threads, out);
+            measureLock<SpinRWMutex, true>(options, "SpinRWMutex", threads, out);
+            measureLock<std::shared_mutex, true>(options, "std::shared_mutex", threads, out);
+        }
+    }
+
+}
+}
\ No newline at end of file
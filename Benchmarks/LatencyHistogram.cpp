@@ -0,0 +1,134 @@
+
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+namespace DX
+{
+namespace Bench
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    namespace
+    {
+        const size_t   SubBucketBits = LATENCY_SUB_BUCKET_BITS;
+        const uint64_t SubBucketCount = uint64_t(1) << SubBucketBits;
+        const uint64_t HalfSubBucketCount = SubBucketCount / 2;
+        // Exact buckets, then half a sub-bucket range for every magnitude above them
+        const size_t   BucketCount = static_cast<size_t>(SubBucketCount + (64 - SubBucketBits) * HalfSubBucketCount);
+
+        // Number of bits needed to hold value, value must not be 0
+        size_t bitLength(uint64_t value)
+        {
+            #ifdef _MSC_VER
+                unsigned long index = 0;
+                _BitScanReverse64(&index, value);
+                return index + 1;
+            #else
+                return 64 - __builtin_clzll(value);
+            #endif
+        }
+    }
+
+    LatencyHistogram::LatencyHistogram() : m_counts(BucketCount, 0)
+    {
+        reset();
+    }
+
+    size_t LatencyHistogram::bucketOf(uint64_t value)
+    {
+        if(value < SubBucketCount)
+            return static_cast<size_t>(value);
+        // Keep the top SubBucketBits bits, the leading one is implied by the magnitude
+        const size_t magnitude = bitLength(value) - SubBucketBits;
+        const uint64_t top = value >> magnitude;
+        return static_cast<size_t>(SubBucketCount + (magnitude - 1) * HalfSubBucketCount + (top - HalfSubBucketCount));
+    }
+
+    uint64_t LatencyHistogram::highestInBucket(size_t bucket)
+    {
+        if(bucket < SubBucketCount)
+            return bucket;
+        const uint64_t offset = bucket - SubBucketCount;
+        const size_t magnitude = static_cast<size_t>(offset / HalfSubBucketCount) + 1;
+        const uint64_t top = offset % HalfSubBucketCount + HalfSubBucketCount;
+        if(magnitude + SubBucketBits >= 64 && top == SubBucketCount - 1)
+            return std::numeric_limits<uint64_t>::max();
+        return ((top + 1) << magnitude) - 1;
+    }
+
+    void LatencyHistogram::record(uint64_t value)
+    {
+        ++m_counts[bucketOf(value)];
+        ++m_count;
+        m_min = std::min(m_min, value);
+        m_max = std::max(m_max, value);
+        m_sum += static_cast<double>(value);
+    }
+
+    void LatencyHistogram::merge(const LatencyHistogram& other)
+    {
+        for(size_t i = 0; i < BucketCount; ++i)
+            m_counts[i] += other.m_counts[i];
+        m_count += other.m_count;
+        m_min = std::min(m_min, other.m_min);
+        m_max = std::max(m_max, other.m_max);
+        m_sum += other.m_sum;
+    }
+
+    void LatencyHistogram::reset()
+    {
+        std::fill(m_counts.begin(), m_counts.end(), 0);
+        m_count = 0;
+        m_min = std::numeric_limits<uint64_t>::max();
+        m_max = 0;
+        m_sum = 0.0;
+    }
+
+    uint64_t LatencyHistogram::count() const
+    {
+        return m_count;
+    }
+
+    uint64_t LatencyHistogram::min() const
+    {
+        return m_count == 0 ? 0 : m_min;
+    }
+
+    uint64_t LatencyHistogram::max() const
+    {
+        return m_max;
+    }
+
+    double LatencyHistogram::mean() const
+    {
+        return m_count == 0 ? 0.0 : m_sum / static_cast<double>(m_count);
+    }
+
+    uint64_t LatencyHistogram::percentile(double fraction) const
+    {
+        if(m_count == 0)
+            return 0;
+
+        const double clamped = std::min(1.0, std::max(0.0, fraction));
+        const uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(clamped * static_cast<double>(m_count))));
+        uint64_t seen = 0;
+        for(size_t i = 0; i < BucketCount; ++i)
+        {
+            seen += m_counts[i];
+            if(seen >= target)
+                return std::min(highestInBucket(i), m_max);
+        }
+        return m_max;
+    }
+
+}
+}
\ No newline at end of file
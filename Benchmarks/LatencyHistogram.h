@@ -0,0 +1,57 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace DX
+{
+namespace Bench
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    // Linear sub-buckets per power of two are 2^(bits - 1), so 7 bits keeps every value within 1/64
+    #ifndef LATENCY_SUB_BUCKET_BITS
+        #define LATENCY_SUB_BUCKET_BITS 7
+    #endif
+
+    /*! \brief LatencyHistogram is an HdrHistogram-style log-linear histogram of nanosecond values.
+        Values below 2^LATENCY_SUB_BUCKET_BITS are counted exactly; above that every power of two is
+        split into linear sub-buckets, so the relative error stays bounded all the way up to the
+        largest 64 bit value while the histogram stays a few tens of kilobytes.
+
+        Not thread safe: give every thread its own and merge() them afterwards.
+    */
+    class LatencyHistogram
+    {
+    public:
+        LatencyHistogram();
+
+        void        record(uint64_t value);
+        void        merge(const LatencyHistogram& other);
+        void        reset();
+
+        uint64_t    count() const;
+        uint64_t    min() const;
+        uint64_t    max() const;
+        double      mean() const;
+        /*! \brief Smallest recorded value that at least fraction of all values are at or below,
+            to within the precision of its bucket. 0 when empty.
+        */
+        uint64_t    percentile(double fraction) const;
+
+    private:
+        static size_t   bucketOf(uint64_t value);
+        static uint64_t highestInBucket(size_t bucket);
+
+        std::vector<uint64_t>   m_counts;
+        uint64_t                m_count;
+        uint64_t                m_min;
+        uint64_t                m_max;
+        double                  m_sum;
+    };
+
+}
+}
\ No newline at end of file
@@ -0,0 +1,16 @@
+
+#include "Latency.h"
+
+#include <iostream>
+
+int main(int argc, char** argv)
+{
+    DX::Bench::LatencyOptions options;
+    if(!DX::Bench::parseLatencyOptions(argc, argv, options, std::cerr))
+        return 1;
+
+    DX::Bench::writeLatencyCsvHeader(std::cout);
+    DX::Bench::runQueueLatency(options, std::cout);
+    DX::Bench::runLockLatency(options, std::cout);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,223 @@
+
+#include "Harness.h"
+#include "Primitives.h"
+
+#include "CacheLine.h"
+#include "Mutex/CohortMutex.h"
+#include "Mutex/FlatCombiner.h"
+#include "Mutex/ParkingMutex.h"
+#include "Mutex/SpinMutex.h"
+#include "Mutex/SpinRecursiveMutex.h"
+#include "Mutex/SpinRWMutex.h"
+#include "Mutex/SpinYieldMutex.h"
+
+#include <mutex>
+#include <shared_mutex>
+
+namespace DX
+{
+namespace Bench
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    namespace
+    {
+        // What the critical sections protect, on its own cache line so only the lock moves it around
+        struct DX_CACHE_ALIGNED SharedData
+        {
+            uint64_t        value;
+        };
+
+        template <typename LockT>
+        struct ExclusiveBody
+        {
+            LockT&          mutex;
+            SharedData&     data;
+            const Options&  options;
+
+            uint64_t operator()(size_t, const std::atomic<bool>& stop)
+            {
+                uint64_t ops = 0;
+                while(!stop.load(std::memory_order_relaxed))
+                {
+                    Exclusive<LockT>::lock(mutex);
+                    ++data.value;
+                    spinWork(options.criticalWork);
+                    Exclusive<LockT>::unlock(mutex);
+                    spinWork(options.outsideWork);
+                    ++ops;
+                }
+                return ops;
+            }
+        };
+
+        template <typename LockT>
+        struct ReadMixBody
+        {
+            LockT&          mutex;
+            SharedData&     data;
+            const Options&  options;
+            unsigned        readPercent;
+
+            uint64_t operator()(size_t threadIndex, const std::atomic<bool>& stop)
+            {
+                uint64_t random = 0x9E3779B97F4A7C15ULL * (threadIndex + 1);
+                uint64_t ops = 0;
+                uint64_t seen = 0;
+                while(!stop.load(std::memory_order_relaxed))
+                {
+                    if(xorshift(random) % 100 < readPercent)
+                    {
+                        Shared<LockT>::lock(mutex);
+                        seen += data.value;
+                        spinWork(options.criticalWork);
+                        Shared<LockT>::unlock(mutex);
+                    }
+                    else
+                    {
+                        Exclusive<LockT>::lock(mutex);
+                        ++data.value;
+                        spinWork(options.criticalWork);
+                        Exclusive<LockT>::unlock(mutex);
+                    }
+                    spinWork(options.outsideWork);
+                    ++ops;
+                }
+                // Keep the reads from being optimized out
+                volatile uint64_t sink = seen;
+                (void)sink;
+                return ops;
+            }
+        };
+
+        struct CombinerBody
+        {
+            FlatCombiner<uint64_t>& combiner;
+            const Options&          options;
+
+            uint64_t operator()(size_t, const std::atomic<bool>& stop)
+            {
+                const size_t criticalWork = options.criticalWork;
+                uint64_t ops = 0;
+                while(!stop.load(std::memory_order_relaxed))
+                {
+                    combiner.execute([criticalWork](uint64_t& value)
+                    {
+                        ++value;
+                        spinWork(criticalWork);
+                    });
+                    spinWork(options.outsideWork);
+                    ++ops;
+                }
+                return ops;
+            }
+        };
+
+        template <typename Body>
+        void sweep(const Options& options, const char* suite, const char* primitive, unsigned readPercent,
+            Body& body, std::ostream& out)
+        {
+            for(size_t i = 0; i < options.threads.size(); ++i)
+            {
+                Result result;
+                result.suite = suite;
+                result.primitive = primitive;
+                result.readPercent = readPercent;
+                runTimed(options.threads[i], options.durationMs, body, result);
+                writeCsvRow(out, result);
+            }
+        }
+
+        template <typename LockT>
+        void benchmarkExclusive(const Options& options, const char* primitive, LockT& mutex, std::ostream& out)
+        {
+            if(!runsPrimitive(options, primitive))
+                return;
+            SharedData data = SharedData();
+            ExclusiveBody<LockT> body = { mutex, data, options };
+            sweep(options, "mutex", primitive, 0, body, out);
+        }
+
+        template <typename LockT>
+        void benchmarkReadMix(const Options& options, const char* primitive, LockT& mutex, std::ostream& out)
+        {
+            if(!runsPrimitive(options, primitive))
+                return;
+            for(size_t i = 0; i < options.readPercents.size(); ++i)
+            {
+                SharedData data = SharedData();
+                ReadMixBody<LockT> body = { mutex, data, options, options.readPercents[i] };
+                sweep(options, "rwmutex", primitive, options.readPercents[i], body, out);
+            }
+        }
+    }
+
+    void runMutexBenchmarks(const Options& options, std::ostream& out)
+    {
+        if(runsSuite(options, "mutex"))
+        {
+            {
+                SpinMutex mutex;
+                benchmarkExclusive(options, "SpinMutex", mutex, out);
+            }
+            {
+                CompactSpinMutex mutex;
+                benchmarkExclusive(options, "CompactSpinMutex", mutex, out);
+            }
+            {
+                ParkingMutex mutex;
+                benchmarkExclusive(options, "ParkingMutex", mutex, out);
+            }
+            {
+                SpinYieldMutex mutex;
+                benchmarkExclusive(options, "SpinYieldMutex", mutex, out);
+            }
+            {
+                SpinRecursiveMutex mutex;
+                benchmarkExclusive(options, "SpinRecursiveMutex", mutex, out);
+            }
+            {
+                SpinRWMutex mutex;
+                benchmarkExclusive(options, "SpinRWMutex", mutex, out);
+            }
+            {
+                CohortMutex mutex;
+                benchmarkExclusive(options, "CohortMutex", mutex, out);
+            }
+            if(runsPrimitive(options, "FlatCombiner"))
+            {
+                FlatCombiner<uint64_t> combiner;
+                CombinerBody body = { combiner, options };
+                sweep(options, "mutex", "FlatCombiner", 0, body, out);
+            }
+            {
+                std::mutex mutex;
+                benchmarkExclusive(options, "std::mutex", mutex, out);
+            }
+        }
+
+        if(runsSuite(options, "rwmutex"))
+        {
+            {
+                SpinRWMutex mutex(SpinRWMutex::PreferReaders);
+                benchmarkReadMix(options, "SpinRWMutex/PreferReaders", mutex, out);
+            }
+            {
+                SpinRWMutex mutex(SpinRWMutex::PreferWriters);
+                benchmarkReadMix(options, "SpinRWMutex/PreferWriters", mutex, out);
+            }
+            {
+                SpinRWMutex mutex(SpinRWMutex::PhaseFair);
+                benchmarkReadMix(options, "SpinRWMutex/PhaseFair", mutex, out);
+            }
+            {
+                std::shared_mutex mutex;
+                benchmarkReadMix(options, "std::shared_mutex", mutex, out);
+            }
+        }
+    }
+
+}
+}
\ No newline at end of file
@@ -0,0 +1,103 @@
+
+#pragma once
+
+#include "Mutex/SpinRWMutex.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <utility>
+
+namespace DX
+{
+namespace Bench
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief The queue everybody writes first: a std::queue behind a std::mutex. Both benchmark
+        executables compare the library's queues against it.
+    */
+    template <typename T>
+    class LockedStdQueue
+    {
+    public:
+        void push(T&& in)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queue.push(std::move(in));
+        }
+
+        bool pop(T& out)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(m_queue.empty())
+                return false;
+            out = std::move(m_queue.front());
+            m_queue.pop();
+            return true;
+        }
+
+        size_t size() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_queue.size();
+        }
+
+        bool isEmpty() const
+        {
+            return size() == 0;
+        }
+
+    private:
+        mutable std::mutex  m_mutex;
+        std::queue<T>       m_queue;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief Exclusive<LockT> and Shared<LockT> give the library's locks and the std ones the
+        same interface, so one benchmark body covers both
+    */
+    template <typename LockT>
+    struct Exclusive
+    {
+        static void lock(LockT& mutex) { mutex.lock(); }
+        static void unlock(LockT& mutex) { mutex.unlock(); }
+    };
+
+    template <>
+    struct Exclusive<SpinRWMutex>
+    {
+        static void lock(SpinRWMutex& mutex) { mutex.lock(true); }
+        static void unlock(SpinRWMutex& mutex) { mutex.unlock(true); }
+    };
+
+    template <typename LockT>
+    struct Shared
+    {
+        static void lock(LockT& mutex) { mutex.lock_shared(); }
+        static void unlock(LockT& mutex) { mutex.unlock_shared(); }
+    };
+
+    template <>
+    struct Shared<SpinRWMutex>
+    {
+        static void lock(SpinRWMutex& mutex) { mutex.lock(false); }
+        static void unlock(SpinRWMutex& mutex) { mutex.unlock(false); }
+    };
+
+    /*! \brief Cheap per-thread random numbers, e.g. for picking reads vs writes. state must not be 0.
+    */
+    inline uint64_t xorshift(uint64_t& state)
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+
+}
+}
\ No newline at end of file
@@ -0,0 +1,117 @@
+
+#include "Harness.h"
+#include "Primitives.h"
+
+#include "Containers/ConcurrentQueue.h"
+#include "Containers/ConcurrentStream.h"
+
+#include <thread>
+#include <utility>
+
+namespace DX
+{
+namespace Bench
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    namespace
+    {
+        template <typename QueueT>
+        struct QueueBody
+        {
+            QueueT&         queue;
+            const Options&  options;
+            size_t          producers;
+
+            uint64_t operator()(size_t threadIndex, const std::atomic<bool>& stop)
+            {
+                uint64_t ops = 0;
+                if(threadIndex < producers)
+                {
+                    uint64_t value = 0;
+                    while(!stop.load(std::memory_order_relaxed))
+                    {
+                        // Keep an unbounded queue from eating all the memory when consumers fall behind
+                        if(queue.size() >= options.queueBound)
+                        {
+                            std::this_thread::yield();
+                            continue;
+                        }
+                        queue.push(value++);
+                        spinWork(options.outsideWork);
+                        ++ops;
+                    }
+                }
+                else
+                {
+                    uint64_t value = 0;
+                    while(!stop.load(std::memory_order_relaxed))
+                    {
+                        if(!queue.pop(value))
+                        {
+                            std::this_thread::yield();
+                            continue;
+                        }
+                        spinWork(options.outsideWork);
+                        ++ops;
+                    }
+                }
+                return ops;
+            }
+        };
+
+        template <typename QueueT>
+        void benchmarkQueue(const Options& options, const char* primitive, size_t producers, size_t consumers,
+            std::ostream& out)
+        {
+            QueueT queue;
+            QueueBody<QueueT> body = { queue, options, producers };
+            Result result;
+            result.suite = "queue";
+            result.primitive = primitive;
+            result.producers = producers;
+            result.consumers = consumers;
+            runTimed(producers + consumers, options.durationMs, body, result);
+            writeCsvRow(out, result);
+        }
+    }
+
+    void runQueueBenchmarks(const Options& options, std::ostream& out)
+    {
+        if(!runsSuite(options, "queue"))
+            return;
+
+        // Single producer, single consumer is the only split ConcurrentStream supports
+        if(runsPrimitive(options, "ConcurrentStream"))
+            benchmarkQueue<ConcurrentStream<uint64_t>>(options, "ConcurrentStream", 1, 1, out);
+
+        for(size_t i = 0; i < options.threads.size(); ++i)
+        {
+            const size_t threads = options.threads[i];
+            if(threads < 2)
+                continue;
+
+            // Balanced, fan-in and fan-out
+            std::vector<std::pair<size_t, size_t>> splits;
+            splits.push_back(std::make_pair(threads / 2, threads - threads / 2));
+            if(threads - 1 != threads / 2)
+                splits.push_back(std::make_pair(threads - 1, size_t(1)));
+            if(threads - 1 != threads - threads / 2)
+                splits.push_back(std::make_pair(size_t(1), threads - 1));
+
+            for(size_t j = 0; j < splits.size(); ++j)
+            {
+                const size_t producers = splits[j].first;
+                const size_t consumers = splits[j].second;
+                if(runsPrimitive(options, "ConcurrentQueue"))
+                    benchmarkQueue<ConcurrentQueue<uint64_t>>(options, "ConcurrentQueue", producers, consumers, out);
+                if(runsPrimitive(options, "std::queue+std::mutex"))
+                    benchmarkQueue<LockedStdQueue<uint64_t>>(options, "std::queue+std::mutex", producers, consumers, out);
+            }
+        }
+    }
+
+}
+}
\ No newline at end of file
@@ -6,11 +6,70 @@
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma once
 
+#include <cstddef>
+#include <new>
+
 /*
     L1, L2, and L3 cache lines on i7s are 64 Bytes. CACHE_LINE_SIZE is used to pad classes that use
     multiple internal atomics / other variables to reduce the likelihood of cache contention and 
     false sharing
+
+    Intel's adjacent-line prefetcher pulls cache lines in pairs, so two "padded" atomics on
+    neighbouring lines can still ping-pong. Define DX_CACHE_LINE_128 to pad to 128 bytes instead.
+    Otherwise std::hardware_destructive_interference_size is used where the standard library has it.
+    GCC is left out on purpose: its value changes with -mtune and it warns about using it in headers.
 */
 #ifndef CACHE_LINE_SIZE
-    #define CACHE_LINE_SIZE 64U
-#endif
\ No newline at end of file
+    #if defined DX_CACHE_LINE_128
+        #define CACHE_LINE_SIZE 128U
+    #elif defined __cpp_lib_hardware_interference_size && !defined __GNUC__
+        #define CACHE_LINE_SIZE std::hardware_destructive_interference_size
+    #else
+        #define CACHE_LINE_SIZE 64U
+    #endif
+#endif
+
+/*
+    DX_CACHE_ALIGNED starts a class or member on its own cache line. Because sizeof is always a
+    multiple of the alignment, an aligned class also ends on a line boundary: nothing else can share
+    its lines, without the extra line a manual pad array costs when the size is already a multiple.
+
+    Heap allocations only honor it with C++17 aligned new, or with -faligned-new on GCC and Clang
+    (the CMake build turns that on).
+*/
+#if defined _MSC_VER && _MSC_VER < 1900
+    #define DX_CACHE_ALIGNED __declspec(align(CACHE_LINE_SIZE))
+#else
+    #define DX_CACHE_ALIGNED alignas(CACHE_LINE_SIZE)
+#endif
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief CachePadded wraps a value so that it has its cache line(s) to itself. Use it for
+        contended members and for array elements that different threads write to.
+
+        \code
+        CachePadded<std::atomic<size_t>> counters[MAX_THREADS];
+        ...
+        counters[thread]->fetch_add(1, std::memory_order_relaxed);
+        \endcode
+    */
+    template <typename T>
+    struct DX_CACHE_ALIGNED CachePadded
+    {
+        CachePadded() : value() {}
+        template <typename U>
+        explicit CachePadded(const U& init) : value(init) {}
+
+        T&          operator*()         { return value; }
+        const T&    operator*() const   { return value; }
+        T*          operator->()        { return &value; }
+        const T*    operator->() const  { return &value; }
+
+        T value;
+    };
+
+}
\ No newline at end of file
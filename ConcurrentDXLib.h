@@ -7,15 +7,49 @@
 #pragma once
 
 #include "CacheLine.h"
+#include "Mutex/AsyncMutex.h"
 #include "Mutex/Barrier.h"
+#include "Mutex/BlockingBarrier.h"
+#include "Mutex/CohortMutex.h"
+#include "Mutex/CombiningTreeBarrier.h"
 #include "Mutex/CyclicSpinBarrier.h"
+#include "Mutex/Event.h"
+#include "Mutex/EventCount.h"
+#include "Mutex/FlatCombiner.h"
+#include "Mutex/Futex.h"
+#include "Mutex/Latch.h"
+#include "Mutex/LockProfiler.h"
 #include "Mutex/Mutex.h"
+#include "Mutex/ParkingLot.h"
+#include "Mutex/ParkingMutex.h"
+#include "Mutex/Semaphore.h"
+#include "Mutex/SenseReversingBarrier.h"
 #include "Mutex/SpinBarrier.h"
 #include "Mutex/SpinMutex.h"
 #include "Mutex/SpinRecursiveMutex.h"
 #include "Mutex/SpinRWMutex.h"
 #include "Mutex/SpinYieldMutex.h"
 #include "Mutex/StdLocks.h"
+#include "Mutex/StripedLock.h"
 #include "Containers/AbstractQueue.h"
+#include "Containers/ByteStream.h"
+#include "Containers/Channel.h"
 #include "Containers/ConcurrentQueue.h"
+#include "Containers/ConcurrentSkipListMap.h"
+#include "Containers/ConcurrentSlab.h"
 #include "Containers/ConcurrentStream.h"
+#include "Containers/QueueReadiness.h"
+#include "Containers/QueueTelemetry.h"
+#include "Containers/ShardedCounter.h"
+#include "Containers/SharedMemory.h"
+#include "Containers/SharedQueue.h"
+#include "Containers/SharedStream.h"
+#include "Containers/SpillQueue.h"
+#include "Containers/TimingWheel.h"
+#include "Threading/Coroutine.h"
+#include "Threading/Epoch.h"
+#include "Threading/Executor.h"
+#include "Threading/PerCpu.h"
+#include "Threading/ThreadId.h"
+#include "Threading/Topology.h"
+#include "Threading/WorkerTeam.h"
\ No newline at end of file
@@ -7,6 +7,10 @@
 #pragma once
 
 #include "../CacheLine.h"
+#include "QueueReadiness.h"
+#ifdef DX_QUEUE_TELEMETRY
+    #include "QueueTelemetry.h"
+#endif
 
 #include <atomic>
 
@@ -17,7 +21,7 @@ namespace DX
     ////////////////////////////////////////////////////////////////////////////////////////////////
     
     template <typename T>
-    struct Node
+    struct DX_CACHE_ALIGNED Node
     {
         Node();
         Node(T* data);
@@ -25,7 +29,10 @@ namespace DX
 
         T* data;
         std::atomic<Node*> next;
-        volatile char pad_[CACHE_LINE_SIZE - ((sizeof(T*) + sizeof(std::atomic<Node*>)) % CACHE_LINE_SIZE)];
+    #ifdef DX_QUEUE_TELEMETRY
+        // When a sampled push happened, 0 if this node wasn't sampled
+        uint64_t pushedAt;
+    #endif
 
     private:
         Node(const Node&);
@@ -36,7 +43,7 @@ namespace DX
     ////////////////////////////////////////////////////////////////////////////////////////////////
 
     template <typename T>
-    class Queue
+    class DX_CACHE_ALIGNED Queue
     {
     public:
         Queue();
@@ -54,13 +61,33 @@ namespace DX
         bool    operator>>(T&);
         Queue&  operator<<(const T&);
 
+        /*! \brief A file descriptor that polls readable once the queue has items, for consumers
+            that sleep in an event loop. Created on the first call, returns -1 where unsupported.
+            See QueueReadiness for the protocol.
+        */
+        int     readinessFd();
+        /*! \brief Re-arms the readiness fd, call it after the fd polled readable and before
+            popping until the queue is empty
+        */
+        void    clearReadiness();
+
+    #ifdef DX_QUEUE_TELEMETRY
+        /*! \brief Pushes, pops, high-water mark and sampled sojourn times so far. Push and pop
+            rates are over the interval since the previous call.
+        */
+        QueueTelemetrySnapshot  telemetry() const;
+        void                    resetTelemetry();
+    #endif
+
     protected:
+        // Consumers own the head, producers the tail, and both touch the size
         Node<T>*            m_start;
-        volatile char       pad_0[CACHE_LINE_SIZE - (sizeof(Node<T>*) % CACHE_LINE_SIZE)];
-        Node<T>*            m_end;
-        volatile char       pad_1[CACHE_LINE_SIZE - (sizeof(Node<T>*) % CACHE_LINE_SIZE)];
-        std::atomic<size_t> m_size;
-        volatile char       pad_2[CACHE_LINE_SIZE - (sizeof(std::atomic<size_t>) % CACHE_LINE_SIZE)];
+        DX_CACHE_ALIGNED Node<T>* m_end;
+        DX_CACHE_ALIGNED std::atomic<size_t> m_size;
+        QueueReadiness      m_readiness;
+    #ifdef DX_QUEUE_TELEMETRY
+        QueueTelemetry      m_telemetry;
+    #endif
     private:
         Queue(const Queue&);
         Queue(Queue&&);
@@ -71,13 +98,19 @@ namespace DX
     // impl
 
     template <typename T>
-    Node<T>::Node() : next(nullptr), data(nullptr)
+    Node<T>::Node() : data(nullptr), next(nullptr)
     {
+        #ifdef DX_QUEUE_TELEMETRY
+            pushedAt = 0;
+        #endif
     }
 
     template <typename T>
     Node<T>::Node(T* _data) : data(_data), next(nullptr)
     {
+        #ifdef DX_QUEUE_TELEMETRY
+            pushedAt = 0;
+        #endif
     }
 
     template <typename T>
@@ -111,6 +144,32 @@ namespace DX
         return m_size == 0;
     }
 
+    template <typename T>
+    int Queue<T>::readinessFd()
+    {
+        return m_readiness.fd();
+    }
+
+    template <typename T>
+    void Queue<T>::clearReadiness()
+    {
+        m_readiness.clear();
+    }
+
+    #ifdef DX_QUEUE_TELEMETRY
+        template <typename T>
+        QueueTelemetrySnapshot Queue<T>::telemetry() const
+        {
+            return m_telemetry.snapshot();
+        }
+
+        template <typename T>
+        void Queue<T>::resetTelemetry()
+        {
+            m_telemetry.reset();
+        }
+    #endif
+
     template<typename T>
     Queue<T>& Queue<T>::operator<<(const T& object)
     {
@@ -0,0 +1,163 @@
+
+#include "ByteStream.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    namespace
+    {
+        size_t roundUpToPowerOfTwo(size_t capacity)
+        {
+            size_t rounded = 64;
+            while(rounded < capacity)
+                rounded <<= 1;
+            return rounded;
+        }
+    }
+
+    ByteStream::ByteStream(size_t capacity) : m_buffer(new char[roundUpToPowerOfTwo(capacity)]), m_mask(roundUpToPowerOfTwo(capacity) - 1)
+    {
+        m_producer.tail.store(0, std::memory_order_relaxed);
+        m_producer.cachedHead = 0;
+        m_producer.reserved = 0;
+        m_consumer.head.store(0, std::memory_order_relaxed);
+        m_consumer.cachedTail = 0;
+        m_consumer.reading = 0;
+    }
+
+    ByteStream::~ByteStream()
+    {
+        delete[] m_buffer;
+    }
+
+    size_t ByteStream::recordSize(size_t size)
+    {
+        return HEADER_SIZE + ((size + 7) & ~size_t(7));
+    }
+
+    uint32_t& ByteStream::headerAt(uint64_t position) const
+    {
+        return *reinterpret_cast<uint32_t*>(m_buffer + (position & m_mask));
+    }
+
+    ByteSpan ByteStream::reserve(size_t size)
+    {
+        assert(size <= maxMessageSize());
+        const size_t needed = recordSize(size);
+        const size_t capacity = m_mask + 1;
+        uint64_t tail = m_producer.tail.load(std::memory_order_relaxed);
+        m_producer.reserved = 0;
+
+        // Doesn't fit before the end, pad out the lap and start over at the front
+        const size_t toEnd = capacity - static_cast<size_t>(tail & m_mask);
+        if(needed > toEnd)
+        {
+            if(capacity - (tail - m_producer.cachedHead) < toEnd)
+            {
+                m_producer.cachedHead = m_consumer.head.load(std::memory_order_acquire);
+                if(capacity - (tail - m_producer.cachedHead) < toEnd)
+                    return ByteSpan();
+            }
+            headerAt(tail) = PADDING;
+            tail += toEnd;
+            m_producer.tail.store(tail, std::memory_order_release);
+        }
+
+        if(capacity - (tail - m_producer.cachedHead) < needed)
+        {
+            m_producer.cachedHead = m_consumer.head.load(std::memory_order_acquire);
+            if(capacity - (tail - m_producer.cachedHead) < needed)
+                return ByteSpan();
+        }
+        m_producer.reserved = needed;
+        return ByteSpan(m_buffer + (tail & m_mask) + HEADER_SIZE, size);
+    }
+
+    bool ByteStream::commit(size_t size)
+    {
+        // Without a reservation the tail may be at the end of the lap, or the consumer's bytes
+        if(m_producer.reserved == 0)
+            return false;
+        assert(recordSize(size) <= m_producer.reserved); // Longer than reserved
+        if(recordSize(size) > m_producer.reserved)
+            return false;
+
+        const uint64_t tail = m_producer.tail.load(std::memory_order_relaxed);
+        headerAt(tail) = static_cast<uint32_t>(size);
+        m_producer.reserved = 0;
+        m_producer.tail.store(tail + recordSize(size), std::memory_order_release);
+        return true;
+    }
+
+    bool ByteStream::write(const void* data, size_t size)
+    {
+        ByteSpan span = reserve(size);
+        if(span.isEmpty())
+            return false;
+        memcpy(span.data, data, size);
+        return commit(size);
+    }
+
+    ByteSpan ByteStream::read()
+    {
+        uint64_t head = m_consumer.head.load(std::memory_order_relaxed);
+        for(;;)
+        {
+            if(head == m_consumer.cachedTail)
+            {
+                m_consumer.cachedTail = m_producer.tail.load(std::memory_order_acquire);
+                if(head == m_consumer.cachedTail)
+                    return ByteSpan();
+            }
+
+            const uint32_t size = headerAt(head);
+            if(size != PADDING)
+            {
+                m_consumer.reading = recordSize(size);
+                return ByteSpan(m_buffer + (head & m_mask) + HEADER_SIZE, size);
+            }
+
+            // Give the padding back right away, the producer may be waiting for the front
+            head += (m_mask + 1) - static_cast<size_t>(head & m_mask);
+            m_consumer.head.store(head, std::memory_order_release);
+        }
+    }
+
+    void ByteStream::release()
+    {
+        assert(m_consumer.reading != 0); // Nothing read
+        const uint64_t head = m_consumer.head.load(std::memory_order_relaxed);
+        m_consumer.head.store(head + m_consumer.reading, std::memory_order_release);
+        m_consumer.reading = 0;
+    }
+
+    bool ByteStream::isEmpty() const
+    {
+        return m_consumer.head.load(std::memory_order_acquire) == m_producer.tail.load(std::memory_order_acquire);
+    }
+
+    size_t ByteStream::usedBytes() const
+    {
+        const uint64_t head = m_consumer.head.load(std::memory_order_acquire);
+        const uint64_t tail = m_producer.tail.load(std::memory_order_acquire);
+        return tail > head ? static_cast<size_t>(tail - head) : 0;
+    }
+
+    size_t ByteStream::capacity() const
+    {
+        return m_mask + 1;
+    }
+
+    size_t ByteStream::maxMessageSize() const
+    {
+        const size_t largest = m_mask + 1 - HEADER_SIZE;
+        return largest < PADDING ? largest : PADDING - 1;
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,131 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Single-reader, single-writer stream of variable length messages, written and read in place
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "../CacheLine.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief A contiguous run of bytes inside a ByteStream, null data when there is none
+    */
+    struct ByteSpan
+    {
+        ByteSpan() : data(nullptr), size(0) {}
+        ByteSpan(char* _data, size_t _size) : data(_data), size(_size) {}
+
+        bool isEmpty() const { return data == nullptr; }
+
+        char*   data;
+        size_t  size;
+    };
+
+    /*! \brief ByteStream carries variable length messages from one producer thread to one consumer
+        thread through a fixed ring of bytes, without allocating or copying per message.
+
+        The producer reserve()s room for a message, serializes straight into the ring and
+        commit()s it, possibly shorter than reserved. The consumer read()s the next message in place
+        and release()s it when done, which hands its bytes back to the producer. Every message is
+        contiguous: one that doesn't fit before the end of the ring leaves the rest of the lap as
+        padding and starts over at the front, like a bip buffer. Messages start 8 byte aligned.
+
+        Each side keeps the other's position cached and only reloads it when the ring looks full or
+        empty, so in steady state a message costs one release store on each side.
+
+        \code
+        ByteStream stream(1 << 20);
+        ...
+        // Producer
+        ByteSpan span = stream.reserve(order.maxEncodedSize());
+        if(span.isEmpty())
+            return false; // Full
+        stream.commit(order.encode(span.data));
+        ...
+        // Consumer
+        for(ByteSpan message = stream.read(); !message.isEmpty(); message = stream.read())
+        {
+            handle(Order::decode(message.data, message.size));
+            stream.release();
+        }
+        \endcode
+    */
+    class ByteStream
+    {
+    public:
+        /*! \brief capacity is rounded up to a power of two, the largest message is maxMessageSize()
+        */
+        explicit ByteStream(size_t capacity);
+        ~ByteStream();
+
+        // Producer
+
+        /*! \brief Room for a message of up to size bytes, empty if the ring is too full right now.
+            Reserving again without committing replaces the reservation.
+        */
+        ByteSpan    reserve(size_t size);
+        /*! \brief Publishes the reserved message with its final size, at most the size reserved.
+            Returns false and publishes nothing if there is no reservation, as after a failed
+            reserve().
+        */
+        bool        commit(size_t size);
+        /*! \brief reserve(), copy and commit(), false if the ring is too full
+        */
+        bool        write(const void* data, size_t size);
+
+        // Consumer
+
+        /*! \brief The oldest message, empty if there is none. The same message is returned until
+            it is released.
+        */
+        ByteSpan    read();
+        void        release();
+
+        bool        isEmpty() const;
+        /*! \brief Bytes in use, including headers and padding
+        */
+        size_t      usedBytes() const;
+        size_t      capacity() const;
+        size_t      maxMessageSize() const;
+
+    private:
+        // Every message starts with its size, padding has PADDING instead
+        static const uint32_t   PADDING = ~uint32_t(0);
+        static const size_t     HEADER_SIZE = 8;
+
+        static size_t   recordSize(size_t size);
+        uint32_t&       headerAt(uint64_t position) const;
+
+        char* const     m_buffer;
+        const size_t    m_mask;
+
+        struct DX_CACHE_ALIGNED Producer
+        {
+            std::atomic<uint64_t>   tail;
+            uint64_t                cachedHead;
+            // Record size of the message reserve() handed out, 0 if none
+            size_t                  reserved;
+        };
+        struct DX_CACHE_ALIGNED Consumer
+        {
+            std::atomic<uint64_t>   head;
+            uint64_t                cachedTail;
+            // Record size of the message read() handed out, 0 if none
+            size_t                  reading;
+        };
+
+        Producer    m_producer;
+        Consumer    m_consumer;
+
+        ByteStream(const ByteStream&);
+        ByteStream(ByteStream&&);
+    };
+
+}
\ No newline at end of file
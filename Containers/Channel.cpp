@@ -0,0 +1,255 @@
+
+#include "Channel.h"
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    ChannelBase::Waiter::Waiter() : signalled(0), claimedBy(nullptr)
+    {
+    }
+
+    void ChannelBase::Waiter::wait()
+    {
+        for(size_t spins = 0; spins < DEFAULT_PARK_SPINS; ++spins)
+        {
+            if(signalled.load(std::memory_order_acquire))
+                return;
+            // Spin out
+        }
+        while(!signalled.load(std::memory_order_acquire))
+            futexWait(signalled, 0);
+    }
+
+    ChannelBase::WaitLink::WaitLink() : prev(nullptr), next(nullptr), waiter(nullptr), value(nullptr), linked(false)
+    {
+    }
+
+    ChannelBase::WaitList::WaitList() : head(nullptr), tail(nullptr)
+    {
+    }
+
+    void ChannelBase::WaitList::pushBack(WaitLink& link)
+    {
+        assert(!link.linked);
+        link.prev = tail;
+        link.next = nullptr;
+        if(tail)
+            tail->next = &link;
+        else
+            head = &link;
+        tail = &link;
+        link.linked = true;
+    }
+
+    void ChannelBase::WaitList::remove(WaitLink& link)
+    {
+        assert(link.linked);
+        if(link.prev)
+            link.prev->next = link.next;
+        else
+            head = link.next;
+        if(link.next)
+            link.next->prev = link.prev;
+        else
+            tail = link.prev;
+        link.prev = link.next = nullptr;
+        link.linked = false;
+    }
+
+    ChannelBase::WaitLink* ChannelBase::WaitList::popFront()
+    {
+        WaitLink* link = head;
+        if(link)
+            remove(*link);
+        return link;
+    }
+
+    bool ChannelBase::WaitList::isEmpty() const
+    {
+        return head == nullptr;
+    }
+
+    ChannelBase::ChannelBase() : m_closed(false)
+    {
+    }
+
+    ChannelBase::~ChannelBase()
+    {
+    }
+
+    void ChannelBase::close()
+    {
+        std::lock_guard<ParkingMutex> lock(m_mutex);
+        m_closed = true;
+        wakeAll(m_receivers);
+        wakeAll(m_senders);
+    }
+
+    bool ChannelBase::isClosed() const
+    {
+        std::lock_guard<ParkingMutex> lock(m_mutex);
+        return m_closed;
+    }
+
+    bool ChannelBase::wakeOne(WaitList& list)
+    {
+        // A Select linked here may have been claimed by another of its channels already, its
+        // link is still here until it gets to unlinking it
+        while(WaitLink* link = list.popFront())
+        {
+            if(link->waiter && tryClaim(*link->waiter))
+                return true;
+        }
+        return false;
+    }
+
+    void ChannelBase::wakeAll(WaitList& list)
+    {
+        while(WaitLink* link = list.popFront())
+        {
+            if(link->waiter)
+                tryClaim(*link->waiter);
+        }
+    }
+
+    bool ChannelBase::tryClaim(Waiter& waiter)
+    {
+        ChannelBase* expected = nullptr;
+        if(!waiter.claimedBy.compare_exchange_strong(expected, this, std::memory_order_relaxed))
+            return false;
+
+        // Still under m_mutex, which the waiter takes before it returns, so it can't be gone by
+        // the time the futex is woken
+        waiter.signalled.store(1, std::memory_order_release);
+        futexWakeOne(waiter.signalled);
+        return true;
+    }
+
+    void ChannelBase::waitOn(WaitList& list, WaitLink& link, Waiter& waiter)
+    {
+        link.waiter = &waiter;
+        m_mutex.unlock();
+        waiter.wait();
+        m_mutex.lock();
+        // Close and rendezvous receivers unlink before signalling, everyone else leaves it to us
+        if(link.linked)
+            list.remove(link);
+    }
+
+    void ChannelBase::passWakeup()
+    {
+        std::lock_guard<ParkingMutex> lock(m_mutex);
+        if(isReadable())
+            wakeOne(m_receivers);
+    }
+
+    bool ChannelBase::addSelectWaiter(WaitLink& link, Waiter& waiter)
+    {
+        std::lock_guard<ParkingMutex> lock(m_mutex);
+        // Closed and drained the channel can't wake anyone, the Select polls again and sees it
+        if(isReadable() || m_closed)
+            return false;
+        link.waiter = &waiter;
+        m_receivers.pushBack(link);
+        return true;
+    }
+
+    void ChannelBase::removeSelectWaiter(WaitLink& link)
+    {
+        std::lock_guard<ParkingMutex> lock(m_mutex);
+        if(link.linked)
+            m_receivers.remove(link);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    Select::Select() : m_numCases(0), m_next(0)
+    {
+    }
+
+    Select::~Select()
+    {
+    }
+
+    size_t Select::addCase(ChannelBase& channel, ChannelBase::ReceiveStatus (*tryReceive)(ChannelBase&, void*), void* out)
+    {
+        assert(m_numCases < MAX_SELECT_CASES);
+        Case& added = m_cases[m_numCases];
+        added.channel = &channel;
+        added.tryReceive = tryReceive;
+        added.out = out;
+        added.closed = false;
+        return m_numCases++;
+    }
+
+    size_t Select::poll()
+    {
+        size_t numClosed = 0;
+        for(size_t i = 0; i < m_numCases; ++i)
+        {
+            const size_t index = (m_next + i) % m_numCases;
+            const ChannelBase::ReceiveStatus status = m_cases[index].tryReceive(*m_cases[index].channel, m_cases[index].out);
+            if(status == ChannelBase::RECEIVED)
+            {
+                m_next = index + 1;
+                return index;
+            }
+            if(status == ChannelBase::CLOSED)
+            {
+                m_cases[index].closed = true;
+                ++numClosed;
+            }
+        }
+        return numClosed == m_numCases ? CLOSED : NONE;
+    }
+
+    size_t Select::tryWait()
+    {
+        return poll();
+    }
+
+    size_t Select::wait()
+    {
+        for(;;)
+        {
+            const size_t ready = poll();
+            if(ready != NONE)
+                return ready;
+
+            // Link the one waiter into every channel. A channel that got an item or was closed
+            // since poll() refuses it, and then there's no point in sleeping.
+            ChannelBase::Waiter waiter;
+            size_t numLinked = 0;
+            bool sleep = true;
+            for(; numLinked < m_numCases; ++numLinked)
+            {
+                // Closed for good, linking would only make it refuse
+                if(m_cases[numLinked].closed)
+                    continue;
+                if(!m_cases[numLinked].channel->addSelectWaiter(m_cases[numLinked].link, waiter))
+                {
+                    sleep = false;
+                    break;
+                }
+            }
+            if(sleep)
+                waiter.wait();
+            for(size_t i = 0; i < numLinked; ++i)
+                m_cases[i].channel->removeSelectWaiter(m_cases[i].link);
+
+            ChannelBase* claimedBy = waiter.claimedBy.load(std::memory_order_relaxed);
+            const size_t received = poll();
+            // The channel that woke us did so instead of waking someone else, if we took from
+            // another one its item would sit there with nobody coming for it
+            if(claimedBy && (received >= m_numCases || m_cases[received].channel != claimedBy))
+                claimedBy->passWakeup();
+            if(received != NONE)
+                return received;
+        }
+    }
+
+}
\ No newline at end of file
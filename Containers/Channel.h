@@ -0,0 +1,455 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Closable blocking channels and select over several of them
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "../Mutex/Futex.h"
+#include "../Mutex/ParkingMutex.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    // Most channels one Select can wait on, cases live in the Select itself so waiting never allocates
+    #ifndef MAX_SELECT_CASES
+        #define MAX_SELECT_CASES 64
+    #endif
+
+    /*! \brief ChannelBase is the type independent half of Channel: the lock, the closed flag and the
+        lists of blocked receivers and senders. Select works on it so it can wait on channels of
+        different types.
+
+        Every blocked thread has exactly one wake-up source, a futex word in its Waiter, which may
+        be linked into the lists of several channels at once. A channel wakes a waiter by claiming
+        it, so a waiter woken by two channels at the same time is only claimed by one of them and
+        the other moves on to its next waiter.
+    */
+    class ChannelBase
+    {
+    public:
+        enum ReceiveStatus
+        {
+            RECEIVED,
+            EMPTY,
+            CLOSED
+        };
+
+        ChannelBase();
+        virtual ~ChannelBase();
+
+        /*! \brief Closes the channel. Sends fail from now on, receives succeed until the channel is
+            drained and fail after that. Every blocked sender and receiver is woken.
+        */
+        void close();
+        bool isClosed() const;
+
+    protected:
+        struct Waiter
+        {
+            Waiter();
+
+            // Blocks until a channel claims and signals the waiter
+            void wait();
+
+            std::atomic<uint32_t>       signalled;
+            // The channel that claimed the waiter
+            std::atomic<ChannelBase*>   claimedBy;
+        };
+
+        struct WaitLink
+        {
+            WaitLink();
+
+            WaitLink*   prev;
+            WaitLink*   next;
+            Waiter*     waiter;
+            // Rendezvous senders park with their value, a receiver nulls it once taken. Receivers in
+            // receive() park with their out, a rendezvous trySend() nulls it once delivered.
+            void*       value;
+            bool        linked;
+        };
+
+        struct WaitList
+        {
+            WaitList();
+
+            void        pushBack(WaitLink& link);
+            void        remove(WaitLink& link);
+            WaitLink*   popFront();
+            bool        isEmpty() const;
+
+            WaitLink*   head;
+            WaitLink*   tail;
+        };
+
+        // The rest is called with m_mutex held
+
+        /*! \brief Whether a receive would succeed right now
+        */
+        virtual bool    isReadable() const = 0;
+        // Claims and signals the first waiter on list nobody else has claimed yet
+        bool            wakeOne(WaitList& list);
+        void            wakeAll(WaitList& list);
+        // Fails if another channel claimed the waiter first
+        bool            tryClaim(Waiter& waiter);
+        // Blocks on link until signalled, then unlinks it. Releases and retakes m_mutex.
+        void            waitOn(WaitList& list, WaitLink& link, Waiter& waiter);
+
+        // Hands a wake-up this channel gave a waiter that didn't use it to the next receiver
+        void            passWakeup();
+        // Links a Select's waiter, or returns false if the channel is readable or closed already
+        bool            addSelectWaiter(WaitLink& link, Waiter& waiter);
+        void            removeSelectWaiter(WaitLink& link);
+
+        mutable ParkingMutex    m_mutex;
+        bool                    m_closed;
+        WaitList                m_receivers;
+        WaitList                m_senders;
+
+    private:
+        friend class Select;
+
+        ChannelBase(const ChannelBase&);
+        ChannelBase(ChannelBase&&);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief Channel is a closable, blocking FIFO between any number of senders and receivers.
+        Its capacity decides how senders block:
+
+         - UNBOUNDED (the default): send() never blocks
+         - n > 0: send() blocks while n items are buffered
+         - 0: a rendezvous channel, send() blocks until a receiver has taken the item
+
+        Blocked threads sleep on a futex and are woken one at a time as items or space show up.
+        Use Select to wait on several channels at once.
+
+        \code
+        Channel<Request> requests(1024);
+        ...
+        // Producer
+        if(!requests.send(request))
+            reject(request); // Closed, shutting down
+        ...
+        // Consumer
+        Request request;
+        while(requests.receive(request))
+            handle(request);
+        // Closed and drained
+        \endcode
+    */
+    template <typename T>
+    class Channel : public ChannelBase
+    {
+    public:
+        static const size_t UNBOUNDED = ~size_t(0);
+
+        explicit Channel(size_t capacity = UNBOUNDED);
+        ~Channel();
+
+        /*! \brief Sends value, blocking while the channel is full (or, for rendezvous channels,
+            until a receiver took it). Returns false if the channel is or gets closed first.
+        */
+        bool    send(const T& value);
+        bool    send(T&& value);
+        /*! \brief Sends value if that doesn't need to block. A rendezvous channel only accepts a
+            trySend() when a receiver is waiting in receive() right now.
+        */
+        bool    trySend(const T& value);
+        bool    trySend(T&& value);
+
+        /*! \brief Receives the next item, blocking while the channel is empty. Returns false once
+            the channel is closed and drained.
+        */
+        bool    receive(T& out);
+        bool    tryReceive(T& out);
+
+        size_t  size() const;
+        size_t  capacity() const;
+
+    private:
+        template <typename U>
+        bool    sendImpl(U&& value, bool block);
+        // Moves value into a receiver parked in receive(), if there is one
+        template <typename U>
+        bool    handOff(U&& value);
+        ReceiveStatus tryReceiveLocked(T& out);
+        static ReceiveStatus tryReceiveErased(ChannelBase& channel, void* out);
+
+        bool    isReadable() const;
+
+        const size_t    m_capacity;
+        std::deque<T>   m_items;
+
+        friend class Select;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief Select receives from whichever of several channels has an item first. Add the
+        channels with receive(channel, out), then wait() returns the index of the case that received
+        into its out. One Select can be reused for any number of waits.
+
+        A waiting Select links a single waiter into every channel, the first channel to get an item
+        wakes it. Cases are tried round-robin so a busy channel can't starve the others.
+
+        \code
+        Select select;
+        const size_t control = select.receive(controlChannel, command);
+        const size_t data = select.receive(dataChannel, packet);
+        for(;;)
+        {
+            const size_t ready = select.wait();
+            if(ready == Select::CLOSED)
+                break;
+            if(ready == control)
+                apply(command);
+            else
+                process(packet);
+        }
+        \endcode
+    */
+    class Select
+    {
+    public:
+        // wait() / tryWait() results besides a case index
+        static const size_t CLOSED = ~size_t(0);
+        static const size_t NONE = ~size_t(0) - 1;
+
+        Select();
+        ~Select();
+
+        /*! \brief Adds a case receiving from channel into out, returns the case's index
+        */
+        template <typename T>
+        size_t  receive(Channel<T>& channel, T& out);
+
+        /*! \brief Blocks until a case has received, returns its index. Returns CLOSED once every
+            channel is closed and drained.
+        */
+        size_t  wait();
+        /*! \brief Like wait(), but returns NONE instead of blocking
+        */
+        size_t  tryWait();
+
+    private:
+        struct Case
+        {
+            ChannelBase*                    channel;
+            ChannelBase::ReceiveStatus      (*tryReceive)(ChannelBase& channel, void* out);
+            void*                           out;
+            ChannelBase::WaitLink           link;
+            // Seen closed and drained by poll()
+            bool                            closed;
+        };
+
+        size_t  addCase(ChannelBase& channel, ChannelBase::ReceiveStatus (*tryReceive)(ChannelBase&, void*), void* out);
+        // Tries every case once, returns an index, NONE or CLOSED
+        size_t  poll();
+
+        Case    m_cases[MAX_SELECT_CASES];
+        size_t  m_numCases;
+        // Round-robin start of the next poll
+        size_t  m_next;
+
+        Select(const Select&);
+        Select(Select&&);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    template <typename T>
+    Channel<T>::Channel(size_t capacity) : ChannelBase(), m_capacity(capacity)
+    {
+    }
+
+    template <typename T>
+    Channel<T>::~Channel()
+    {
+        assert(m_receivers.isEmpty() && m_senders.isEmpty()); // Nobody may be blocked on a dying channel
+    }
+
+    template <typename T>
+    size_t Channel<T>::size() const
+    {
+        std::lock_guard<ParkingMutex> lock(m_mutex);
+        return m_items.size();
+    }
+
+    template <typename T>
+    size_t Channel<T>::capacity() const
+    {
+        return m_capacity;
+    }
+
+    template <typename T>
+    bool Channel<T>::isReadable() const
+    {
+        return !m_items.empty() || (m_capacity == 0 && !m_senders.isEmpty());
+    }
+
+    template <typename T>
+    bool Channel<T>::send(const T& value)
+    {
+        return sendImpl(value, true);
+    }
+
+    template <typename T>
+    bool Channel<T>::send(T&& value)
+    {
+        return sendImpl(std::move(value), true);
+    }
+
+    template <typename T>
+    bool Channel<T>::trySend(const T& value)
+    {
+        return sendImpl(value, false);
+    }
+
+    template <typename T>
+    bool Channel<T>::trySend(T&& value)
+    {
+        return sendImpl(std::move(value), false);
+    }
+
+    template <typename T>
+    template <typename U>
+    bool Channel<T>::sendImpl(U&& value, bool block)
+    {
+        std::lock_guard<ParkingMutex> lock(m_mutex);
+        if(m_capacity == 0)
+        {
+            if(m_closed)
+                return false;
+            // Parking until a woken receiver gets to us could take forever: it may take an earlier
+            // sender, or be a Select that takes from another channel
+            if(!block)
+                return handOff(std::forward<U>(value));
+
+            // Park with the value until a receiver takes it
+            T parked(std::forward<U>(value));
+            Waiter waiter;
+            WaitLink link;
+            link.value = &parked;
+            m_senders.pushBack(link);
+            wakeOne(m_receivers);
+            waitOn(m_senders, link, waiter);
+            return link.value == nullptr;
+        }
+
+        for(;;)
+        {
+            if(m_closed)
+                return false;
+            if(m_items.size() < m_capacity)
+            {
+                m_items.push_back(std::forward<U>(value));
+                wakeOne(m_receivers);
+                return true;
+            }
+            if(!block)
+                return false;
+
+            Waiter waiter;
+            WaitLink link;
+            m_senders.pushBack(link);
+            waitOn(m_senders, link, waiter);
+        }
+    }
+
+    template <typename T>
+    template <typename U>
+    bool Channel<T>::handOff(U&& value)
+    {
+        for(WaitLink* link = m_receivers.head; link != nullptr; link = link->next)
+        {
+            // Selects have no out
+            if(link->value == nullptr)
+                continue;
+            *static_cast<T*>(link->value) = std::forward<U>(value);
+            link->value = nullptr;
+            m_receivers.remove(*link);
+            tryClaim(*link->waiter);
+            return true;
+        }
+        return false;
+    }
+
+    template <typename T>
+    typename ChannelBase::ReceiveStatus Channel<T>::tryReceiveLocked(T& out)
+    {
+        if(!m_items.empty())
+        {
+            out = std::move(m_items.front());
+            m_items.pop_front();
+            // Room for one more
+            wakeOne(m_senders);
+            return RECEIVED;
+        }
+        if(m_capacity == 0 && !m_senders.isEmpty())
+        {
+            WaitLink* sender = m_senders.popFront();
+            T* value = static_cast<T*>(sender->value);
+            out = std::move(*value);
+            sender->value = nullptr;
+            tryClaim(*sender->waiter);
+            return RECEIVED;
+        }
+        return m_closed ? CLOSED : EMPTY;
+    }
+
+    template <typename T>
+    typename ChannelBase::ReceiveStatus Channel<T>::tryReceiveErased(ChannelBase& channel, void* out)
+    {
+        Channel& self = static_cast<Channel&>(channel);
+        std::lock_guard<ParkingMutex> lock(self.m_mutex);
+        return self.tryReceiveLocked(*static_cast<T*>(out));
+    }
+
+    template <typename T>
+    bool Channel<T>::tryReceive(T& out)
+    {
+        return tryReceiveErased(*this, &out) == RECEIVED;
+    }
+
+    template <typename T>
+    bool Channel<T>::receive(T& out)
+    {
+        std::lock_guard<ParkingMutex> lock(m_mutex);
+        for(;;)
+        {
+            const ReceiveStatus status = tryReceiveLocked(out);
+            if(status != EMPTY)
+                return status == RECEIVED;
+
+            Waiter waiter;
+            WaitLink link;
+            link.value = &out;
+            m_receivers.pushBack(link);
+            waitOn(m_receivers, link, waiter);
+            if(link.value == nullptr)
+                return true; // Handed off by a rendezvous trySend()
+        }
+    }
+
+    template <typename T>
+    size_t Select::receive(Channel<T>& channel, T& out)
+    {
+        return addCase(channel, &Channel<T>::tryReceiveErased, &out);
+    }
+
+}
\ No newline at end of file
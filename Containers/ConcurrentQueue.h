@@ -9,7 +9,9 @@
 #include "../CacheLine.h"
 #include "AbstractQueue.h"
 #include "../Mutex/SpinYieldMutex.h"
+#include "../Threading/Coroutine.h"
 
+#include <cassert>
 #include <new>
 
 namespace DX
@@ -38,29 +40,90 @@ namespace DX
 
         void    clear();
 
+    #ifdef DX_HAS_COROUTINES
+        class PopAwaiter;
+
+        /*! \brief co_await queue.popAsync() yields the next item, suspending the coroutine while
+            the queue is empty. It is resumed on executor by the push that gives it an item, or on
+            the pushing thread if executor is null. Waiting doesn't allocate or block a thread.
+
+            \note Don't destroy the queue while coroutines are still waiting on it.
+        */
+        PopAwaiter popAsync(Executor* executor = nullptr);
+    #endif
+
     private:
+        struct PopWaiter : AsyncWaiter
+        {
+            T* out;
+        };
+
+        // Queues waiter unless an item shows up first, returns false if it was popped into waiter
+        bool    suspendPop(PopWaiter& waiter);
+        // Hands pushed items to waiting coroutines
+        void    resumePoppers();
+
         // SpinLocks are already padded on their own cache lines, so we don't need anymore padding
         SpinYieldMutex pushMutex;
         SpinYieldMutex popMutex;
+        // Coroutines waiting in popAsync(), always here so that C++11 and C++20 code agree on layout
+        SpinMutex           m_waitersMutex;
+        PopWaiter*          m_waitersHead;
+        PopWaiter*          m_waitersTail;
+        std::atomic<size_t> m_numWaiters;
     };
 
+#ifdef DX_HAS_COROUTINES
+    template <typename T>
+    class ConcurrentQueue<T>::PopAwaiter : private PopWaiter
+    {
+    public:
+        PopAwaiter(ConcurrentQueue& queue, Executor* executor) : m_queue(queue), m_value()
+        {
+            this->executor = executor;
+            this->out = &m_value;
+        }
+
+        bool await_ready()
+        {
+            return m_queue.pop(m_value);
+        }
+
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            setContinuation(*this, handle);
+            return m_queue.suspendPop(*this);
+        }
+
+        T await_resume()
+        {
+            return std::move(m_value);
+        }
+
+    private:
+        ConcurrentQueue&    m_queue;
+        T                   m_value;
+    };
+#endif
+
     ////////////////////////////////////////////////////////////////////////////////////////////////
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // impl
 
     template <typename T>
-    ConcurrentQueue<T>::ConcurrentQueue() : Queue<T>()
+    ConcurrentQueue<T>::ConcurrentQueue() : Queue<T>(), m_waitersHead(nullptr), m_waitersTail(nullptr), m_numWaiters(0)
     {
-        m_start = new Node<T>();
-        m_end = m_start;
-        assert(m_start != nullptr);
+        this->m_start = new Node<T>();
+        this->m_end = this->m_start;
+        assert(this->m_start != nullptr);
     }
 
     template <typename T>
-    ConcurrentQueue<T>::ConcurrentQueue(const ConcurrentQueue& copy) : Queue<T>()
+    ConcurrentQueue<T>::ConcurrentQueue(const ConcurrentQueue& copy) : Queue<T>(), m_waitersHead(nullptr), m_waitersTail(nullptr), m_numWaiters(0)
     {
-        m_start = new Node<T>();
-        assert(m_start != nullptr);
+        this->m_start = new Node<T>();
+        this->m_end = this->m_start;
+        assert(this->m_start != nullptr);
 
         SpinLock popLock(copy.popMutex);
         assert(copy.m_start != nullptr);
@@ -75,41 +138,43 @@ namespace DX
     }
 
     template <typename T>
-    ConcurrentQueue<T>::ConcurrentQueue(ConcurrentQueue&& move) : Queue()
+    ConcurrentQueue<T>::ConcurrentQueue(ConcurrentQueue&& move) : Queue<T>(), m_waitersHead(nullptr), m_waitersTail(nullptr), m_numWaiters(0)
     {
+        assert(move.m_waitersHead == nullptr); // Waiting coroutines can't follow the items
         SpinLock popLock(move.popMutex);
         SpinLock pushLock(move.pushMutex);
 
-        m_start = new Node<T>();
-        m_start->next = move.m_start->next;
+        this->m_start = new Node<T>();
+        this->m_start->next = move.m_start->next.load();
         move.m_start->next = nullptr;
         if(move.m_end == move.m_start)
         {
-            m_end = m_start;
+            this->m_end = this->m_start;
         }
         else
         {
+            this->m_end = move.m_end;
             move.m_end = move.m_start;
-            m_end = move.m_end;
         }
-        m_size = move.m_size;
+        this->m_size = move.m_size.load();
         move.m_size = 0;
 
-        assert(m_start != nullptr);
-        assert(m_end != nullptr);
+        assert(this->m_start != nullptr);
+        assert(this->m_end != nullptr);
     }
 
     template <typename T>
     ConcurrentQueue<T>::~ConcurrentQueue()
     {
+        assert(m_waitersHead == nullptr); // Nobody would ever resume them
         clear();
         SpinLock popLock(popMutex);
         SpinLock pushLock(pushMutex);      
 
-        delete m_start->data;
-        m_start->data = nullptr;
-        delete m_start;
-        m_start = nullptr;
+        delete this->m_start->data;
+        this->m_start->data = nullptr;
+        delete this->m_start;
+        this->m_start = nullptr;
     }
 
     template <typename T>
@@ -118,10 +183,10 @@ namespace DX
         SpinLock popLock(popMutex);
         SpinLock pushLock(pushMutex);
 
-        while(m_start->next.load() != nullptr)
+        while(this->m_start->next.load() != nullptr)
         {
-            Node<T>* currentNode = m_start;
-            m_start = currentNode->next.load();
+            Node<T>* currentNode = this->m_start;
+            this->m_start = currentNode->next.load();
             if(currentNode->data != nullptr)
             {
                 delete currentNode->data;
@@ -135,54 +200,65 @@ namespace DX
     template <typename T>
     bool ConcurrentQueue<T>::isEmpty() const
     {
-        return m_size == 0;
+        return this->m_size == 0;
     }
 
     template <typename T>
     size_t ConcurrentQueue<T>::size() const
     {
-        return m_size;
+        return this->m_size;
     }
 
     template <typename T>
     bool ConcurrentQueue<T>::front(T& out) const
     {
-        assert(m_start);
-        if(m_start->next.load() == nullptr)
+        assert(this->m_start);
+        if(this->m_start->next.load() == nullptr)
             return false;
         SpinLock popLock(popMutex);
-        if(m_start->next.load()->data == nullptr)
+        if(this->m_start->next.load()->data == nullptr)
             return false;
 
-        out = *(m_start->next.load()->data);
+        out = *(this->m_start->next.load()->data);
         return true;
     }
 
     template <typename T>
     bool ConcurrentQueue<T>::pop(T& out)
     {
-        assert(m_start != nullptr);
-        // m_start should never be a nullptr on a valid queue
+        assert(this->m_start != nullptr);
+        // this->m_start should never be a nullptr on a valid queue
 
         Node<T>* newStart = nullptr;
         Node<T>* oldStart = nullptr;
+        #ifdef DX_QUEUE_TELEMETRY
+            uint64_t pushedAt = 0;
+        #endif
 
         {
             SpinLock popLock(popMutex);
 
-            newStart = m_start->next.load();
+            newStart = this->m_start->next.load();
             if(newStart == nullptr) // No items left
                 return false;
 
-            oldStart = m_start;
-            m_start = newStart;
-
-            assert(m_start->data != nullptr);
-            out = std::move(*(m_start->data));
-            assert(m_size > 0);
-            --m_size;
+            oldStart = this->m_start;
+            this->m_start = newStart;
+
+            assert(this->m_start->data != nullptr);
+            out = std::move(*(this->m_start->data));
+            assert(this->m_size > 0);
+            --this->m_size;
+            // The next pop may free newStart as soon as we unlock
+            #ifdef DX_QUEUE_TELEMETRY
+                pushedAt = newStart->pushedAt;
+            #endif
         }
 
+        #ifdef DX_QUEUE_TELEMETRY
+            this->m_telemetry.popped(pushedAt);
+        #endif
+
         delete oldStart->data;
         // Only null out what used to be there in DEBUG mode
         #if defined _DEBUG || defined DEBUG
@@ -199,35 +275,115 @@ namespace DX
     template <typename T>
     void ConcurrentQueue<T>::push(const T& in)
     {
-        assert(m_end != nullptr);
-        // m_end should never be a nullptr on a valid queue
+        assert(this->m_end != nullptr);
+        // this->m_end should never be a nullptr on a valid queue
 
         Node<T>* temp = new (std::nothrow) Node<T>(new (std::nothrow) T(in));
         assert(temp != nullptr);
         assert(temp->data != nullptr);
+        // Stamp before linking, a consumer may pop and free the node right after
+        #ifdef DX_QUEUE_TELEMETRY
+            this->m_telemetry.pushing(temp->pushedAt);
+        #endif
         {
 	        SpinLock pushLock(pushMutex);
-            ++m_size;
-            m_end->next = temp;
-            m_end = temp;
+            ++this->m_size;
+            this->m_end->next = temp;
+            this->m_end = temp;
         }
+        #ifdef DX_QUEUE_TELEMETRY
+            this->m_telemetry.sizeIs(this->m_size.load(std::memory_order_relaxed));
+        #endif
+        this->m_readiness.notify();
+        // Pairs with the increment in suspendPop(): either it sees our node or we see the waiter
+        if(m_numWaiters.load() != 0)
+            resumePoppers();
     }
 
     template <typename T>
     void ConcurrentQueue<T>::push(T&& moveIn)
     {
-        assert(m_end != nullptr);
-        // m_end should never be a nullptr on a valid queue
+        assert(this->m_end != nullptr);
+        // this->m_end should never be a nullptr on a valid queue
 
         Node<T>* temp = new (std::nothrow) Node<T>(new (std::nothrow) T(moveIn));
         assert(temp != nullptr);
         assert(temp->data != nullptr);
+        // Stamp before linking, a consumer may pop and free the node right after
+        #ifdef DX_QUEUE_TELEMETRY
+            this->m_telemetry.pushing(temp->pushedAt);
+        #endif
         {
 	        SpinLock pushLock(pushMutex);
-            ++m_size;
-            m_end->next = temp;
-            m_end = temp;
+            ++this->m_size;
+            this->m_end->next = temp;
+            this->m_end = temp;
         }
+        #ifdef DX_QUEUE_TELEMETRY
+            this->m_telemetry.sizeIs(this->m_size.load(std::memory_order_relaxed));
+        #endif
+        this->m_readiness.notify();
+        // Pairs with the increment in suspendPop(): either it sees our node or we see the waiter
+        if(m_numWaiters.load() != 0)
+            resumePoppers();
     }
  
+    template <typename T>
+    bool ConcurrentQueue<T>::suspendPop(PopWaiter& waiter)
+    {
+        SpinLock waitersLock(m_waitersMutex);
+        ++m_numWaiters;
+        if(pop(*waiter.out))
+        {
+            --m_numWaiters;
+            return false;
+        }
+
+        waiter.next = nullptr;
+        if(m_waitersTail == nullptr)
+            m_waitersHead = &waiter;
+        else
+            m_waitersTail->next = &waiter;
+        m_waitersTail = &waiter;
+        return true;
+    }
+
+    template <typename T>
+    void ConcurrentQueue<T>::resumePoppers()
+    {
+        // Fill waiters under the lock, but resume them after it: they may run inline
+        AsyncWaiter* ready = nullptr;
+        AsyncWaiter** readyTail = &ready;
+        {
+            SpinLock waitersLock(m_waitersMutex);
+            while(m_waitersHead != nullptr && pop(*m_waitersHead->out))
+            {
+                PopWaiter* waiter = m_waitersHead;
+                m_waitersHead = static_cast<PopWaiter*>(waiter->next);
+                if(m_waitersHead == nullptr)
+                    m_waitersTail = nullptr;
+                --m_numWaiters;
+
+                waiter->next = nullptr;
+                *readyTail = waiter;
+                readyTail = &waiter->next;
+            }
+        }
+
+        while(ready != nullptr)
+        {
+            AsyncWaiter* waiter = ready;
+            ready = waiter->next;
+            waiter->resume();
+        }
+    }
+
+#ifdef DX_HAS_COROUTINES
+    template <typename T>
+    typename ConcurrentQueue<T>::PopAwaiter ConcurrentQueue<T>::popAsync(Executor* executor)
+    {
+        return PopAwaiter(*this, executor);
+    }
+#endif
+
 }
\ No newline at end of file
@@ -0,0 +1,509 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Ordered map on a lock-free skiplist
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "ShardedCounter.h"
+#include "../Threading/Epoch.h"
+#include "../Threading/ThreadId.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <new>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    // Tallest tower a node can get. With a quarter of the nodes reaching each next level, 16 keeps
+    // searches logarithmic up to about 4 billion entries.
+    #ifndef SKIPLIST_MAX_HEIGHT
+        #define SKIPLIST_MAX_HEIGHT 16
+    #endif
+
+    /*! \brief ConcurrentSkipListMap is an ordered map where find(), insert(), erase() and iteration
+        are all lock-free, so readers never wait for writers or for each other.
+
+        Every node carries its key, value and tower of next pointers in one allocation, sized to the
+        node's height, so a search touches one cache line per node visited rather than chasing a
+        separate level array. Erasing marks the low bit of a node's next pointers, first on the
+        upper levels and then on the bottom one, which is what decides the erase; searches that run
+        into marked nodes unlink them. Unlinked nodes go to Epoch, which frees them once no reader
+        can be looking at them anymore.
+
+        Values are immutable once inserted: to change one, erase() and insert() again. Iterators are
+        weakly consistent, they see every entry that was there for the whole iteration, and may or
+        may not see the ones inserted or erased meanwhile. An Iterator pins the thread's epoch, so
+        don't keep one around longer than needed, and use it on the thread that made it.
+
+        \code
+        ConcurrentSkipListMap<uint64_t, Order> book;
+        book.insert(order.price, order);
+        ...
+        // Everything from 100 up to 200
+        for(ConcurrentSkipListMap<uint64_t, Order>::Iterator it = book.lowerBound(100); it.isValid() && it.key() < 200; it.next())
+            match(it.value());
+        \endcode
+    */
+    template <typename K, typename V, typename Compare = std::less<K> >
+    class ConcurrentSkipListMap
+    {
+        struct Node;
+
+    public:
+        class Iterator
+        {
+        public:
+            bool        isValid() const;
+            const K&    key() const;
+            const V&    value() const;
+            void        next();
+
+        private:
+            friend class ConcurrentSkipListMap;
+            Iterator();
+
+            // Declared first, the node must only be read once the epoch is pinned
+            Epoch::Guard    m_guard;
+            const Node*     m_node;
+        };
+
+        explicit ConcurrentSkipListMap(const Compare& compare = Compare());
+        /*! \brief Not thread safe, nobody may use the map anymore
+        */
+        ~ConcurrentSkipListMap();
+
+        /*! \brief Adds key, returns false without touching anything if it's there already
+        */
+        bool        insert(const K& key, const V& value);
+        bool        erase(const K& key);
+        /*! \brief Copies the value of key into out
+        */
+        bool        find(const K& key, V& out) const;
+        bool        contains(const K& key) const;
+
+        Iterator    begin() const;
+        /*! \brief Iterator at the first key not less than key
+        */
+        Iterator    lowerBound(const K& key) const;
+
+        /*! \brief Number of entries, only exact while nobody is changing the map
+        */
+        size_t      size() const;
+        bool        isEmpty() const;
+
+    private:
+        // Next pointers with the low bit set mean "this node is erased on this level"
+        typedef uintptr_t Link;
+
+        struct Node
+        {
+            Node(const K& key, const V& value, uint32_t height);
+
+            K                   key;
+            V                   value;
+            // Held by the inserter until it's done linking, and by the list until erased
+            std::atomic<uint32_t> refs;
+            uint32_t            height;
+            // The tower, allocated to height entries
+            std::atomic<Link>   next[1];
+        };
+
+        static Node*    pointerOf(Link link);
+        static bool     isMarked(Link link);
+        static Link     linkTo(const Node* node);
+
+        static Node*    newNode(const K& key, const V& value, uint32_t height);
+        static void     deleteNode(void* node);
+        static uint32_t randomHeight();
+        // Retires node once both the inserter and the eraser are done with it
+        void            release(Node* node);
+
+        std::atomic<Link>&          linkOf(Node* pred, size_t level);
+        const std::atomic<Link>&    linkOf(const Node* pred, size_t level) const;
+        /*! \brief Fills preds and succs on every level around key, unlinking erased nodes on the
+            way. preds are nullptr for the head. Returns whether succs[0] has key.
+        */
+        bool            search(const K& key, Node** preds, Node** succs);
+        // One pass of search(), false if it has to start over
+        bool            trySearch(const K& key, Node** preds, Node** succs);
+        // First node not erased with a key not less than key, read only
+        const Node*     lowerBoundNode(const K& key) const;
+        static const Node* firstLive(Link link);
+
+        Compare             m_compare;
+        std::atomic<Link>   m_head[SKIPLIST_MAX_HEIGHT];
+        ShardedCounter      m_size;
+
+        ConcurrentSkipListMap(const ConcurrentSkipListMap&);
+        ConcurrentSkipListMap(ConcurrentSkipListMap&&);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    template <typename K, typename V, typename Compare>
+    ConcurrentSkipListMap<K, V, Compare>::Node::Node(const K& _key, const V& _value, uint32_t _height) : key(_key), value(_value), refs(2), height(_height)
+    {
+    }
+
+    template <typename K, typename V, typename Compare>
+    ConcurrentSkipListMap<K, V, Compare>::ConcurrentSkipListMap(const Compare& compare) : m_compare(compare)
+    {
+        for(size_t level = 0; level < SKIPLIST_MAX_HEIGHT; ++level)
+            m_head[level].store(0, std::memory_order_relaxed);
+    }
+
+    template <typename K, typename V, typename Compare>
+    ConcurrentSkipListMap<K, V, Compare>::~ConcurrentSkipListMap()
+    {
+        // Erased nodes are all unlinked and belong to Epoch now, whatever is left is ours
+        Node* node = pointerOf(m_head[0].load(std::memory_order_acquire));
+        while(node != nullptr)
+        {
+            Node* next = pointerOf(node->next[0].load(std::memory_order_relaxed));
+            deleteNode(node);
+            node = next;
+        }
+    }
+
+    template <typename K, typename V, typename Compare>
+    typename ConcurrentSkipListMap<K, V, Compare>::Node* ConcurrentSkipListMap<K, V, Compare>::pointerOf(Link link)
+    {
+        return reinterpret_cast<Node*>(link & ~Link(1));
+    }
+
+    template <typename K, typename V, typename Compare>
+    bool ConcurrentSkipListMap<K, V, Compare>::isMarked(Link link)
+    {
+        return (link & 1) != 0;
+    }
+
+    template <typename K, typename V, typename Compare>
+    typename ConcurrentSkipListMap<K, V, Compare>::Link ConcurrentSkipListMap<K, V, Compare>::linkTo(const Node* node)
+    {
+        return reinterpret_cast<Link>(node);
+    }
+
+    template <typename K, typename V, typename Compare>
+    typename ConcurrentSkipListMap<K, V, Compare>::Node* ConcurrentSkipListMap<K, V, Compare>::newNode(const K& key, const V& value, uint32_t height)
+    {
+        assert(height >= 1 && height <= SKIPLIST_MAX_HEIGHT);
+        void* memory = ::operator new(sizeof(Node) + (height - 1) * sizeof(std::atomic<Link>));
+        Node* node = new (memory) Node(key, value, height);
+        for(uint32_t level = 1; level < height; ++level)
+            new (&node->next[level]) std::atomic<Link>(0);
+        return node;
+    }
+
+    template <typename K, typename V, typename Compare>
+    void ConcurrentSkipListMap<K, V, Compare>::deleteNode(void* memory)
+    {
+        Node* node = static_cast<Node*>(memory);
+        node->~Node();
+        ::operator delete(memory);
+    }
+
+    template <typename K, typename V, typename Compare>
+    uint32_t ConcurrentSkipListMap<K, V, Compare>::randomHeight()
+    {
+        static thread_local uint64_t s_state = 0;
+        if(s_state == 0)
+            s_state = 0x9E3779B97F4A7C15ULL * static_cast<uint64_t>(currentThreadId());
+
+        // xorshift64, then one more level for every two zero bits
+        s_state ^= s_state << 13;
+        s_state ^= s_state >> 7;
+        s_state ^= s_state << 17;
+        uint64_t bits = s_state;
+        uint32_t height = 1;
+        while(height < SKIPLIST_MAX_HEIGHT && (bits & 3) == 0)
+        {
+            ++height;
+            bits >>= 2;
+        }
+        return height;
+    }
+
+    template <typename K, typename V, typename Compare>
+    void ConcurrentSkipListMap<K, V, Compare>::release(Node* node)
+    {
+        if(node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            Epoch::retire(node, &deleteNode);
+    }
+
+    template <typename K, typename V, typename Compare>
+    std::atomic<typename ConcurrentSkipListMap<K, V, Compare>::Link>& ConcurrentSkipListMap<K, V, Compare>::linkOf(Node* pred, size_t level)
+    {
+        return pred != nullptr ? pred->next[level] : m_head[level];
+    }
+
+    template <typename K, typename V, typename Compare>
+    const std::atomic<typename ConcurrentSkipListMap<K, V, Compare>::Link>& ConcurrentSkipListMap<K, V, Compare>::linkOf(const Node* pred, size_t level) const
+    {
+        return pred != nullptr ? pred->next[level] : m_head[level];
+    }
+
+    template <typename K, typename V, typename Compare>
+    bool ConcurrentSkipListMap<K, V, Compare>::trySearch(const K& key, Node** preds, Node** succs)
+    {
+        Node* pred = nullptr;
+        for(size_t level = SKIPLIST_MAX_HEIGHT; level-- > 0;)
+        {
+            Node* current = pointerOf(linkOf(pred, level).load(std::memory_order_acquire));
+            while(current != nullptr)
+            {
+                Link next = current->next[level].load(std::memory_order_acquire);
+                while(isMarked(next))
+                {
+                    // Unlink the erased node. If pred got erased itself in the meantime its link
+                    // is marked and won't match, so start over from the top.
+                    Link expected = linkTo(current);
+                    if(!linkOf(pred, level).compare_exchange_strong(expected, next & ~Link(1), std::memory_order_acq_rel))
+                        return false;
+                    current = pointerOf(next);
+                    if(current == nullptr)
+                        break;
+                    next = current->next[level].load(std::memory_order_acquire);
+                }
+                if(current == nullptr || !m_compare(current->key, key))
+                    break;
+                pred = current;
+                current = pointerOf(next);
+            }
+            preds[level] = pred;
+            succs[level] = current;
+        }
+        return true;
+    }
+
+    template <typename K, typename V, typename Compare>
+    bool ConcurrentSkipListMap<K, V, Compare>::search(const K& key, Node** preds, Node** succs)
+    {
+        while(!trySearch(key, preds, succs))
+        {
+            // Spin out
+        }
+        return succs[0] != nullptr && !m_compare(key, succs[0]->key);
+    }
+
+    template <typename K, typename V, typename Compare>
+    bool ConcurrentSkipListMap<K, V, Compare>::insert(const K& key, const V& value)
+    {
+        Epoch::Guard guard;
+        Node* preds[SKIPLIST_MAX_HEIGHT];
+        Node* succs[SKIPLIST_MAX_HEIGHT];
+        const uint32_t height = randomHeight();
+        Node* node = nullptr;
+
+        // The bottom level decides, once linked there the node is in the map
+        for(;;)
+        {
+            if(search(key, preds, succs))
+            {
+                if(node != nullptr)
+                    deleteNode(node); // Never published
+                return false;
+            }
+            if(node == nullptr)
+                node = newNode(key, value, height);
+            for(uint32_t level = 0; level < height; ++level)
+                node->next[level].store(linkTo(succs[level]), std::memory_order_relaxed);
+
+            Link expected = linkTo(succs[0]);
+            if(linkOf(preds[0], 0).compare_exchange_strong(expected, linkTo(node), std::memory_order_release))
+                break;
+        }
+        m_size.increment();
+
+        // The upper levels are only shortcuts, stop as soon as the node gets erased
+        for(uint32_t level = 1; level < height; ++level)
+        {
+            bool linked = false;
+            while(!linked)
+            {
+                Link next = node->next[level].load(std::memory_order_acquire);
+                if(isMarked(next))
+                    break;
+                if(pointerOf(next) != succs[level] && !node->next[level].compare_exchange_strong(next, linkTo(succs[level]), std::memory_order_release))
+                    continue;
+
+                Link expected = linkTo(succs[level]);
+                linked = linkOf(preds[level], level).compare_exchange_strong(expected, linkTo(node), std::memory_order_release);
+                if(!linked && (!search(key, preds, succs) || succs[0] != node))
+                    break;
+            }
+            if(!linked)
+                break;
+        }
+
+        // An erase that raced with the linking above may have missed the levels linked late
+        if(isMarked(node->next[0].load(std::memory_order_acquire)))
+            search(key, preds, succs);
+        release(node);
+        return true;
+    }
+
+    template <typename K, typename V, typename Compare>
+    bool ConcurrentSkipListMap<K, V, Compare>::erase(const K& key)
+    {
+        Epoch::Guard guard;
+        Node* preds[SKIPLIST_MAX_HEIGHT];
+        Node* succs[SKIPLIST_MAX_HEIGHT];
+        if(!search(key, preds, succs))
+            return false;
+
+        Node* node = succs[0];
+        for(uint32_t level = node->height - 1; level > 0; --level)
+        {
+            Link next = node->next[level].load(std::memory_order_relaxed);
+            while(!isMarked(next) && !node->next[level].compare_exchange_weak(next, next | 1, std::memory_order_acq_rel))
+            {
+            }
+        }
+
+        // Whoever marks the bottom level erased it
+        Link next = node->next[0].load(std::memory_order_relaxed);
+        for(;;)
+        {
+            if(isMarked(next))
+                return false;
+            if(node->next[0].compare_exchange_weak(next, next | 1, std::memory_order_acq_rel))
+                break;
+        }
+        m_size.decrement();
+
+        search(key, preds, succs);
+        release(node);
+        return true;
+    }
+
+    template <typename K, typename V, typename Compare>
+    const typename ConcurrentSkipListMap<K, V, Compare>::Node* ConcurrentSkipListMap<K, V, Compare>::lowerBoundNode(const K& key) const
+    {
+        // Like trySearch(), but steps over erased nodes instead of unlinking them
+        const Node* pred = nullptr;
+        const Node* current = nullptr;
+        for(size_t level = SKIPLIST_MAX_HEIGHT; level-- > 0;)
+        {
+            current = pointerOf(linkOf(pred, level).load(std::memory_order_acquire));
+            while(current != nullptr)
+            {
+                Link next = current->next[level].load(std::memory_order_acquire);
+                while(isMarked(next))
+                {
+                    current = pointerOf(next);
+                    if(current == nullptr)
+                        break;
+                    next = current->next[level].load(std::memory_order_acquire);
+                }
+                if(current == nullptr || !m_compare(current->key, key))
+                    break;
+                pred = current;
+                current = pointerOf(next);
+            }
+        }
+        return current;
+    }
+
+    template <typename K, typename V, typename Compare>
+    const typename ConcurrentSkipListMap<K, V, Compare>::Node* ConcurrentSkipListMap<K, V, Compare>::firstLive(Link link)
+    {
+        const Node* node = pointerOf(link);
+        while(node != nullptr)
+        {
+            const Link next = node->next[0].load(std::memory_order_acquire);
+            if(!isMarked(next))
+                break;
+            node = pointerOf(next);
+        }
+        return node;
+    }
+
+    template <typename K, typename V, typename Compare>
+    bool ConcurrentSkipListMap<K, V, Compare>::find(const K& key, V& out) const
+    {
+        Epoch::Guard guard;
+        const Node* node = lowerBoundNode(key);
+        if(node == nullptr || m_compare(key, node->key))
+            return false;
+        out = node->value;
+        return true;
+    }
+
+    template <typename K, typename V, typename Compare>
+    bool ConcurrentSkipListMap<K, V, Compare>::contains(const K& key) const
+    {
+        Epoch::Guard guard;
+        const Node* node = lowerBoundNode(key);
+        return node != nullptr && !m_compare(key, node->key);
+    }
+
+    template <typename K, typename V, typename Compare>
+    typename ConcurrentSkipListMap<K, V, Compare>::Iterator ConcurrentSkipListMap<K, V, Compare>::begin() const
+    {
+        Iterator it;
+        it.m_node = firstLive(m_head[0].load(std::memory_order_acquire));
+        return it;
+    }
+
+    template <typename K, typename V, typename Compare>
+    typename ConcurrentSkipListMap<K, V, Compare>::Iterator ConcurrentSkipListMap<K, V, Compare>::lowerBound(const K& key) const
+    {
+        Iterator it;
+        it.m_node = lowerBoundNode(key);
+        return it;
+    }
+
+    template <typename K, typename V, typename Compare>
+    size_t ConcurrentSkipListMap<K, V, Compare>::size() const
+    {
+        const int64_t size = m_size.value();
+        return size > 0 ? static_cast<size_t>(size) : 0;
+    }
+
+    template <typename K, typename V, typename Compare>
+    bool ConcurrentSkipListMap<K, V, Compare>::isEmpty() const
+    {
+        Epoch::Guard guard;
+        return firstLive(m_head[0].load(std::memory_order_acquire)) == nullptr;
+    }
+
+    template <typename K, typename V, typename Compare>
+    ConcurrentSkipListMap<K, V, Compare>::Iterator::Iterator() : m_node(nullptr)
+    {
+    }
+
+    template <typename K, typename V, typename Compare>
+    bool ConcurrentSkipListMap<K, V, Compare>::Iterator::isValid() const
+    {
+        return m_node != nullptr;
+    }
+
+    template <typename K, typename V, typename Compare>
+    const K& ConcurrentSkipListMap<K, V, Compare>::Iterator::key() const
+    {
+        assert(m_node != nullptr);
+        return m_node->key;
+    }
+
+    template <typename K, typename V, typename Compare>
+    const V& ConcurrentSkipListMap<K, V, Compare>::Iterator::value() const
+    {
+        assert(m_node != nullptr);
+        return m_node->value;
+    }
+
+    template <typename K, typename V, typename Compare>
+    void ConcurrentSkipListMap<K, V, Compare>::Iterator::next()
+    {
+        assert(m_node != nullptr);
+        m_node = firstLive(m_node->next[0].load(std::memory_order_acquire));
+    }
+
+}
\ No newline at end of file
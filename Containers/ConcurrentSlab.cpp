@@ -0,0 +1,372 @@
+
+#include "ConcurrentSlab.h"
+#include "../Threading/ThreadId.h"
+
+#include <unordered_set>
+
+#if defined(_WIN32)
+    #include <malloc.h>
+#else
+    #include <sys/mman.h>
+#endif
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    static_assert((DEFAULT_SLAB_SIZE & (DEFAULT_SLAB_SIZE - 1)) == 0, "DEFAULT_SLAB_SIZE must be a power of two");
+    static_assert(DEFAULT_SLAB_ARENA_SIZE % DEFAULT_SLAB_SIZE == 0, "DEFAULT_SLAB_ARENA_SIZE must be a multiple of DEFAULT_SLAB_SIZE");
+
+    static size_t roundUp(size_t size, size_t alignment)
+    {
+        return (size + alignment - 1) & ~(alignment - 1);
+    }
+
+    struct SlabPool::Slab
+    {
+        ThreadCache*    owner;
+    };
+
+    struct DX_CACHE_ALIGNED SlabPool::ThreadCache
+    {
+        ThreadCache() : freeList(nullptr), cursor(nullptr), end(nullptr), threadId(0), allocations(0), cacheHits(0),
+            next(nullptr), remoteFrees(nullptr), numRemoteFrees(0)
+        {
+        }
+
+        // Only touched by the owning thread
+        Block*                  freeList;
+        char*                   cursor;
+        char*                   end;
+        // Owning thread, 0 while the cache waits for a new one
+        std::atomic<size_t>     threadId;
+        // Written by the owner only, atomic so stats() can read them
+        std::atomic<uint64_t>   allocations;
+        std::atomic<uint64_t>   cacheHits;
+        // Guarded by the pool's mutex
+        ThreadCache*            next;
+
+        // Other threads free here
+        DX_CACHE_ALIGNED std::atomic<Block*> remoteFrees;
+        std::atomic<uint64_t>   numRemoteFrees;
+    };
+
+    namespace Detail
+    {
+        // The caches a thread owns, handed back to their pools when it exits
+        struct SlabThreadState
+        {
+            struct Entry
+            {
+                uint64_t                poolId;
+                SlabPool::ThreadCache*  cache;
+            };
+
+            SlabThreadState() : lastPoolId(0), lastCache(nullptr) {}
+            ~SlabThreadState();
+
+            // Drops the entries of pools destroyed since, so a long-lived thread doesn't pile up one
+            // per pool it ever touched
+            void pruneDeadPools();
+
+            static SlabThreadState& current()
+            {
+                static thread_local SlabThreadState s_state;
+                return s_state;
+            }
+
+            // Ids of the pools still alive, a cache may only be touched while its pool's id is in here
+            static SpinMutex& registryMutex()
+            {
+                static SpinMutex s_mutex;
+                return s_mutex;
+            }
+
+            static std::unordered_set<uint64_t>& livePools()
+            {
+                static std::unordered_set<uint64_t> s_pools;
+                return s_pools;
+            }
+
+            uint64_t                lastPoolId;
+            SlabPool::ThreadCache*  lastCache;
+            std::vector<Entry>      entries;
+        };
+
+        SlabThreadState::~SlabThreadState()
+        {
+            SpinLock lock(registryMutex());
+            for(size_t i = 0; i < entries.size(); ++i)
+            {
+                if(livePools().count(entries[i].poolId) != 0)
+                    entries[i].cache->threadId.store(0, std::memory_order_release);
+            }
+        }
+
+        void SlabThreadState::pruneDeadPools()
+        {
+            SpinLock lock(registryMutex());
+            size_t kept = 0;
+            for(size_t i = 0; i < entries.size(); ++i)
+            {
+                if(livePools().count(entries[i].poolId) != 0)
+                    entries[kept++] = entries[i];
+            }
+            entries.resize(kept);
+        }
+    }
+
+    double SlabStats::hitRate() const
+    {
+        return allocations == 0 ? 0.0 : static_cast<double>(cacheHits) / static_cast<double>(allocations);
+    }
+
+    static uint64_t nextPoolId()
+    {
+        static std::atomic<uint64_t> s_nextId(1);
+        return s_nextId.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    SlabPool::SlabPool(size_t blockSize, size_t alignment, bool hugePages) : m_blockSize(blockSize), m_alignment(alignment),
+        m_stride(roundUp(blockSize > sizeof(Block) ? blockSize : sizeof(Block), alignment)), m_firstBlock(roundUp(sizeof(Slab), alignment)),
+        m_hugePages(hugePages), m_id(nextPoolId()), m_caches(nullptr), m_arenaCursor(nullptr), m_arenaEnd(nullptr), m_numSlabs(0)
+    {
+        assert((alignment & (alignment - 1)) == 0);
+        assert(m_firstBlock + m_stride <= DEFAULT_SLAB_SIZE / 4); // A slab should hold a decent number of blocks
+
+        SpinLock lock(Detail::SlabThreadState::registryMutex());
+        Detail::SlabThreadState::livePools().insert(m_id);
+    }
+
+    SlabPool::~SlabPool()
+    {
+        {
+            SpinLock lock(Detail::SlabThreadState::registryMutex());
+            Detail::SlabThreadState::livePools().erase(m_id);
+        }
+
+        while(m_caches != nullptr)
+        {
+            ThreadCache* cache = m_caches;
+            m_caches = cache->next;
+            delete cache;
+        }
+
+        for(size_t i = 0; i < m_arenas.size(); ++i)
+        {
+        #if defined(_WIN32)
+            _aligned_free(m_arenas[i]);
+        #else
+            munmap(m_arenas[i], DEFAULT_SLAB_ARENA_SIZE);
+        #endif
+        }
+    }
+
+    size_t SlabPool::blockSize() const
+    {
+        return m_blockSize;
+    }
+
+    SlabPool::ThreadCache* SlabPool::localCache()
+    {
+        Detail::SlabThreadState& state = Detail::SlabThreadState::current();
+        if(state.lastPoolId == m_id)
+            return state.lastCache;
+
+        ThreadCache* cache = nullptr;
+        for(size_t i = 0; i < state.entries.size(); ++i)
+        {
+            if(state.entries[i].poolId == m_id)
+            {
+                cache = state.entries[i].cache;
+                break;
+            }
+        }
+        if(cache == nullptr)
+        {
+            // Already the slow path, a good time to forget about pools that are gone
+            state.pruneDeadPools();
+            cache = acquireCache();
+            Detail::SlabThreadState::Entry entry = { m_id, cache };
+            state.entries.push_back(entry);
+        }
+
+        state.lastPoolId = m_id;
+        state.lastCache = cache;
+        return cache;
+    }
+
+    SlabPool::ThreadCache* SlabPool::acquireCache()
+    {
+        const size_t threadId = currentThreadId();
+        SpinLock lock(m_mutex);
+
+        // Adopt the cache of a thread that exited, with its slabs and whatever was freed into it
+        for(ThreadCache* cache = m_caches; cache != nullptr; cache = cache->next)
+        {
+            size_t expected = 0;
+            if(cache->threadId.compare_exchange_strong(expected, threadId, std::memory_order_acquire))
+                return cache;
+        }
+
+        ThreadCache* cache = new ThreadCache();
+        cache->threadId.store(threadId, std::memory_order_relaxed);
+        cache->next = m_caches;
+        m_caches = cache;
+        return cache;
+    }
+
+    void* SlabPool::allocate()
+    {
+        ThreadCache& cache = *localCache();
+        cache.allocations.store(cache.allocations.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        Block* block = cache.freeList;
+        if(block != nullptr)
+        {
+            cache.freeList = block->next;
+            cache.cacheHits.store(cache.cacheHits.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return block;
+        }
+
+        refill(cache);
+        block = cache.freeList;
+        cache.freeList = block->next;
+        return block;
+    }
+
+    void SlabPool::refill(ThreadCache& cache)
+    {
+        // Take back everything other threads freed in one go
+        Block* remote = cache.remoteFrees.exchange(nullptr, std::memory_order_acquire);
+        if(remote != nullptr)
+        {
+            cache.freeList = remote;
+            return;
+        }
+
+        if(cache.cursor == cache.end)
+            newSlab(cache);
+
+        Block* block = reinterpret_cast<Block*>(cache.cursor);
+        block->next = nullptr;
+        cache.freeList = block;
+        cache.cursor += m_stride;
+    }
+
+    void SlabPool::newSlab(ThreadCache& cache)
+    {
+        SpinLock lock(m_mutex);
+        if(m_arenaCursor == m_arenaEnd)
+            newArena();
+
+        char* slab = m_arenaCursor;
+        m_arenaCursor += DEFAULT_SLAB_SIZE;
+        ++m_numSlabs;
+
+        reinterpret_cast<Slab*>(slab)->owner = &cache;
+        cache.cursor = slab + m_firstBlock;
+        cache.end = cache.cursor + ((DEFAULT_SLAB_SIZE - m_firstBlock) / m_stride) * m_stride;
+    }
+
+    void SlabPool::newArena()
+    {
+        // Called with m_mutex held
+    #if defined(_WIN32)
+        void* arena = _aligned_malloc(DEFAULT_SLAB_ARENA_SIZE, DEFAULT_SLAB_ARENA_SIZE);
+        if(arena == nullptr)
+            throw std::bad_alloc();
+    #else
+        // Map twice the size and trim, mmap only guarantees page alignment
+        const size_t mapped = 2 * DEFAULT_SLAB_ARENA_SIZE;
+        char* region = static_cast<char*>(mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        if(region == MAP_FAILED)
+            throw std::bad_alloc();
+
+        char* arena = reinterpret_cast<char*>(roundUp(reinterpret_cast<uintptr_t>(region), DEFAULT_SLAB_ARENA_SIZE));
+        if(arena != region)
+            munmap(region, arena - region);
+        munmap(arena + DEFAULT_SLAB_ARENA_SIZE, (region + mapped) - (arena + DEFAULT_SLAB_ARENA_SIZE));
+        #if defined(MADV_HUGEPAGE)
+            if(m_hugePages)
+                madvise(arena, DEFAULT_SLAB_ARENA_SIZE, MADV_HUGEPAGE);
+        #endif
+    #endif
+
+        m_arenas.push_back(arena);
+        m_arenaCursor = static_cast<char*>(arena);
+        m_arenaEnd = m_arenaCursor + DEFAULT_SLAB_ARENA_SIZE;
+    }
+
+    void SlabPool::deallocate(void* pointer)
+    {
+        if(pointer == nullptr)
+            return;
+
+        Block* block = static_cast<Block*>(pointer);
+        const Slab* slab = reinterpret_cast<const Slab*>(reinterpret_cast<uintptr_t>(pointer) & ~static_cast<uintptr_t>(DEFAULT_SLAB_SIZE - 1));
+        ThreadCache& owner = *slab->owner;
+
+        // Only the owning thread can have stored its own id, so a match needs no ordering
+        if(owner.threadId.load(std::memory_order_relaxed) == currentThreadId())
+        {
+            block->next = owner.freeList;
+            owner.freeList = block;
+            return;
+        }
+
+        Block* head = owner.remoteFrees.load(std::memory_order_relaxed);
+        do
+        {
+            block->next = head;
+        }
+        while(!owner.remoteFrees.compare_exchange_weak(head, block, std::memory_order_release, std::memory_order_relaxed));
+        owner.numRemoteFrees.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    SlabStats SlabPool::stats() const
+    {
+        SlabStats stats = SlabStats();
+        SpinLock lock(m_mutex);
+        for(const ThreadCache* cache = m_caches; cache != nullptr; cache = cache->next)
+        {
+            stats.allocations += cache->allocations.load(std::memory_order_relaxed);
+            stats.cacheHits += cache->cacheHits.load(std::memory_order_relaxed);
+            stats.remoteFrees += cache->numRemoteFrees.load(std::memory_order_relaxed);
+            ++stats.threadCaches;
+        }
+        stats.slabs = m_numSlabs;
+        return stats;
+    }
+
+    SlabPool& SlabPool::forSize(size_t size, size_t alignment)
+    {
+        // Size classes every 16 bytes. A class's blocks are aligned to the lowest set bit of its
+        // size, which covers alignment since sizeof is always a multiple of alignof.
+        static const size_t CLASS_GRANULARITY = 16;
+        static const size_t NUM_CLASSES = MAX_SLAB_BLOCK_SIZE / CLASS_GRANULARITY;
+        static std::atomic<SlabPool*> s_classes[NUM_CLASSES];
+
+        const size_t rounded = roundUp(size == 0 ? 1 : size, CLASS_GRANULARITY);
+        assert(rounded <= MAX_SLAB_BLOCK_SIZE);
+        size_t classAlignment = rounded & (~rounded + 1);
+        if(classAlignment > CACHE_LINE_SIZE)
+            classAlignment = CACHE_LINE_SIZE;
+        assert(alignment <= classAlignment);
+        (void)alignment;
+
+        std::atomic<SlabPool*>& entry = s_classes[rounded / CLASS_GRANULARITY - 1];
+        SlabPool* pool = entry.load(std::memory_order_acquire);
+        if(pool != nullptr)
+            return *pool;
+
+        SlabPool* created = new SlabPool(rounded, classAlignment);
+        if(entry.compare_exchange_strong(pool, created, std::memory_order_acq_rel))
+            return *created;
+        delete created;
+        return *pool;
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,302 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Thread-caching slab allocator for fixed size objects
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "../CacheLine.h"
+#include "../Mutex/SpinMutex.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    // Size and alignment of a slab, the unit a thread takes from its pool. Must be a power of two.
+    #ifndef DEFAULT_SLAB_SIZE
+        #define DEFAULT_SLAB_SIZE (64 * 1024)
+    #endif
+
+    // Slabs are cut from arenas of this size, aligned to it so they can be backed by huge pages
+    #ifndef DEFAULT_SLAB_ARENA_SIZE
+        #define DEFAULT_SLAB_ARENA_SIZE (2 * 1024 * 1024)
+    #endif
+
+    // Largest block SlabAllocator serves from a slab, bigger ones go to operator new
+    #ifndef MAX_SLAB_BLOCK_SIZE
+        #define MAX_SLAB_BLOCK_SIZE 1024
+    #endif
+
+    namespace Detail
+    {
+        struct SlabThreadState;
+    }
+
+    /*! \brief Counters of a SlabPool, summed over its thread caches
+    */
+    struct SlabStats
+    {
+        // Blocks handed out, and how many of those came straight from the thread's own free list
+        uint64_t    allocations;
+        uint64_t    cacheHits;
+        // Blocks freed by a thread other than the one whose cache they belong to
+        uint64_t    remoteFrees;
+        size_t      slabs;
+        size_t      threadCaches;
+
+        double      hitRate() const;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief SlabPool hands out blocks of one size. Every thread gets a cache of its own, a free
+        list plus the slabs it carves new blocks from, so allocating and freeing on the same thread
+        touches no shared state at all.
+
+        Every slab belongs to one thread cache, found by masking a block's address down to the slab
+        size. A block freed on another thread is pushed onto that cache's remote free list with a
+        single compare-exchange; the owner takes the whole list back in one exchange when its own
+        free list runs dry. Producer / consumer patterns, where one thread allocates and another
+        frees, thus cost one atomic per free instead of a trip through the global allocator.
+
+        The cache of a thread that exits is kept, free blocks and all, for the next new thread.
+        Memory goes back to the system only when the pool is destroyed, which must not happen
+        before every block is freed.
+
+        With hugePages the arenas are backed by transparent huge pages on Linux, cutting TLB misses
+        for pools holding many objects. It is only a hint elsewhere.
+    */
+    class SlabPool
+    {
+    public:
+        /*! \brief Pool of blocks of at least blockSize bytes, aligned to alignment (a power of two)
+        */
+        SlabPool(size_t blockSize, size_t alignment = alignof(std::max_align_t), bool hugePages = false);
+        ~SlabPool();
+
+        void*       allocate();
+        void        deallocate(void* block);
+
+        size_t      blockSize() const;
+        SlabStats   stats() const;
+
+        /*! \brief Process-wide pool for blocks of size bytes and alignment, shared by every
+            SlabAllocator. Never destroyed.
+        */
+        static SlabPool& forSize(size_t size, size_t alignment);
+
+    private:
+        struct Block
+        {
+            Block*  next;
+        };
+
+        struct ThreadCache;
+        struct Slab;
+
+        ThreadCache*    localCache();
+        ThreadCache*    acquireCache();
+        void            refill(ThreadCache& cache);
+        void            newSlab(ThreadCache& cache);
+        void            newArena();
+
+        const size_t    m_blockSize;
+        const size_t    m_alignment;
+        // Distance between blocks, and offset of the first one past the slab header
+        const size_t    m_stride;
+        const size_t    m_firstBlock;
+        const bool      m_hugePages;
+        // Never reused, tells thread state of a destroyed pool from that of a new one at the same address
+        const uint64_t  m_id;
+
+        SpinMutex       m_mutex;
+        ThreadCache*    m_caches;
+        std::vector<void*> m_arenas;
+        char*           m_arenaCursor;
+        char*           m_arenaEnd;
+        size_t          m_numSlabs;
+
+        friend struct Detail::SlabThreadState;
+
+        SlabPool(const SlabPool&);
+        SlabPool(SlabPool&&);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief ConcurrentSlab is a SlabPool of objects of type T
+
+        \code
+        ConcurrentSlab<Order> orders;
+        Order* order = orders.create(id, price);
+        ...
+        // On any thread
+        orders.destroy(order);
+        \endcode
+    */
+    template <typename T>
+    class ConcurrentSlab
+    {
+    public:
+        explicit ConcurrentSlab(bool hugePages = false);
+
+        /*! \brief Uninitialized storage for one T
+        */
+        T*          allocate();
+        void        deallocate(T* object);
+
+        template <typename... Args>
+        T*          create(Args&&... args);
+        void        destroy(T* object);
+
+        SlabStats   stats() const;
+
+    private:
+        SlabPool    m_pool;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief SlabAllocator is a standard allocator that serves single objects up to
+        MAX_SLAB_BLOCK_SIZE bytes from the process-wide SlabPool for their size, which is what
+        node based containers (std::list, std::map, std::unordered_map...) allocate. Arrays and
+        bigger objects go to operator new. It is stateless, so all instances compare equal and
+        memory can be freed through any of them, on any thread.
+
+        \code
+        std::map<Key, Value, std::less<Key>, SlabAllocator<std::pair<const Key, Value> > > index;
+        \endcode
+    */
+    template <typename T>
+    class SlabAllocator
+    {
+    public:
+        typedef T           value_type;
+        typedef T*          pointer;
+        typedef const T*    const_pointer;
+        typedef T&          reference;
+        typedef const T&    const_reference;
+        typedef size_t      size_type;
+        typedef ptrdiff_t   difference_type;
+
+        template <typename U>
+        struct rebind
+        {
+            typedef SlabAllocator<U> other;
+        };
+
+        SlabAllocator() {}
+        template <typename U>
+        SlabAllocator(const SlabAllocator<U>&) {}
+
+        T*      allocate(size_t count);
+        void    deallocate(T* object, size_t count);
+
+        template <typename U, typename... Args>
+        void    construct(U* object, Args&&... args)    { new (object) U(std::forward<Args>(args)...); }
+        template <typename U>
+        void    destroy(U* object)                      { object->~U(); }
+        size_t  max_size() const                        { return ~size_t(0) / sizeof(T); }
+
+    private:
+        static bool fromSlab(size_t count);
+    };
+
+    template <typename T, typename U>
+    bool operator==(const SlabAllocator<T>&, const SlabAllocator<U>&)
+    {
+        return true;
+    }
+
+    template <typename T, typename U>
+    bool operator!=(const SlabAllocator<T>&, const SlabAllocator<U>&)
+    {
+        return false;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    template <typename T>
+    ConcurrentSlab<T>::ConcurrentSlab(bool hugePages) : m_pool(sizeof(T), alignof(T), hugePages)
+    {
+    }
+
+    template <typename T>
+    T* ConcurrentSlab<T>::allocate()
+    {
+        return static_cast<T*>(m_pool.allocate());
+    }
+
+    template <typename T>
+    void ConcurrentSlab<T>::deallocate(T* object)
+    {
+        m_pool.deallocate(object);
+    }
+
+    template <typename T>
+    template <typename... Args>
+    T* ConcurrentSlab<T>::create(Args&&... args)
+    {
+        return new (allocate()) T(std::forward<Args>(args)...);
+    }
+
+    template <typename T>
+    void ConcurrentSlab<T>::destroy(T* object)
+    {
+        if(object == nullptr)
+            return;
+        object->~T();
+        deallocate(object);
+    }
+
+    template <typename T>
+    SlabStats ConcurrentSlab<T>::stats() const
+    {
+        return m_pool.stats();
+    }
+
+    template <typename T>
+    bool SlabAllocator<T>::fromSlab(size_t count)
+    {
+        return count == 1 && sizeof(T) <= MAX_SLAB_BLOCK_SIZE && alignof(T) <= CACHE_LINE_SIZE;
+    }
+
+    template <typename T>
+    T* SlabAllocator<T>::allocate(size_t count)
+    {
+        if(fromSlab(count))
+        {
+            // Looked up once per type
+            static SlabPool& s_pool = SlabPool::forSize(sizeof(T), alignof(T));
+            return static_cast<T*>(s_pool.allocate());
+        }
+        return std::allocator<T>().allocate(count);
+    }
+
+    template <typename T>
+    void SlabAllocator<T>::deallocate(T* object, size_t count)
+    {
+        if(fromSlab(count))
+        {
+            static SlabPool& s_pool = SlabPool::forSize(sizeof(T), alignof(T));
+            s_pool.deallocate(object);
+            return;
+        }
+        std::allocator<T>().deallocate(object, count);
+    }
+
+}
\ No newline at end of file
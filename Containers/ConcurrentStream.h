@@ -8,6 +8,7 @@
 
 #include "AbstractQueue.h"
 
+#include <cassert>
 #include <new>
 
 namespace DX
@@ -43,16 +44,17 @@ namespace DX
     template <typename T>
     ConcurrentStream<T>::ConcurrentStream() : Queue<T>()
     {
-        m_start = new Node<T>();
-        m_end = m_start;
-        assert(m_start != nullptr);
+        this->m_start = new Node<T>();
+        this->m_end = this->m_start;
+        assert(this->m_start != nullptr);
     }
 
     template <typename T>
-    ConcurrentStream<T>::ConcurrentStream(const ConcurrentStream& copy)
+    ConcurrentStream<T>::ConcurrentStream(const ConcurrentStream& copy) : Queue<T>()
     {
-        m_start = new Node<T>();
-        assert(m_start != nullptr);
+        this->m_start = new Node<T>();
+        this->m_end = this->m_start;
+        assert(this->m_start != nullptr);
         assert(copy.m_start != nullptr);
 
         Node<T>* currentNode = copy.m_start->next;
@@ -65,24 +67,25 @@ namespace DX
     }
 
     template <typename T>
-    ConcurrentStream<T>::ConcurrentStream(ConcurrentStream&& move)
+    ConcurrentStream<T>::ConcurrentStream(ConcurrentStream&& move) : Queue<T>()
     {
-        m_start = new Node<T>();
-        m_start->next = move.m_start->next;
+        this->m_start = new Node<T>();
+        this->m_start->next = move.m_start->next.load();
         move.m_start->next = nullptr;
         if(move.m_end == move.m_start)
         {
-            m_end = m_start;
+            this->m_end = this->m_start;
         }
         else
         {
+            this->m_end = move.m_end;
             move.m_end = move.m_start;
-            m_end = move.m_end;
         }
+        this->m_size = move.m_size.load();
         move.m_size = 0;
 
-        assert(m_start != nullptr);
-        assert(m_end != nullptr);
+        assert(this->m_start != nullptr);
+        assert(this->m_end != nullptr);
     }
 
     template <typename T>
@@ -90,19 +93,19 @@ namespace DX
     {
         clear();
         
-        delete m_start->data;
-        m_start->data = nullptr;
-        delete m_start;
-        m_start = nullptr;
+        delete this->m_start->data;
+        this->m_start->data = nullptr;
+        delete this->m_start;
+        this->m_start = nullptr;
     }
 
     template <typename T>
     void ConcurrentStream<T>::clear()
     {
-        while(m_start->next.load() != nullptr)
+        while(this->m_start->next.load() != nullptr)
         {
-            Node<T>* currentNode = m_start;
-            m_start = currentNode->next.load();
+            Node<T>* currentNode = this->m_start;
+            this->m_start = currentNode->next.load();
             if(currentNode->data != nullptr)
             {
                 delete currentNode->data;
@@ -116,44 +119,47 @@ namespace DX
     template <typename T>
     bool ConcurrentStream<T>::isEmpty() const
     {
-        return m_size == 0;
+        return this->m_size == 0;
     }
 
     template <typename T>
     size_t ConcurrentStream<T>::size() const
     {
-        return m_size;
+        return this->m_size;
     }
 
     template <typename T>
     bool ConcurrentStream<T>::front(T& out) const
     {
-        assert(m_start);
-        if(m_start->next.load() == nullptr)
+        assert(this->m_start);
+        if(this->m_start->next.load() == nullptr)
             return false;
-        if(m_start->next.load()->data == nullptr)
+        if(this->m_start->next.load()->data == nullptr)
             return false;
 
-        out = *(m_start->next.load()->data);
+        out = *(this->m_start->next.load()->data);
         return true;
     }
 
     template <typename T>
     bool ConcurrentStream<T>::pop(T& out)
     {
-        assert(m_start != nullptr);
+        assert(this->m_start != nullptr);
 
-        Node<T>* newStart = m_start->next.load();
+        Node<T>* newStart = this->m_start->next.load();
         if(newStart == nullptr)
             return false;
 
-        Node<T>* oldStart = m_start;
-        m_start = newStart;
+        Node<T>* oldStart = this->m_start;
+        this->m_start = newStart;
 
-        assert(m_start->data != nullptr);
-        out = std::move(*(m_start->data));
-        assert(m_size > 0);
-        --m_size;
+        assert(this->m_start->data != nullptr);
+        out = std::move(*(this->m_start->data));
+        assert(this->m_size > 0);
+        --this->m_size;
+        #ifdef DX_QUEUE_TELEMETRY
+            this->m_telemetry.popped(this->m_start->pushedAt);
+        #endif
 
         delete oldStart->data;
         // Only null out what used to be there in DEBUG mode
@@ -171,39 +177,53 @@ namespace DX
     template <typename T>
     void ConcurrentStream<T>::push(const T& in)
     {
-        assert(m_end != nullptr);
+        assert(this->m_end != nullptr);
 
         Node<T>* temp = new (std::nothrow) Node<T>(new (std::nothrow) T(in));
         assert(temp != nullptr);
         assert(temp->data != nullptr);
+        #ifdef DX_QUEUE_TELEMETRY
+            this->m_telemetry.pushing(temp->pushedAt);
+        #endif
 
          /*
             Increment size before updating the Node's next ptr so we never have 
             the case of the queue reporting a size smaller than it is - bigger
             is ok.
         */
-        ++m_size;
-        m_end->next = temp;
-        m_end = temp;
+        ++this->m_size;
+        this->m_end->next = temp;
+        this->m_end = temp;
+        #ifdef DX_QUEUE_TELEMETRY
+            this->m_telemetry.sizeIs(this->m_size.load(std::memory_order_relaxed));
+        #endif
+        this->m_readiness.notify();
     }
 
     template <typename T>
     void ConcurrentStream<T>::push(T&& moveIn)
     {
-        assert(m_end != nullptr);
+        assert(this->m_end != nullptr);
 
         Node<T>* temp = new (std::nothrow) Node<T>(new (std::nothrow) T(moveIn));
         assert(temp != nullptr);
         assert(temp->data != nullptr);
+        #ifdef DX_QUEUE_TELEMETRY
+            this->m_telemetry.pushing(temp->pushedAt);
+        #endif
 
          /*
             Increment size before updating the Node's next ptr so we never have 
             the case of the queue reporting a size smaller than it is - bigger
             is ok.
         */
-        ++m_size;
-        m_end->next = temp;
-        m_end = temp;
+        ++this->m_size;
+        this->m_end->next = temp;
+        this->m_end = temp;
+        #ifdef DX_QUEUE_TELEMETRY
+            this->m_telemetry.sizeIs(this->m_size.load(std::memory_order_relaxed));
+        #endif
+        this->m_readiness.notify();
     }
 
 }
\ No newline at end of file
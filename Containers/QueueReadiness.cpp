@@ -0,0 +1,115 @@
+
+#include "QueueReadiness.h"
+
+#if defined(__linux__)
+    #include <cerrno>
+    #include <cstdint>
+    #include <sys/eventfd.h>
+    #include <unistd.h>
+#elif !defined(_WIN32)
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    QueueReadiness::QueueReadiness() : m_readFd(-1), m_writeFd(-1), m_ready(false)
+    {
+    }
+
+    QueueReadiness::~QueueReadiness()
+    {
+    #if !defined(_WIN32)
+        const int readFd = m_readFd.load();
+        if(readFd >= 0)
+            close(readFd);
+        if(m_writeFd >= 0 && m_writeFd != readFd)
+            close(m_writeFd);
+    #endif
+    }
+
+    int QueueReadiness::fd()
+    {
+        const int readFd = m_readFd.load(std::memory_order_acquire);
+        if(readFd >= 0)
+            return readFd;
+
+        SpinLock lock(m_createMutex);
+        if(m_readFd.load(std::memory_order_relaxed) >= 0)
+            return m_readFd.load(std::memory_order_relaxed);
+
+    #if defined(__linux__)
+        const int created = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if(created < 0)
+            return -1;
+        m_writeFd = created;
+        // Items pushed before the fd existed must still wake the first wait
+        m_ready.store(true, std::memory_order_relaxed);
+        signalFd();
+        m_readFd.store(created, std::memory_order_release);
+        return created;
+    #elif !defined(_WIN32)
+        int ends[2];
+        if(pipe(ends) != 0)
+            return -1;
+        for(int i = 0; i < 2; ++i)
+        {
+            fcntl(ends[i], F_SETFL, fcntl(ends[i], F_GETFL) | O_NONBLOCK);
+            fcntl(ends[i], F_SETFD, FD_CLOEXEC);
+        }
+        m_writeFd = ends[1];
+        m_ready.store(true, std::memory_order_relaxed);
+        signalFd();
+        m_readFd.store(ends[0], std::memory_order_release);
+        return ends[0];
+    #else
+        return -1;
+    #endif
+    }
+
+    void QueueReadiness::signalFd()
+    {
+    #if defined(__linux__)
+        const uint64_t one = 1;
+        while(write(m_writeFd, &one, sizeof(one)) < 0 && errno == EINTR)
+            ;
+    #elif !defined(_WIN32)
+        // A full pipe is readable already, so EAGAIN is fine
+        const char one = 1;
+        while(write(m_writeFd, &one, sizeof(one)) < 0 && errno == EINTR)
+            ;
+    #endif
+    }
+
+    void QueueReadiness::clear()
+    {
+        const int readFd = m_readFd.load(std::memory_order_acquire);
+        if(readFd < 0)
+            return;
+
+        // Empty the fd first: a push that writes after this leaves it readable, one that wrote
+        // before this finds the flag cleared below and writes again
+    #if defined(__linux__)
+        uint64_t count;
+        while(read(readFd, &count, sizeof(count)) < 0 && errno == EINTR)
+            ;
+    #elif !defined(_WIN32)
+        char drained[64];
+        for(;;)
+        {
+            const ssize_t bytes = read(readFd, drained, sizeof(drained));
+            if(bytes == static_cast<ssize_t>(sizeof(drained)) || (bytes < 0 && errno == EINTR))
+                continue;
+            break;
+        }
+    #endif
+        m_ready.store(false, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+}
\ No newline at end of file
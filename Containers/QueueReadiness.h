@@ -0,0 +1,85 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Pollable file descriptor that signals a queue has items, for event loops
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "../CacheLine.h"
+#include "../Mutex/SpinMutex.h"
+
+#include <atomic>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief QueueReadiness lets a thread that sleeps in epoll / poll / select wait for a queue too.
+        It owns a file descriptor (an eventfd on Linux, a non-blocking pipe on other POSIX systems)
+        that is created on first use, producers never touch it until then.
+
+        Wake-ups are coalesced: only the first push after the consumer re-armed writes to the fd,
+        every push after that sees the ready flag already set and skips the system call. So a burst
+        of pushes into an empty queue costs one write, and pushes into a queue the consumer hasn't
+        drained yet cost none.
+
+        The consumer side goes: wait for the fd to be readable, clear(), then pop until pop() fails.
+        clear() has to come before the draining, otherwise a push landing in between is missed.
+
+        \note Not available on Windows, fd() returns -1 there.
+    */
+    class DX_CACHE_ALIGNED QueueReadiness
+    {
+    public:
+        QueueReadiness();
+        ~QueueReadiness();
+
+        /*! \brief The readable end of the descriptor, created on the first call. Returns -1 if the
+            platform has none or creating it failed.
+        */
+        int  fd();
+        bool isEnabled() const;
+
+        /*! \brief Called by producers once the item is linked and visible to pop()
+        */
+        void notify();
+        /*! \brief Called by the consumer before draining: empties the fd and re-arms notify()
+        */
+        void clear();
+
+    private:
+        void signalFd();
+
+        std::atomic<int>    m_readFd;
+        int                 m_writeFd;
+        // Set by the push that wrote the fd, until the consumer clears it
+        std::atomic<bool>   m_ready;
+        SpinMutex           m_createMutex;
+
+        QueueReadiness(const QueueReadiness&);
+        QueueReadiness(QueueReadiness&&);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    inline bool QueueReadiness::isEnabled() const
+    {
+        return m_readFd.load(std::memory_order_acquire) >= 0;
+    }
+
+    inline void QueueReadiness::notify()
+    {
+        if(!isEnabled())
+            return;
+        // Pairs with the fence in clear(): either the consumer's drain sees our item or we see
+        // the flag it cleared
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(m_ready.load(std::memory_order_relaxed))
+            return;
+        if(!m_ready.exchange(true, std::memory_order_acq_rel))
+            signalFd();
+    }
+
+}
\ No newline at end of file
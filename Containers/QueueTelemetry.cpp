@@ -0,0 +1,170 @@
+
+#include "QueueTelemetry.h"
+#include "../Threading/ThreadId.h"
+
+#include <chrono>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    static size_t sojournBucket(uint64_t nanoseconds)
+    {
+        size_t bucket = 0;
+        while(nanoseconds != 0 && bucket < SOJOURN_HISTOGRAM_BUCKETS - 1)
+        {
+            nanoseconds >>= 1;
+            ++bucket;
+        }
+        return bucket;
+    }
+
+    // Upper bound of the bucket holding the given fraction of samples
+    static uint64_t sojournPercentile(const uint64_t (&histogram)[SOJOURN_HISTOGRAM_BUCKETS], uint64_t total, double fraction)
+    {
+        if(total == 0)
+            return 0;
+
+        const uint64_t target = static_cast<uint64_t>(fraction * static_cast<double>(total - 1)) + 1;
+        uint64_t seen = 0;
+        for(size_t i = 0; i < SOJOURN_HISTOGRAM_BUCKETS; ++i)
+        {
+            seen += histogram[i];
+            if(seen >= target)
+                return i == 0 ? 0 : (uint64_t(1) << i) - 1;
+        }
+        return uint64_t(1) << (SOJOURN_HISTOGRAM_BUCKETS - 1);
+    }
+
+    QueueTelemetry::QueueTelemetry()
+    {
+        reset();
+    }
+
+    QueueTelemetry::~QueueTelemetry()
+    {
+    }
+
+    uint64_t QueueTelemetry::now()
+    {
+        const uint64_t nanoseconds = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+        // 0 means "not sampled"
+        return nanoseconds == 0 ? 1 : nanoseconds;
+    }
+
+    QueueTelemetry::Slot& QueueTelemetry::slot()
+    {
+        return m_slots[currentThreadId() % DEFAULT_TELEMETRY_SLOTS];
+    }
+
+    void QueueTelemetry::pushing(uint64_t& pushedAt)
+    {
+        const uint64_t pushes = slot().pushes.fetch_add(1, std::memory_order_relaxed);
+        pushedAt = (pushes & (DEFAULT_SOJOURN_SAMPLE_PERIOD - 1)) == 0 ? now() : 0;
+    }
+
+    void QueueTelemetry::sizeIs(size_t size)
+    {
+        // Only pay for a read-modify-write when there's a new maximum
+        size_t highWaterMark = m_highWaterMark.load(std::memory_order_relaxed);
+        while(size > highWaterMark
+            && !m_highWaterMark.compare_exchange_weak(highWaterMark, size, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void QueueTelemetry::popped(uint64_t pushedAt)
+    {
+        Slot& mySlot = slot();
+        mySlot.pops.fetch_add(1, std::memory_order_relaxed);
+        if(pushedAt == 0)
+            return;
+
+        const uint64_t sojourn = now() - pushedAt;
+        mySlot.sojournSamples.fetch_add(1, std::memory_order_relaxed);
+        mySlot.sojournNanoseconds.fetch_add(sojourn, std::memory_order_relaxed);
+        mySlot.sojournHistogram[sojournBucket(sojourn)].fetch_add(1, std::memory_order_relaxed);
+
+        uint64_t maxSojourn = mySlot.maxSojournNanoseconds.load(std::memory_order_relaxed);
+        while(sojourn > maxSojourn
+            && !mySlot.maxSojournNanoseconds.compare_exchange_weak(maxSojourn, sojourn, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    QueueTelemetrySnapshot QueueTelemetry::snapshot() const
+    {
+        QueueTelemetrySnapshot result = QueueTelemetrySnapshot();
+        uint64_t histogram[SOJOURN_HISTOGRAM_BUCKETS] = {};
+        uint64_t sojournNanoseconds = 0;
+
+        for(size_t i = 0; i < DEFAULT_TELEMETRY_SLOTS; ++i)
+        {
+            const Slot& current = m_slots[i];
+            result.pushes += current.pushes.load(std::memory_order_relaxed);
+            result.pops += current.pops.load(std::memory_order_relaxed);
+            result.sojournSamples += current.sojournSamples.load(std::memory_order_relaxed);
+            sojournNanoseconds += current.sojournNanoseconds.load(std::memory_order_relaxed);
+            const uint64_t maxSojourn = current.maxSojournNanoseconds.load(std::memory_order_relaxed);
+            if(maxSojourn > result.maxSojournNanoseconds)
+                result.maxSojournNanoseconds = maxSojourn;
+            for(size_t b = 0; b < SOJOURN_HISTOGRAM_BUCKETS; ++b)
+                histogram[b] += current.sojournHistogram[b].load(std::memory_order_relaxed);
+        }
+
+        result.highWaterMark = m_highWaterMark.load(std::memory_order_relaxed);
+        result.meanSojournNanoseconds = result.sojournSamples == 0 ? 0 : sojournNanoseconds / result.sojournSamples;
+
+        // The percentiles come from the histogram, so they're only bucket-accurate
+        uint64_t histogramSamples = 0;
+        for(size_t b = 0; b < SOJOURN_HISTOGRAM_BUCKETS; ++b)
+            histogramSamples += histogram[b];
+        result.p50SojournNanoseconds = sojournPercentile(histogram, histogramSamples, 0.5);
+        result.p99SojournNanoseconds = sojournPercentile(histogram, histogramSamples, 0.99);
+        if(result.p50SojournNanoseconds > result.maxSojournNanoseconds)
+            result.p50SojournNanoseconds = result.maxSojournNanoseconds;
+        if(result.p99SojournNanoseconds > result.maxSojournNanoseconds)
+            result.p99SojournNanoseconds = result.maxSojournNanoseconds;
+
+        {
+            SpinLock _lock(m_intervalMutex);
+            const uint64_t intervalEnd = now();
+            result.intervalSeconds = static_cast<double>(intervalEnd - m_intervalStart) * 1e-9;
+            if(result.intervalSeconds > 0.0)
+            {
+                result.pushesPerSecond = static_cast<double>(result.pushes - m_intervalPushes) / result.intervalSeconds;
+                result.popsPerSecond = static_cast<double>(result.pops - m_intervalPops) / result.intervalSeconds;
+            }
+            m_intervalStart = intervalEnd;
+            m_intervalPushes = result.pushes;
+            m_intervalPops = result.pops;
+        }
+
+        return result;
+    }
+
+    void QueueTelemetry::reset()
+    {
+        for(size_t i = 0; i < DEFAULT_TELEMETRY_SLOTS; ++i)
+        {
+            Slot& current = m_slots[i];
+            current.pushes = 0;
+            current.pops = 0;
+            current.sojournSamples = 0;
+            current.sojournNanoseconds = 0;
+            current.maxSojournNanoseconds = 0;
+            for(size_t b = 0; b < SOJOURN_HISTOGRAM_BUCKETS; ++b)
+                current.sojournHistogram[b] = 0;
+        }
+        m_highWaterMark = 0;
+
+        SpinLock _lock(m_intervalMutex);
+        m_intervalStart = now();
+        m_intervalPushes = 0;
+        m_intervalPops = 0;
+    }
+
+}
\ No newline at end of file
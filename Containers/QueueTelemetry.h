@@ -0,0 +1,121 @@
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Occupancy, sojourn time and throughput counters for the queues
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "../CacheLine.h"
+#include "../Mutex/SpinMutex.h"
+
+#include <atomic>
+#include <cstdint>
+
+/*
+    Define DX_QUEUE_TELEMETRY (for the library and everything including it, since it changes the
+    layout of the queues and their nodes) to have ConcurrentQueue and ConcurrentStream keep a
+    QueueTelemetry. Without it the queues record nothing and cost nothing extra.
+*/
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    // Number of per-thread counter slots, threads beyond that share slots
+    #ifndef DEFAULT_TELEMETRY_SLOTS
+        #define DEFAULT_TELEMETRY_SLOTS 16
+    #endif
+
+    // One in this many pushes per slot is timestamped for sojourn time, must be a power of two
+    #ifndef DEFAULT_SOJOURN_SAMPLE_PERIOD
+        #define DEFAULT_SOJOURN_SAMPLE_PERIOD 64
+    #endif
+
+    // Sojourn histogram bucket i counts times in [2^(i-1), 2^i) nanoseconds, the last one everything above
+    #ifndef SOJOURN_HISTOGRAM_BUCKETS
+        #define SOJOURN_HISTOGRAM_BUCKETS 40
+    #endif
+
+    /*! \brief Merged view of a queue's telemetry, see QueueTelemetry::snapshot()
+    */
+    struct QueueTelemetrySnapshot
+    {
+        uint64_t    pushes;
+        uint64_t    pops;
+        size_t      highWaterMark;
+        // Sojourn time is the time an element spends in the queue, from push to pop
+        uint64_t    sojournSamples;
+        uint64_t    meanSojournNanoseconds;
+        uint64_t    p50SojournNanoseconds;
+        uint64_t    p99SojournNanoseconds;
+        uint64_t    maxSojournNanoseconds;
+        // Rates are over the interval since the previous snapshot (or creation / reset)
+        double      intervalSeconds;
+        double      pushesPerSecond;
+        double      popsPerSecond;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief QueueTelemetry tracks how full a queue gets, how long elements sit in it and how fast
+        they come and go.
+
+        Counters live in per-thread slots on their own cache lines, so producers and consumers don't
+        contend on them; they're only summed up when a snapshot is taken. Only one in every
+        DEFAULT_SOJOURN_SAMPLE_PERIOD pushes is timestamped, the matching pop measures how long that
+        element sat in the queue.
+    */
+    class QueueTelemetry
+    {
+    public:
+        QueueTelemetry();
+        ~QueueTelemetry();
+
+        /*! \brief Counts a push, and sets pushedAt to the current time if this push is sampled or
+            to 0 if it isn't. Call before the element becomes visible to consumers.
+        */
+        void pushing(uint64_t& pushedAt);
+        /*! \brief Raises the high-water mark to size if it's higher
+        */
+        void sizeIs(size_t size);
+        /*! \brief Counts a pop of an element whose push set pushedAt
+        */
+        void popped(uint64_t pushedAt);
+
+        /*! \brief Sums up every slot. Also starts a new rate interval.
+        */
+        QueueTelemetrySnapshot snapshot() const;
+        void reset();
+
+        /*! \brief Monotonic timestamp in nanoseconds, never 0
+        */
+        static uint64_t now();
+
+    private:
+        struct DX_CACHE_ALIGNED Slot
+        {
+            std::atomic<uint64_t>   pushes;
+            std::atomic<uint64_t>   pops;
+            std::atomic<uint64_t>   sojournSamples;
+            std::atomic<uint64_t>   sojournNanoseconds;
+            std::atomic<uint64_t>   maxSojournNanoseconds;
+            std::atomic<uint64_t>   sojournHistogram[SOJOURN_HISTOGRAM_BUCKETS];
+        };
+
+        Slot& slot();
+
+        Slot                        m_slots[DEFAULT_TELEMETRY_SLOTS];
+        DX_CACHE_ALIGNED std::atomic<size_t> m_highWaterMark;
+        // State of the current rate interval
+        SpinMutex                   m_intervalMutex;
+        mutable uint64_t            m_intervalStart;
+        mutable uint64_t            m_intervalPushes;
+        mutable uint64_t            m_intervalPops;
+
+        QueueTelemetry(const QueueTelemetry&);
+        QueueTelemetry(QueueTelemetry&&);
+    };
+
+}
\ No newline at end of file
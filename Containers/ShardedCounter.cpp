@@ -0,0 +1,117 @@
+
+#include "ShardedCounter.h"
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    static_assert((DEFAULT_COUNTER_SHARDS & (DEFAULT_COUNTER_SHARDS - 1)) == 0, "DEFAULT_COUNTER_SHARDS must be a power of two");
+
+    ShardedCounter::ShardedCounter()
+    {
+        reset();
+    }
+
+    int64_t ShardedCounter::value() const
+    {
+        int64_t sum = 0;
+        for(size_t i = 0; i < DEFAULT_COUNTER_SHARDS; ++i)
+            sum += m_cells[i]->load(std::memory_order_relaxed);
+        return sum;
+    }
+
+    void ShardedCounter::reset()
+    {
+        for(size_t i = 0; i < DEFAULT_COUNTER_SHARDS; ++i)
+            m_cells[i]->store(0, std::memory_order_relaxed);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    uint64_t HistogramSnapshot::mean() const
+    {
+        return count == 0 ? 0 : sum / count;
+    }
+
+    uint64_t HistogramSnapshot::percentile(double fraction) const
+    {
+        if(count == 0)
+            return 0;
+
+        const uint64_t target = static_cast<uint64_t>(fraction * static_cast<double>(count - 1)) + 1;
+        uint64_t seen = 0;
+        for(size_t i = 0; i < SHARDED_HISTOGRAM_BUCKETS; ++i)
+        {
+            seen += buckets[i];
+            if(seen >= target)
+            {
+                const uint64_t upper = i == 0 ? 0 : (i == 64 ? ~uint64_t(0) : (uint64_t(1) << i) - 1);
+                return upper < max ? upper : max;
+            }
+        }
+        return max;
+    }
+
+    ShardedHistogram::ShardedHistogram()
+    {
+        reset();
+    }
+
+    size_t ShardedHistogram::bucketOf(uint64_t value)
+    {
+        size_t bucket = 0;
+        while(value != 0)
+        {
+            value >>= 1;
+            ++bucket;
+        }
+        return bucket;
+    }
+
+    void ShardedHistogram::record(uint64_t value)
+    {
+        Cell& cell = m_cells[Detail::currentShard()];
+        cell.count.fetch_add(1, std::memory_order_relaxed);
+        cell.sum.fetch_add(value, std::memory_order_relaxed);
+        cell.buckets[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+
+        uint64_t max = cell.max.load(std::memory_order_relaxed);
+        while(value > max && !cell.max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    HistogramSnapshot ShardedHistogram::snapshot() const
+    {
+        HistogramSnapshot result = HistogramSnapshot();
+        for(size_t i = 0; i < DEFAULT_COUNTER_SHARDS; ++i)
+        {
+            const Cell& cell = m_cells[i];
+            result.count += cell.count.load(std::memory_order_relaxed);
+            result.sum += cell.sum.load(std::memory_order_relaxed);
+            const uint64_t max = cell.max.load(std::memory_order_relaxed);
+            if(max > result.max)
+                result.max = max;
+            for(size_t b = 0; b < SHARDED_HISTOGRAM_BUCKETS; ++b)
+                result.buckets[b] += cell.buckets[b].load(std::memory_order_relaxed);
+        }
+        return result;
+    }
+
+    void ShardedHistogram::reset()
+    {
+        for(size_t i = 0; i < DEFAULT_COUNTER_SHARDS; ++i)
+        {
+            Cell& cell = m_cells[i];
+            cell.count.store(0, std::memory_order_relaxed);
+            cell.sum.store(0, std::memory_order_relaxed);
+            cell.max.store(0, std::memory_order_relaxed);
+            for(size_t b = 0; b < SHARDED_HISTOGRAM_BUCKETS; ++b)
+                cell.buckets[b].store(0, std::memory_order_relaxed);
+        }
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,225 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Counters and statistics accumulators that scale with the number of writing threads
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "../CacheLine.h"
+#include "../Threading/ThreadId.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    // Number of cells per counter, must be a power of two. Threads beyond that share cells.
+    #ifndef DEFAULT_COUNTER_SHARDS
+        #define DEFAULT_COUNTER_SHARDS 32
+    #endif
+
+    // ShardedHistogram bucket i counts values in [2^(i-1), 2^i), bucket 0 counts zeroes
+    #define SHARDED_HISTOGRAM_BUCKETS 65
+
+    namespace Detail
+    {
+        inline size_t currentShard()
+        {
+            return currentThreadId() & (DEFAULT_COUNTER_SHARDS - 1);
+        }
+    }
+
+    /*! \brief ShardedCounter is a counter for many writers and few readers. Every thread adds to a
+        cell of its own, on its own cache line, so increments from different cores don't fight over
+        one line the way they do on a single std::atomic. value() sums up the cells, so reads cost
+        DEFAULT_COUNTER_SHARDS loads and see increments that happen meanwhile only partially.
+
+        Use it for statistics and rate counters. Anything that needs an exact value to act on, like
+        a queue's size, should stay a plain atomic.
+
+        \code
+        ShardedCounter requests;
+        ...
+        // Hot path, any thread
+        requests.increment();
+        ...
+        // Metrics thread
+        report("requests", requests.value());
+        \endcode
+    */
+    class ShardedCounter
+    {
+    public:
+        ShardedCounter();
+
+        void    add(int64_t amount);
+        void    increment();
+        void    decrement();
+
+        int64_t value() const;
+        /*! \brief Zeroes the counter. Adds that race with it may or may not survive.
+        */
+        void    reset();
+
+    private:
+        CachePadded<std::atomic<int64_t> > m_cells[DEFAULT_COUNTER_SHARDS];
+
+        ShardedCounter(const ShardedCounter&);
+        ShardedCounter(ShardedCounter&&);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief ShardedExtreme keeps the best value recorded according to Better, one cell per shard.
+        A record() that doesn't beat its cell is just a load, so once the extreme settles writers
+        only read. Use ShardedMin and ShardedMax.
+    */
+    template <typename T, typename Better>
+    class ShardedExtreme
+    {
+    public:
+        /*! \brief identity is what an empty accumulator reports, e.g. the lowest T for a maximum
+        */
+        explicit ShardedExtreme(T identity);
+
+        void    record(T value);
+        T       value() const;
+        void    reset();
+
+    private:
+        const T                         m_identity;
+        CachePadded<std::atomic<T> >    m_cells[DEFAULT_COUNTER_SHARDS];
+
+        ShardedExtreme(const ShardedExtreme&);
+        ShardedExtreme(ShardedExtreme&&);
+    };
+
+    /*! \brief Largest value recorded, std::numeric_limits<T>::lowest() while empty
+    */
+    template <typename T>
+    class ShardedMax : public ShardedExtreme<T, std::greater<T> >
+    {
+    public:
+        ShardedMax() : ShardedExtreme<T, std::greater<T> >(std::numeric_limits<T>::lowest()) {}
+    };
+
+    /*! \brief Smallest value recorded, std::numeric_limits<T>::max() while empty
+    */
+    template <typename T>
+    class ShardedMin : public ShardedExtreme<T, std::less<T> >
+    {
+    public:
+        ShardedMin() : ShardedExtreme<T, std::less<T> >(std::numeric_limits<T>::max()) {}
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief Merged view of a ShardedHistogram
+    */
+    struct HistogramSnapshot
+    {
+        uint64_t    count;
+        uint64_t    sum;
+        uint64_t    max;
+        uint64_t    buckets[SHARDED_HISTOGRAM_BUCKETS];
+
+        uint64_t    mean() const;
+        /*! \brief Upper bound of the bucket holding the given fraction of values (0.5 for the
+            median), so only accurate to a power of two. Never more than max.
+        */
+        uint64_t    percentile(double fraction) const;
+    };
+
+    /*! \brief ShardedHistogram records the distribution of unsigned values, latencies in
+        nanoseconds say, in power of two buckets. Like ShardedCounter every thread writes to its
+        own cell, snapshot() merges them.
+    */
+    class ShardedHistogram
+    {
+    public:
+        ShardedHistogram();
+
+        void                record(uint64_t value);
+        HistogramSnapshot   snapshot() const;
+        void                reset();
+
+        static size_t       bucketOf(uint64_t value);
+
+    private:
+        struct DX_CACHE_ALIGNED Cell
+        {
+            std::atomic<uint64_t>   count;
+            std::atomic<uint64_t>   sum;
+            std::atomic<uint64_t>   max;
+            std::atomic<uint64_t>   buckets[SHARDED_HISTOGRAM_BUCKETS];
+        };
+
+        Cell    m_cells[DEFAULT_COUNTER_SHARDS];
+
+        ShardedHistogram(const ShardedHistogram&);
+        ShardedHistogram(ShardedHistogram&&);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    inline void ShardedCounter::add(int64_t amount)
+    {
+        m_cells[Detail::currentShard()]->fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    inline void ShardedCounter::increment()
+    {
+        add(1);
+    }
+
+    inline void ShardedCounter::decrement()
+    {
+        add(-1);
+    }
+
+    template <typename T, typename Better>
+    ShardedExtreme<T, Better>::ShardedExtreme(T identity) : m_identity(identity)
+    {
+        reset();
+    }
+
+    template <typename T, typename Better>
+    void ShardedExtreme<T, Better>::record(T value)
+    {
+        std::atomic<T>& cell = *m_cells[Detail::currentShard()];
+        T current = cell.load(std::memory_order_relaxed);
+        // Only pay for a read-modify-write when there's a new extreme
+        while(Better()(value, current) && !cell.compare_exchange_weak(current, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    template <typename T, typename Better>
+    T ShardedExtreme<T, Better>::value() const
+    {
+        T best = m_identity;
+        for(size_t i = 0; i < DEFAULT_COUNTER_SHARDS; ++i)
+        {
+            const T current = m_cells[i]->load(std::memory_order_relaxed);
+            if(Better()(current, best))
+                best = current;
+        }
+        return best;
+    }
+
+    template <typename T, typename Better>
+    void ShardedExtreme<T, Better>::reset()
+    {
+        for(size_t i = 0; i < DEFAULT_COUNTER_SHARDS; ++i)
+            m_cells[i]->store(m_identity, std::memory_order_relaxed);
+    }
+
+}
\ No newline at end of file
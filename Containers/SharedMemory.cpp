@@ -0,0 +1,269 @@
+
+#include "SharedMemory.h"
+
+#include <cassert>
+#include <cstring>
+#include <new>
+
+#if defined(_WIN32)
+    #include <Windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2, "shared rings need address free atomics");
+
+    static const uint32_t SHARED_RING_MAGIC = 0x51534458; // "DXSQ"
+
+    SharedMemory::SharedMemory() : m_data(nullptr), m_size(0), m_ownedName(nullptr)
+    {
+    #if defined(_WIN32)
+        m_handle = nullptr;
+    #endif
+    }
+
+    SharedMemory::~SharedMemory()
+    {
+        close();
+    }
+
+#if defined(_WIN32)
+
+    bool SharedMemory::create(const char* name, size_t size)
+    {
+        assert(!isOpen());
+        const uint64_t size64 = size;
+        HANDLE handle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64), name);
+        if(handle == nullptr)
+            return false;
+        if(GetLastError() == ERROR_ALREADY_EXISTS)
+        {
+            CloseHandle(handle);
+            return false;
+        }
+
+        m_data = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, size);
+        if(m_data == nullptr)
+        {
+            CloseHandle(handle);
+            return false;
+        }
+        m_handle = handle;
+        m_size = size;
+        return true;
+    }
+
+    bool SharedMemory::open(const char* name)
+    {
+        assert(!isOpen());
+        HANDLE handle = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name);
+        if(handle == nullptr)
+            return false;
+
+        m_data = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+        MEMORY_BASIC_INFORMATION info;
+        if(m_data == nullptr || VirtualQuery(m_data, &info, sizeof(info)) == 0)
+        {
+            if(m_data != nullptr)
+                UnmapViewOfFile(m_data);
+            m_data = nullptr;
+            CloseHandle(handle);
+            return false;
+        }
+        m_handle = handle;
+        m_size = info.RegionSize;
+        return true;
+    }
+
+    void SharedMemory::close()
+    {
+        if(m_data != nullptr)
+            UnmapViewOfFile(m_data);
+        if(m_handle != nullptr)
+            CloseHandle(m_handle);
+        m_data = nullptr;
+        m_handle = nullptr;
+        m_size = 0;
+    }
+
+    bool SharedMemory::unlink(const char*)
+    {
+        // Named mappings vanish with their last handle
+        return true;
+    }
+
+#else
+
+    bool SharedMemory::create(const char* name, size_t size)
+    {
+        assert(!isOpen());
+        const int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if(fd < 0)
+            return false;
+
+        if(ftruncate(fd, static_cast<off_t>(size)) != 0)
+        {
+            ::close(fd);
+            shm_unlink(name);
+            return false;
+        }
+
+        void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if(data == MAP_FAILED)
+        {
+            shm_unlink(name);
+            return false;
+        }
+
+        m_data = data;
+        m_size = size;
+        m_ownedName = new char[strlen(name) + 1];
+        strcpy(m_ownedName, name);
+        return true;
+    }
+
+    bool SharedMemory::open(const char* name)
+    {
+        assert(!isOpen());
+        const int fd = shm_open(name, O_RDWR, 0600);
+        if(fd < 0)
+            return false;
+
+        struct stat status;
+        if(fstat(fd, &status) != 0 || status.st_size == 0)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        const size_t size = static_cast<size_t>(status.st_size);
+        void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if(data == MAP_FAILED)
+            return false;
+
+        m_data = data;
+        m_size = size;
+        return true;
+    }
+
+    void SharedMemory::close()
+    {
+        if(m_data != nullptr)
+            munmap(m_data, m_size);
+        if(m_ownedName != nullptr)
+        {
+            shm_unlink(m_ownedName);
+            delete[] m_ownedName;
+        }
+        m_data = nullptr;
+        m_size = 0;
+        m_ownedName = nullptr;
+    }
+
+    bool SharedMemory::unlink(const char* name)
+    {
+        return shm_unlink(name) == 0;
+    }
+
+#endif
+
+    void* SharedMemory::data() const
+    {
+        return m_data;
+    }
+
+    size_t SharedMemory::size() const
+    {
+        return m_size;
+    }
+
+    bool SharedMemory::isOpen() const
+    {
+        return m_data != nullptr;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    SharedRing::SharedRing() : m_header(nullptr), m_slots(nullptr), m_mask(0), m_slotSize(0)
+    {
+    }
+
+    bool SharedRing::create(const char* name, size_t capacity, size_t slotSize, Kind kind)
+    {
+        assert(capacity > 0);
+        size_t rounded = 1;
+        while(rounded < capacity)
+            rounded <<= 1;
+
+        if(!m_memory.create(name, sizeof(SharedRingHeader) + rounded * slotSize))
+            return false;
+
+        // The region comes zero-filled, only the parameters need setting
+        m_header = new (m_memory.data()) SharedRingHeader();
+        m_header->magic = SHARED_RING_MAGIC;
+        m_header->kind = kind;
+        m_header->capacity = rounded;
+        m_header->slotSize = slotSize;
+        m_header->head.store(0, std::memory_order_relaxed);
+        m_header->tail.store(0, std::memory_order_relaxed);
+        m_slots = static_cast<char*>(m_memory.data()) + sizeof(SharedRingHeader);
+        m_mask = rounded - 1;
+        m_slotSize = slotSize;
+        return true;
+    }
+
+    bool SharedRing::open(const char* name, size_t slotSize, Kind kind)
+    {
+        if(!m_memory.open(name))
+            return false;
+
+        SharedRingHeader* header = static_cast<SharedRingHeader*>(m_memory.data());
+        // The header comes from another process, anything we derive the mask or the bounds from gets
+        // checked before use
+        if(m_memory.size() < sizeof(SharedRingHeader) || header->ready.load(std::memory_order_acquire) == 0 ||
+           header->magic != SHARED_RING_MAGIC || header->kind != static_cast<uint32_t>(kind) || header->slotSize != slotSize ||
+           header->capacity == 0 || (header->capacity & (header->capacity - 1)) != 0 ||
+           header->capacity > (m_memory.size() - sizeof(SharedRingHeader)) / slotSize)
+        {
+            m_memory.close();
+            return false;
+        }
+
+        m_header = header;
+        m_slots = static_cast<char*>(m_memory.data()) + sizeof(SharedRingHeader);
+        m_mask = header->capacity - 1;
+        m_slotSize = slotSize;
+        return true;
+    }
+
+    void SharedRing::publish()
+    {
+        assert(m_header != nullptr);
+        m_header->ready.store(1, std::memory_order_release);
+    }
+
+    void SharedRing::close()
+    {
+        m_memory.close();
+        m_header = nullptr;
+        m_slots = nullptr;
+    }
+
+    bool SharedRing::isOpen() const
+    {
+        return m_header != nullptr;
+    }
+
+}
\ No newline at end of file
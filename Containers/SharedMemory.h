@@ -0,0 +1,143 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Named shared memory regions and the ring layout the inter-process queues live in
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief SharedMemory maps a named region (shm_open on POSIX, a named file mapping on Windows)
+        that other processes can map too. Regions are mapped at different addresses in every
+        process, so anything stored in them refers to other parts by offset, never by pointer.
+
+        The process that created a region removes its name when it closes it. Processes that have
+        it mapped keep using it; the memory goes away with the last mapping.
+    */
+    class SharedMemory
+    {
+    public:
+        SharedMemory();
+        ~SharedMemory();
+
+        /*! \brief Creates and maps a new zero-filled region, fails if name exists already. POSIX
+            names look like "/name".
+        */
+        bool    create(const char* name, size_t size);
+        /*! \brief Maps an existing region, fails if there is none or it is still being sized
+        */
+        bool    open(const char* name);
+        void    close();
+
+        /*! \brief Removes a region left behind by a crashed creator
+        */
+        static bool unlink(const char* name);
+
+        void*   data() const;
+        size_t  size() const;
+        bool    isOpen() const;
+
+    private:
+        void*   m_data;
+        size_t  m_size;
+        // Set on the creating side, which unlinks the name on close()
+        char*   m_ownedName;
+    #if defined(_WIN32)
+        void*   m_handle;
+    #endif
+
+        SharedMemory(const SharedMemory&);
+        SharedMemory(SharedMemory&&);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    // Alignment of the shared ring's fields and slots. Fixed rather than CACHE_LINE_SIZE so that
+    // processes built with different settings still agree on the layout.
+    #define SHARED_LINE_SIZE 128
+
+    /*! \brief Start of every shared ring: layout parameters the opening side checks against its
+        own, then the consumer and producer positions on lines of their own. Slots follow at
+        offset sizeof(SharedRingHeader).
+    */
+    struct SharedRingHeader
+    {
+        uint32_t                magic;
+        uint32_t                kind;
+        uint64_t                capacity;
+        uint64_t                slotSize;
+        // Set last by the creator once the slots are initialized
+        std::atomic<uint32_t>   ready;
+
+        alignas(SHARED_LINE_SIZE) std::atomic<uint64_t> head;
+        alignas(SHARED_LINE_SIZE) std::atomic<uint64_t> tail;
+    };
+
+    /*! \brief SharedRing is the type independent part of SharedStream and SharedQueue: a region
+        holding a SharedRingHeader and a power of two number of fixed size slots.
+    */
+    class SharedRing
+    {
+    public:
+        enum Kind
+        {
+            STREAM = 1,
+            QUEUE = 2
+        };
+
+        SharedRing();
+
+        /*! \brief Creates the region with room for capacity slots, rounded up to a power of two.
+            Call publish() once the slots are initialized.
+        */
+        bool    create(const char* name, size_t capacity, size_t slotSize, Kind kind);
+        /*! \brief Attaches to a ring created with the same kind and slot size. Fails while the
+            creator hasn't published it yet, so openers are expected to retry.
+        */
+        bool    open(const char* name, size_t slotSize, Kind kind);
+        void    publish();
+        void    close();
+        bool    isOpen() const;
+
+        SharedRingHeader&   header() const;
+        void*               slot(uint64_t position) const;
+        size_t              capacity() const;
+
+    private:
+        SharedMemory        m_memory;
+        SharedRingHeader*   m_header;
+        char*               m_slots;
+        uint64_t            m_mask;
+        size_t              m_slotSize;
+
+        SharedRing(const SharedRing&);
+        SharedRing(SharedRing&&);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    inline SharedRingHeader& SharedRing::header() const
+    {
+        return *m_header;
+    }
+
+    inline void* SharedRing::slot(uint64_t position) const
+    {
+        return m_slots + static_cast<size_t>(position & m_mask) * m_slotSize;
+    }
+
+    inline size_t SharedRing::capacity() const
+    {
+        return static_cast<size_t>(m_mask + 1);
+    }
+
+}
\ No newline at end of file
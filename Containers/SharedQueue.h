@@ -0,0 +1,208 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Multi-reader, multi-writer queue between processes, in shared memory
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "SharedMemory.h"
+
+#include <cassert>
+#include <cstring>
+#include <type_traits>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief SharedQueue is a bounded queue in a named SharedMemory region that any number of
+        threads in any number of processes push to and pop from.
+
+        Every slot carries a sequence number that says whose turn it is: producers claim a position
+        with a compare-exchange on the tail and wait for the slot's sequence to reach it, consumers
+        do the same on the head. Sequences and positions are plain integers, so the layout works at
+        whatever address each process maps it. No system calls and no locks, but also no recovery: a
+        process dying between claiming a slot and publishing it leaves that slot's sequence behind.
+        From then on pop() returns false at that slot, so every consumer stalls there for good and
+        the queue fills up.
+
+        T must be trivially copyable and hold no pointers. Set up like SharedStream.
+    */
+    template <typename T>
+    class SharedQueue
+    {
+    public:
+        SharedQueue();
+        ~SharedQueue();
+
+        /*! \brief Creates the region with room for capacity elements, rounded up to a power of two
+        */
+        bool    create(const char* name, size_t capacity);
+        bool    open(const char* name);
+        void    close();
+        bool    isOpen() const;
+
+        bool    isEmpty() const;
+        size_t  size() const;
+        size_t  capacity() const;
+        bool    pop(T& out);
+        /*! \brief Returns false if the queue is full
+        */
+        bool    push(const T& in);
+
+    private:
+        struct Slot
+        {
+            std::atomic<uint64_t>   sequence;
+            T                       value;
+        };
+
+        Slot&   slotAt(uint64_t position) const;
+
+        SharedRing  m_ring;
+
+        static_assert(std::is_trivially_copyable<T>::value, "SharedQueue elements are copied byte for byte");
+
+        SharedQueue(const SharedQueue&);
+        SharedQueue(SharedQueue&&);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    template <typename T>
+    SharedQueue<T>::SharedQueue()
+    {
+    }
+
+    template <typename T>
+    SharedQueue<T>::~SharedQueue()
+    {
+    }
+
+    template <typename T>
+    typename SharedQueue<T>::Slot& SharedQueue<T>::slotAt(uint64_t position) const
+    {
+        return *static_cast<Slot*>(m_ring.slot(position));
+    }
+
+    template <typename T>
+    bool SharedQueue<T>::create(const char* name, size_t capacity)
+    {
+        if(!m_ring.create(name, capacity, sizeof(Slot), SharedRing::QUEUE))
+            return false;
+        // Slot i is first written at position i
+        for(uint64_t i = 0; i < m_ring.capacity(); ++i)
+            slotAt(i).sequence.store(i, std::memory_order_relaxed);
+        m_ring.publish();
+        return true;
+    }
+
+    template <typename T>
+    bool SharedQueue<T>::open(const char* name)
+    {
+        return m_ring.open(name, sizeof(Slot), SharedRing::QUEUE);
+    }
+
+    template <typename T>
+    void SharedQueue<T>::close()
+    {
+        m_ring.close();
+    }
+
+    template <typename T>
+    bool SharedQueue<T>::isOpen() const
+    {
+        return m_ring.isOpen();
+    }
+
+    template <typename T>
+    size_t SharedQueue<T>::capacity() const
+    {
+        return m_ring.capacity();
+    }
+
+    template <typename T>
+    size_t SharedQueue<T>::size() const
+    {
+        const uint64_t head = m_ring.header().head.load(std::memory_order_acquire);
+        const uint64_t tail = m_ring.header().tail.load(std::memory_order_acquire);
+        // Claimed positions count, so it can run ahead of what pop() would find
+        return tail > head ? static_cast<size_t>(tail - head) : 0;
+    }
+
+    template <typename T>
+    bool SharedQueue<T>::isEmpty() const
+    {
+        return size() == 0;
+    }
+
+    template <typename T>
+    bool SharedQueue<T>::push(const T& in)
+    {
+        assert(isOpen());
+        std::atomic<uint64_t>& tail = m_ring.header().tail;
+        uint64_t position = tail.load(std::memory_order_relaxed);
+        for(;;)
+        {
+            Slot& slot = slotAt(position);
+            const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const int64_t lag = static_cast<int64_t>(sequence - position);
+            if(lag == 0)
+            {
+                if(tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    memcpy(&slot.value, &in, sizeof(T));
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if(lag < 0)
+            {
+                // The slot still holds the element from a lap ago
+                return false;
+            }
+            else
+            {
+                // Spin out, another producer took this position
+                position = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    template <typename T>
+    bool SharedQueue<T>::pop(T& out)
+    {
+        assert(isOpen());
+        std::atomic<uint64_t>& head = m_ring.header().head;
+        uint64_t position = head.load(std::memory_order_relaxed);
+        for(;;)
+        {
+            Slot& slot = slotAt(position);
+            const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const int64_t lag = static_cast<int64_t>(sequence - (position + 1));
+            if(lag == 0)
+            {
+                if(head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    memcpy(&out, &slot.value, sizeof(T));
+                    // Free for the producer one lap later
+                    slot.sequence.store(position + m_ring.capacity(), std::memory_order_release);
+                    return true;
+                }
+            }
+            else if(lag < 0)
+            {
+                // No items left
+                return false;
+            }
+            else
+            {
+                // Spin out, another consumer took this position
+                position = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,193 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Single-reader, single-writer stream between two processes, in shared memory
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "SharedMemory.h"
+
+#include <cassert>
+#include <cstring>
+#include <type_traits>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief SharedStream is ConcurrentStream across a process boundary: one producer process, one
+        consumer process, and a ring of fixed size slots in a named SharedMemory region between
+        them. Pushing and popping are a copy and a release store, no system calls.
+
+        Unlike ConcurrentStream it is bounded, push() fails while the ring is full. Elements are
+        copied byte for byte, so T must be trivially copyable and hold no pointers, both processes
+        map the region at different addresses.
+
+        One side create()s the stream, the other open()s it by name; open() fails until the creator
+        is done, so retry it.
+
+        \code
+        // Producer process
+        SharedStream<Tick> ticks;
+        ticks.create("/ticks", 65536);
+        while(!ticks.push(tick))
+            ; // Full, the consumer is behind
+
+        // Consumer process
+        SharedStream<Tick> ticks;
+        while(!ticks.open("/ticks"))
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        Tick tick;
+        if(ticks.pop(tick))
+            handle(tick);
+        \endcode
+    */
+    template <typename T>
+    class SharedStream
+    {
+    public:
+        SharedStream();
+        ~SharedStream();
+
+        /*! \brief Creates the region with room for capacity elements, rounded up to a power of two
+        */
+        bool    create(const char* name, size_t capacity);
+        bool    open(const char* name);
+        void    close();
+        bool    isOpen() const;
+
+        bool    isEmpty() const;
+        size_t  size() const;
+        size_t  capacity() const;
+        bool    front(T& out) const;
+        bool    pop(T& out);
+        /*! \brief Returns false if the stream is full
+        */
+        bool    push(const T& in);
+
+    private:
+        SharedRing  m_ring;
+        // This process' copy of the other side's position, only refreshed when it looks full / empty
+        uint64_t    m_cachedHead;
+        uint64_t    m_cachedTail;
+
+        static_assert(std::is_trivially_copyable<T>::value, "SharedStream elements are copied byte for byte");
+
+        SharedStream(const SharedStream&);
+        SharedStream(SharedStream&&);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    template <typename T>
+    SharedStream<T>::SharedStream() : m_cachedHead(0), m_cachedTail(0)
+    {
+    }
+
+    template <typename T>
+    SharedStream<T>::~SharedStream()
+    {
+    }
+
+    template <typename T>
+    bool SharedStream<T>::create(const char* name, size_t capacity)
+    {
+        if(!m_ring.create(name, capacity, sizeof(T), SharedRing::STREAM))
+            return false;
+        m_cachedHead = m_cachedTail = 0;
+        m_ring.publish();
+        return true;
+    }
+
+    template <typename T>
+    bool SharedStream<T>::open(const char* name)
+    {
+        if(!m_ring.open(name, sizeof(T), SharedRing::STREAM))
+            return false;
+        m_cachedHead = m_ring.header().head.load(std::memory_order_acquire);
+        m_cachedTail = m_ring.header().tail.load(std::memory_order_acquire);
+        return true;
+    }
+
+    template <typename T>
+    void SharedStream<T>::close()
+    {
+        m_ring.close();
+    }
+
+    template <typename T>
+    bool SharedStream<T>::isOpen() const
+    {
+        return m_ring.isOpen();
+    }
+
+    template <typename T>
+    size_t SharedStream<T>::capacity() const
+    {
+        return m_ring.capacity();
+    }
+
+    template <typename T>
+    size_t SharedStream<T>::size() const
+    {
+        const uint64_t head = m_ring.header().head.load(std::memory_order_acquire);
+        const uint64_t tail = m_ring.header().tail.load(std::memory_order_acquire);
+        return static_cast<size_t>(tail - head);
+    }
+
+    template <typename T>
+    bool SharedStream<T>::isEmpty() const
+    {
+        return size() == 0;
+    }
+
+    template <typename T>
+    bool SharedStream<T>::front(T& out) const
+    {
+        const uint64_t head = m_ring.header().head.load(std::memory_order_relaxed);
+        if(head == m_ring.header().tail.load(std::memory_order_acquire))
+            return false;
+        memcpy(&out, m_ring.slot(head), sizeof(T));
+        return true;
+    }
+
+    template <typename T>
+    bool SharedStream<T>::pop(T& out)
+    {
+        assert(isOpen());
+        SharedRingHeader& header = m_ring.header();
+        const uint64_t head = header.head.load(std::memory_order_relaxed);
+        if(head == m_cachedTail)
+        {
+            m_cachedTail = header.tail.load(std::memory_order_acquire);
+            if(head == m_cachedTail) // No items left
+                return false;
+        }
+
+        memcpy(&out, m_ring.slot(head), sizeof(T));
+        // Hands the slot back to the producer
+        header.head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    template <typename T>
+    bool SharedStream<T>::push(const T& in)
+    {
+        assert(isOpen());
+        SharedRingHeader& header = m_ring.header();
+        const uint64_t tail = header.tail.load(std::memory_order_relaxed);
+        if(tail - m_cachedHead == m_ring.capacity())
+        {
+            m_cachedHead = header.head.load(std::memory_order_acquire);
+            if(tail - m_cachedHead == m_ring.capacity())
+                return false;
+        }
+
+        memcpy(m_ring.slot(tail), &in, sizeof(T));
+        header.tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,217 @@
+
+#include "SpillQueue.h"
+
+#include <cstdio>
+
+#if defined(_WIN32)
+    #include <Windows.h>
+    #include <process.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    // Records are a 32 bit length followed by the bytes, padded so the next length is aligned
+    static const size_t RECORD_HEADER = sizeof(uint32_t);
+    static const size_t RECORD_ALIGNMENT = 8;
+
+    static size_t recordSize(size_t size)
+    {
+        return (RECORD_HEADER + size + RECORD_ALIGNMENT - 1) & ~(RECORD_ALIGNMENT - 1);
+    }
+
+    // Tells apart the stores of several queues and processes sharing a directory
+    static std::atomic<uint64_t> s_nextStoreId(0);
+
+    struct SpillStore::Segment
+    {
+        Segment*    next;
+        char*       data;
+        size_t      size;
+        size_t      readOffset;
+        size_t      writeOffset;
+        std::string path;
+    #if defined(_WIN32)
+        HANDLE      file;
+        HANDLE      mapping;
+    #endif
+    };
+
+    SpillStore::SpillStore(const std::string& directory, size_t segmentSize) : m_directory(directory), m_segmentSize(segmentSize),
+        m_first(nullptr), m_last(nullptr), m_numRecords(0), m_numSegments(0)
+    {
+        // Store id in the high bits, segment number in the low ones
+        m_nextSegmentId = ++s_nextStoreId << 32;
+    }
+
+    SpillStore::~SpillStore()
+    {
+        while(m_first != nullptr)
+            removeSegment(m_first);
+    }
+
+    bool SpillStore::addSegment(size_t minimumSize)
+    {
+        const size_t size = minimumSize > m_segmentSize ? minimumSize : m_segmentSize;
+
+        char name[64];
+    #if defined(_WIN32)
+        snprintf(name, sizeof(name), "/dxspill-%d-%016llx.seg", _getpid(), static_cast<unsigned long long>(m_nextSegmentId));
+    #else
+        snprintf(name, sizeof(name), "/dxspill-%d-%016llx.seg", static_cast<int>(getpid()), static_cast<unsigned long long>(m_nextSegmentId));
+    #endif
+        Segment* segment = new Segment();
+        segment->path = m_directory + name;
+
+    #if defined(_WIN32)
+        segment->file = CreateFileA(segment->path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_NEW, FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+        if(segment->file == INVALID_HANDLE_VALUE)
+        {
+            delete segment;
+            return false;
+        }
+        const uint64_t size64 = size;
+        segment->mapping = CreateFileMappingA(segment->file, nullptr, PAGE_READWRITE, static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64), nullptr);
+        segment->data = segment->mapping ? static_cast<char*>(MapViewOfFile(segment->mapping, FILE_MAP_ALL_ACCESS, 0, 0, size)) : nullptr;
+        if(segment->data == nullptr)
+        {
+            if(segment->mapping)
+                CloseHandle(segment->mapping);
+            CloseHandle(segment->file);
+            delete segment;
+            return false;
+        }
+    #else
+        const int fd = open(segment->path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+        if(fd < 0)
+        {
+            delete segment;
+            return false;
+        }
+        // Allocate the blocks up front where we can: with a sparse file a full disk would be a
+        // SIGBUS on some later write instead of a failed push now
+    #if defined(__linux__)
+        const bool sized = posix_fallocate(fd, 0, static_cast<off_t>(size)) == 0;
+    #else
+        const bool sized = ftruncate(fd, static_cast<off_t>(size)) == 0;
+    #endif
+        void* data = sized ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+        close(fd);
+        if(data == MAP_FAILED)
+        {
+            unlink(segment->path.c_str());
+            delete segment;
+            return false;
+        }
+        segment->data = static_cast<char*>(data);
+    #endif
+
+        ++m_nextSegmentId;
+        segment->next = nullptr;
+        segment->size = size;
+        segment->readOffset = 0;
+        segment->writeOffset = 0;
+        if(m_last != nullptr)
+            m_last->next = segment;
+        else
+            m_first = segment;
+        m_last = segment;
+        ++m_numSegments;
+        return true;
+    }
+
+    void SpillStore::removeSegment(Segment* segment)
+    {
+        assert(segment == m_first);
+        m_first = segment->next;
+        if(m_first == nullptr)
+            m_last = nullptr;
+        --m_numSegments;
+
+    #if defined(_WIN32)
+        // The file was opened delete-on-close
+        UnmapViewOfFile(segment->data);
+        CloseHandle(segment->mapping);
+        CloseHandle(segment->file);
+    #else
+        munmap(segment->data, segment->size);
+        unlink(segment->path.c_str());
+    #endif
+        delete segment;
+    }
+
+    bool SpillStore::append(const char* data, size_t size)
+    {
+        if(size > UINT32_MAX)
+            return false;
+
+        const size_t needed = recordSize(size);
+        if(m_last == nullptr || m_last->size - m_last->writeOffset < needed)
+        {
+            if(!addSegment(needed))
+                return false;
+        }
+
+        char* record = m_last->data + m_last->writeOffset;
+        const uint32_t length = static_cast<uint32_t>(size);
+        memcpy(record, &length, RECORD_HEADER);
+        if(size != 0)
+            memcpy(record + RECORD_HEADER, data, size);
+        m_last->writeOffset += needed;
+        ++m_numRecords;
+        return true;
+    }
+
+    bool SpillStore::peek(const char*& data, size_t& size) const
+    {
+        if(m_numRecords == 0)
+            return false;
+
+        // Segments are removed as soon as they are read to the end, so the first one has it
+        const Segment* segment = m_first;
+        assert(segment->readOffset < segment->writeOffset);
+
+        uint32_t length;
+        memcpy(&length, segment->data + segment->readOffset, RECORD_HEADER);
+        data = segment->data + segment->readOffset + RECORD_HEADER;
+        size = length;
+        return true;
+    }
+
+    void SpillStore::consume()
+    {
+        assert(m_numRecords > 0 && m_first->readOffset < m_first->writeOffset);
+
+        uint32_t length;
+        memcpy(&length, m_first->data + m_first->readOffset, RECORD_HEADER);
+        m_first->readOffset += recordSize(length);
+        --m_numRecords;
+
+        // Done with it once the writer has moved on to a later segment, or everything is read
+        if(m_first->readOffset == m_first->writeOffset && (m_first->next != nullptr || m_numRecords == 0))
+            removeSegment(m_first);
+    }
+
+    bool SpillStore::isEmpty() const
+    {
+        return m_numRecords == 0;
+    }
+
+    size_t SpillStore::numRecords() const
+    {
+        return m_numRecords;
+    }
+
+    size_t SpillStore::numSegments() const
+    {
+        return m_numSegments;
+    }
+
+}
\ No newline at end of file
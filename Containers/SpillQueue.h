@@ -0,0 +1,285 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Unbounded queue that overflows to memory-mapped files on disk past a memory limit
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "ConcurrentQueue.h"
+#include "../Mutex/ParkingMutex.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    // Elements a SpillQueue keeps in memory before it starts writing them to disk
+    #ifndef DEFAULT_SPILL_THRESHOLD
+        #define DEFAULT_SPILL_THRESHOLD 65536
+    #endif
+
+    // Size of a spill segment file, records that don't fit get a segment of their own
+    #ifndef DEFAULT_SPILL_SEGMENT_SIZE
+        #define DEFAULT_SPILL_SEGMENT_SIZE (64 * 1024 * 1024)
+    #endif
+
+    /*! \brief TrivialCodec is the default SpillQueue codec, it writes the element's bytes as they
+        are. Only for trivially copyable types without pointers, anything else needs a codec of its
+        own with the same two methods.
+    */
+    template <typename T>
+    struct TrivialCodec
+    {
+        void encode(const T& value, std::vector<char>& out) const
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "TrivialCodec needs a trivially copyable type, write a codec for this one");
+            const size_t offset = out.size();
+            out.resize(offset + sizeof(T));
+            memcpy(&out[offset], &value, sizeof(T));
+        }
+
+        bool decode(const char* data, size_t size, T& out) const
+        {
+            if(size != sizeof(T))
+                return false;
+            memcpy(&out, data, sizeof(T));
+            return true;
+        }
+    };
+
+    /*! \brief SpillStore is the disk half of SpillQueue: a FIFO of byte records appended to
+        memory-mapped segment files in a directory. Segment pages are backed by their file, so the
+        kernel can write them out and drop them instead of the process growing. A segment is
+        deleted as soon as its last record has been read.
+
+        Not thread safe, SpillQueue locks around it. Nothing survives the process, whatever is left
+        is deleted by the destructor.
+    */
+    class SpillStore
+    {
+    public:
+        SpillStore(const std::string& directory, size_t segmentSize);
+        ~SpillStore();
+
+        /*! \brief Appends a record, returns false if a new segment file couldn't be created
+        */
+        bool    append(const char* data, size_t size);
+        /*! \brief Points data at the oldest record, valid until consume(). False if there is none.
+        */
+        bool    peek(const char*& data, size_t& size) const;
+        void    consume();
+
+        bool    isEmpty() const;
+        size_t  numRecords() const;
+        size_t  numSegments() const;
+
+    private:
+        struct Segment;
+
+        bool    addSegment(size_t minimumSize);
+        void    removeSegment(Segment* segment);
+
+        const std::string   m_directory;
+        const size_t        m_segmentSize;
+        // Read from the first, append to the last
+        Segment*            m_first;
+        Segment*            m_last;
+        size_t              m_numRecords;
+        size_t              m_numSegments;
+        uint64_t            m_nextSegmentId;
+
+        SpillStore(const SpillStore&);
+        SpillStore(SpillStore&&);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief SpillQueue is a ConcurrentQueue with a memory limit. Up to memoryLimit elements are
+        kept in memory as usual; past that pushes are encoded with Codec and appended to a SpillStore
+        on disk, and they keep going there until the consumers have read the disk back empty. Pops
+        drain memory first, then disk, so each producer's elements still come out in the order it
+        pushed them.
+
+        Meant for the bad day when a consumer stalls: memory stays bounded and nothing is dropped,
+        and while consumers keep up nothing ever touches the disk.
+
+        A Codec has encode(const T&, std::vector<char>& out) appending the bytes, and
+        decode(const char* data, size_t size, T& out) returning false on bad data.
+
+        \code
+        SpillQueue<Event> events("/var/spool/myservice", 100000);
+        ...
+        if(!events.push(event))
+            ; // Over the limit and the disk is full too
+        \endcode
+    */
+    template <typename T, typename Codec = TrivialCodec<T> >
+    class SpillQueue
+    {
+    public:
+        explicit SpillQueue(const std::string& directory, size_t memoryLimit = DEFAULT_SPILL_THRESHOLD, size_t segmentSize = DEFAULT_SPILL_SEGMENT_SIZE, const Codec& codec = Codec());
+        ~SpillQueue();
+
+        /*! \brief Returns false only if the element had to go to disk and writing it failed
+        */
+        bool    push(const T& in);
+        bool    push(T&& moveIn);
+        bool    pop(T& out);
+
+        bool    isEmpty() const;
+        size_t  size() const;
+        /*! \brief Elements currently on disk
+        */
+        size_t  spilledSize() const;
+        bool    isSpilling() const;
+
+    private:
+        enum SpillResult
+        {
+            NOT_SPILLED,
+            SPILLED,
+            SPILL_FAILED
+        };
+
+        // Sends in to disk if the queue is over its limit or already spilling
+        SpillResult spill(const T& in);
+
+        ConcurrentQueue<T>  m_memory;
+        const size_t        m_memoryLimit;
+        Codec               m_codec;
+
+        // Set from the first spilled element until the disk has been read back empty
+        DX_CACHE_ALIGNED std::atomic<bool> m_spilling;
+        std::atomic<size_t> m_numSpilled;
+        ParkingMutex        m_spillMutex;
+        SpillStore          m_store;
+        std::vector<char>   m_encoded;
+
+        SpillQueue(const SpillQueue&);
+        SpillQueue(SpillQueue&&);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    template <typename T, typename Codec>
+    SpillQueue<T, Codec>::SpillQueue(const std::string& directory, size_t memoryLimit, size_t segmentSize, const Codec& codec) :
+        m_memoryLimit(memoryLimit), m_codec(codec), m_spilling(false), m_numSpilled(0), m_store(directory, segmentSize)
+    {
+    }
+
+    template <typename T, typename Codec>
+    SpillQueue<T, Codec>::~SpillQueue()
+    {
+    }
+
+    template <typename T, typename Codec>
+    typename SpillQueue<T, Codec>::SpillResult SpillQueue<T, Codec>::spill(const T& in)
+    {
+        // Common case, checked without the lock
+        if(!m_spilling.load(std::memory_order_acquire) && m_memory.size() < m_memoryLimit)
+            return NOT_SPILLED;
+
+        std::lock_guard<ParkingMutex> lock(m_spillMutex);
+        // Consumers may have read the disk back empty in the meantime
+        if(!m_spilling.load(std::memory_order_relaxed) && m_memory.size() < m_memoryLimit)
+            return NOT_SPILLED;
+
+        m_encoded.clear();
+        m_codec.encode(in, m_encoded);
+        if(!m_store.append(m_encoded.empty() ? nullptr : &m_encoded[0], m_encoded.size()))
+            return SPILL_FAILED;
+
+        ++m_numSpilled;
+        m_spilling.store(true, std::memory_order_release);
+        return SPILLED;
+    }
+
+    template <typename T, typename Codec>
+    bool SpillQueue<T, Codec>::push(const T& in)
+    {
+        const SpillResult result = spill(in);
+        if(result != NOT_SPILLED)
+            return result == SPILLED;
+
+        m_memory.push(in);
+        return true;
+    }
+
+    template <typename T, typename Codec>
+    bool SpillQueue<T, Codec>::push(T&& moveIn)
+    {
+        const SpillResult result = spill(moveIn);
+        if(result != NOT_SPILLED)
+            return result == SPILLED;
+
+        m_memory.push(std::move(moveIn));
+        return true;
+    }
+
+    template <typename T, typename Codec>
+    bool SpillQueue<T, Codec>::pop(T& out)
+    {
+        if(m_memory.pop(out))
+            return true;
+        if(!m_spilling.load(std::memory_order_acquire))
+            return false;
+
+        std::lock_guard<ParkingMutex> lock(m_spillMutex);
+        // Try memory again under the lock: a producer may have pushed there right before it spilled
+        // its next element, and that one must not overtake it
+        if(m_memory.pop(out))
+            return true;
+
+        const char* data = nullptr;
+        size_t size = 0;
+        while(m_store.peek(data, size))
+        {
+            const bool decoded = m_codec.decode(data, size, out);
+            assert(decoded); // We wrote it ourselves, so it can only be a codec bug
+            m_store.consume();
+            --m_numSpilled;
+            if(m_store.isEmpty())
+                m_spilling.store(false, std::memory_order_release);
+            if(decoded)
+                return true;
+        }
+
+        m_spilling.store(false, std::memory_order_release);
+        return false;
+    }
+
+    template <typename T, typename Codec>
+    bool SpillQueue<T, Codec>::isEmpty() const
+    {
+        return size() == 0;
+    }
+
+    template <typename T, typename Codec>
+    size_t SpillQueue<T, Codec>::size() const
+    {
+        return m_memory.size() + m_numSpilled.load(std::memory_order_relaxed);
+    }
+
+    template <typename T, typename Codec>
+    size_t SpillQueue<T, Codec>::spilledSize() const
+    {
+        return m_numSpilled.load(std::memory_order_relaxed);
+    }
+
+    template <typename T, typename Codec>
+    bool SpillQueue<T, Codec>::isSpilling() const
+    {
+        return m_spilling.load(std::memory_order_relaxed);
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,427 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Hierarchical timing wheel for large numbers of short-lived timers
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "../CacheLine.h"
+#include "../Mutex/SpinMutex.h"
+#include "../Threading/ThreadId.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    // Bits of the tick handled by each level of the wheel, 8 gives 256 slots per level
+    #ifndef TIMING_WHEEL_BITS
+        #define TIMING_WHEEL_BITS 8
+    #endif
+
+    // Levels of the wheel, timers further out than 2^(bits * levels) ticks are re-armed on expiry
+    #ifndef TIMING_WHEEL_LEVELS
+        #define TIMING_WHEEL_LEVELS 4
+    #endif
+
+    // Number of staging slots arm() spreads threads over, threads beyond that share slots
+    #ifndef DEFAULT_TIMER_STAGING_SLOTS
+        #define DEFAULT_TIMER_STAGING_SLOTS 16
+    #endif
+
+    // Timer records are allocated this many at a time and recycled, never freed before the wheel
+    #ifndef DEFAULT_TIMER_CHUNK
+        #define DEFAULT_TIMER_CHUNK 256
+    #endif
+
+    /*! \brief TimingWheel is a hierarchical timing wheel: a delay queue where arming and cancelling
+        a timer are O(1) no matter how many timers there are. Times are plain uint64_t in whatever
+        unit the caller likes (e.g. milliseconds of a monotonic clock), grouped into ticks of
+        tickLength. A timer fires on the first pollExpired() at or after its deadline's tick.
+
+        Any thread may arm() and cancel(). Armed timers go to a staging slot picked by thread id, so
+        threads arming concurrently don't fight over one lock; pollExpired() moves them into the
+        wheel in batches. pollExpired() itself must only be called by one thread at a time, usually
+        an event loop's timer thread.
+
+        cancel() only flips the timer's state, the record is reclaimed when the wheel reaches it,
+        so cancelled timers keep their value alive until then.
+
+        \code
+        TimingWheel<ConnectionId> timeouts(0, 10); // 10 ms ticks
+        ...
+        connection.timeout = timeouts.arm(nowMs() + 30000, connection.id);
+        ...
+        timeouts.cancel(connection.timeout); // Got a reply in time
+        ...
+        std::vector<ConnectionId> expired;
+        timeouts.pollExpired(nowMs(), expired);
+        for(size_t i = 0; i < expired.size(); ++i)
+            closeConnection(expired[i]);
+        \endcode
+    */
+    template <typename T>
+    class TimingWheel
+    {
+        struct Record;
+
+    public:
+        /*! \brief Identifies an armed timer. Stays safe to cancel() after the timer has fired or the
+            record has been reused, cancel() just returns false then.
+        */
+        class Handle
+        {
+        public:
+            Handle() : m_record(nullptr), m_generation(0) {}
+
+            bool isValid() const { return m_record != nullptr; }
+
+        private:
+            friend class TimingWheel;
+            Handle(Record* record, uint64_t generation) : m_record(record), m_generation(generation) {}
+
+            Record*     m_record;
+            uint64_t    m_generation;
+        };
+
+        /*! \param[in] start The current time, nothing is considered expired before it
+            \param[in] tickLength How many time units one tick of the wheel covers
+        */
+        explicit TimingWheel(uint64_t start = 0, uint64_t tickLength = 1);
+        ~TimingWheel();
+
+        /*! \brief Arms a timer that delivers value once deadline has passed. Thread safe.
+        */
+        Handle  arm(uint64_t deadline, const T& value);
+        /*! \brief Cancels the timer. Returns true if it was still armed, meaning it will never fire.
+            Thread safe.
+        */
+        bool    cancel(const Handle& handle);
+
+        /*! \brief Advances the wheel to now and appends the values of every expired timer to out.
+            Returns how many were appended. Only one thread may poll at a time.
+        */
+        size_t  pollExpired(uint64_t now, std::vector<T>& out);
+
+        /*! \brief Number of armed timers that have neither fired nor been cancelled
+        */
+        size_t  size() const;
+
+    private:
+        static const uint64_t FREE = 0;
+        static const uint64_t ARMED = 1;
+        static const uint64_t CANCELLED = 2;
+        static const uint64_t FIRED = 3;
+        static const uint64_t STATE_MASK = 3;
+
+        static const size_t   SLOTS_PER_LEVEL = size_t(1) << TIMING_WHEEL_BITS;
+        static const uint64_t SLOT_MASK = SLOTS_PER_LEVEL - 1;
+
+        struct Record
+        {
+            Record() : state(FREE), deadline(0), next(nullptr), stagingSlot(0), value() {}
+
+            // Generation in the high bits, one of the states above in the low two
+            std::atomic<uint64_t>   state;
+            // In ticks
+            uint64_t                deadline;
+            Record*                 next;
+            size_t                  stagingSlot;
+            T                       value;
+        };
+
+        struct DX_CACHE_ALIGNED StagingSlot
+        {
+            StagingSlot() : staged(nullptr), freeList(nullptr) {}
+
+            CompactSpinMutex        mutex;
+            // Armed since the last poll
+            Record*                 staged;
+            Record*                 freeList;
+            std::vector<Record*>    chunks;
+        };
+
+        void    insert(Record* record);
+        void    expire(Record* list, std::vector<T>& out, size_t& expired);
+        void    cascade(size_t level);
+        void    release(Record* record);
+        void    flushReleased();
+
+        StagingSlot             m_staging[DEFAULT_TIMER_STAGING_SLOTS];
+        DX_CACHE_ALIGNED std::atomic<size_t> m_armed;
+        // Everything below is only touched by the polling thread
+        DX_CACHE_ALIGNED const uint64_t m_tickLength;
+        uint64_t                m_current;
+        // Timers in each level, empty levels are skipped over instead of ticked through
+        size_t                  m_levelSizes[TIMING_WHEEL_LEVELS];
+        Record*                 m_wheel[TIMING_WHEEL_LEVELS][SLOTS_PER_LEVEL];
+        // Due by the time they were inserted
+        Record*                 m_due;
+        // Records to hand back to each staging slot's free list at the end of the poll
+        Record*                 m_released[DEFAULT_TIMER_STAGING_SLOTS];
+
+        TimingWheel(const TimingWheel&);
+        TimingWheel(TimingWheel&&);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    template <typename T>
+    TimingWheel<T>::TimingWheel(uint64_t start, uint64_t tickLength)
+        : m_armed(0), m_tickLength(tickLength == 0 ? 1 : tickLength), m_current(start / m_tickLength), m_due(nullptr)
+    {
+        for(size_t level = 0; level < TIMING_WHEEL_LEVELS; ++level)
+        {
+            m_levelSizes[level] = 0;
+            for(size_t slot = 0; slot < SLOTS_PER_LEVEL; ++slot)
+                m_wheel[level][slot] = nullptr;
+        }
+        for(size_t i = 0; i < DEFAULT_TIMER_STAGING_SLOTS; ++i)
+            m_released[i] = nullptr;
+    }
+
+    template <typename T>
+    TimingWheel<T>::~TimingWheel()
+    {
+        for(size_t i = 0; i < DEFAULT_TIMER_STAGING_SLOTS; ++i)
+        {
+            for(size_t chunk = 0; chunk < m_staging[i].chunks.size(); ++chunk)
+                delete[] m_staging[i].chunks[chunk];
+        }
+    }
+
+    template <typename T>
+    typename TimingWheel<T>::Handle TimingWheel<T>::arm(uint64_t deadline, const T& value)
+    {
+        const size_t slotIndex = currentThreadId() % DEFAULT_TIMER_STAGING_SLOTS;
+        StagingSlot& slot = m_staging[slotIndex];
+
+        Record* record = nullptr;
+        uint64_t generation = 0;
+        {
+            std::lock_guard<CompactSpinMutex> lock(slot.mutex);
+            if(slot.freeList == nullptr)
+            {
+                Record* chunk = new Record[DEFAULT_TIMER_CHUNK];
+                slot.chunks.push_back(chunk);
+                for(size_t i = 0; i < DEFAULT_TIMER_CHUNK; ++i)
+                {
+                    chunk[i].stagingSlot = slotIndex;
+                    chunk[i].next = slot.freeList;
+                    slot.freeList = &chunk[i];
+                }
+            }
+            record = slot.freeList;
+            slot.freeList = record->next;
+
+            // Round up, a timer must never fire early
+            record->deadline = deadline / m_tickLength + (deadline % m_tickLength != 0 ? 1 : 0);
+            record->value = value;
+            generation = (record->state.load(std::memory_order_relaxed) >> 2) + 1;
+            record->state.store((generation << 2) | ARMED, std::memory_order_release);
+            record->next = slot.staged;
+            slot.staged = record;
+        }
+        m_armed.fetch_add(1, std::memory_order_relaxed);
+        return Handle(record, generation);
+    }
+
+    template <typename T>
+    bool TimingWheel<T>::cancel(const Handle& handle)
+    {
+        if(handle.m_record == nullptr)
+            return false;
+        uint64_t expected = (handle.m_generation << 2) | ARMED;
+        if(!handle.m_record->state.compare_exchange_strong(expected, (handle.m_generation << 2) | CANCELLED, std::memory_order_acq_rel))
+            return false;
+        m_armed.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    template <typename T>
+    size_t TimingWheel<T>::size() const
+    {
+        return m_armed.load(std::memory_order_relaxed);
+    }
+
+    template <typename T>
+    void TimingWheel<T>::insert(Record* record)
+    {
+        if((record->state.load(std::memory_order_acquire) & STATE_MASK) != ARMED)
+        {
+            release(record);
+            return;
+        }
+
+        if(record->deadline <= m_current)
+        {
+            record->next = m_due;
+            m_due = record;
+            return;
+        }
+
+        // The lowest level whose range reaches the deadline. Beyond the top level, park it in the
+        // top level's furthest slot, expire() re-inserts it when it gets there.
+        const uint64_t delta = record->deadline - m_current;
+        size_t level = 0;
+        while(level + 1 < TIMING_WHEEL_LEVELS && delta >= (uint64_t(1) << (TIMING_WHEEL_BITS * (level + 1))))
+            ++level;
+        uint64_t tick = record->deadline;
+        if(level + 1 == TIMING_WHEEL_LEVELS && TIMING_WHEEL_BITS * TIMING_WHEEL_LEVELS < 64
+            && delta >= (uint64_t(1) << (TIMING_WHEEL_BITS * TIMING_WHEEL_LEVELS)))
+        {
+            tick = m_current + ((uint64_t(1) << (TIMING_WHEEL_BITS * TIMING_WHEEL_LEVELS)) - 1);
+        }
+
+        Record*& head = m_wheel[level][(tick >> (TIMING_WHEEL_BITS * level)) & SLOT_MASK];
+        record->next = head;
+        head = record;
+        ++m_levelSizes[level];
+    }
+
+    template <typename T>
+    void TimingWheel<T>::expire(Record* list, std::vector<T>& out, size_t& expired)
+    {
+        while(list != nullptr)
+        {
+            Record* record = list;
+            list = record->next;
+
+            if(record->deadline > m_current)
+            {
+                // Was too far out for the wheel, or cascaded down
+                insert(record);
+                continue;
+            }
+
+            const uint64_t state = record->state.load(std::memory_order_relaxed);
+            uint64_t expected = (state & ~STATE_MASK) | ARMED;
+            if(record->state.compare_exchange_strong(expected, (state & ~STATE_MASK) | FIRED, std::memory_order_acq_rel))
+            {
+                m_armed.fetch_sub(1, std::memory_order_relaxed);
+                out.push_back(std::move(record->value));
+                ++expired;
+            }
+            release(record);
+        }
+    }
+
+    template <typename T>
+    void TimingWheel<T>::cascade(size_t level)
+    {
+        const size_t slot = static_cast<size_t>((m_current >> (TIMING_WHEEL_BITS * level)) & SLOT_MASK);
+        // Coarser levels first, so their timers can land in this one
+        if(slot == 0 && level + 1 < TIMING_WHEEL_LEVELS)
+            cascade(level + 1);
+
+        Record* list = m_wheel[level][slot];
+        m_wheel[level][slot] = nullptr;
+        while(list != nullptr)
+        {
+            Record* record = list;
+            list = record->next;
+            --m_levelSizes[level];
+            insert(record);
+        }
+    }
+
+    template <typename T>
+    void TimingWheel<T>::release(Record* record)
+    {
+        record->next = m_released[record->stagingSlot];
+        m_released[record->stagingSlot] = record;
+    }
+
+    template <typename T>
+    void TimingWheel<T>::flushReleased()
+    {
+        for(size_t i = 0; i < DEFAULT_TIMER_STAGING_SLOTS; ++i)
+        {
+            Record* released = m_released[i];
+            if(released == nullptr)
+                continue;
+            m_released[i] = nullptr;
+
+            Record* last = released;
+            while(last->next != nullptr)
+                last = last->next;
+
+            std::lock_guard<CompactSpinMutex> lock(m_staging[i].mutex);
+            last->next = m_staging[i].freeList;
+            m_staging[i].freeList = released;
+        }
+    }
+
+    template <typename T>
+    size_t TimingWheel<T>::pollExpired(uint64_t now, std::vector<T>& out)
+    {
+        for(size_t i = 0; i < DEFAULT_TIMER_STAGING_SLOTS; ++i)
+        {
+            Record* staged = nullptr;
+            {
+                std::lock_guard<CompactSpinMutex> lock(m_staging[i].mutex);
+                staged = m_staging[i].staged;
+                m_staging[i].staged = nullptr;
+            }
+            while(staged != nullptr)
+            {
+                Record* record = staged;
+                staged = record->next;
+                insert(record);
+            }
+        }
+
+        size_t expired = 0;
+        const uint64_t target = now / m_tickLength;
+        while(m_current < target)
+        {
+            // Jump to the last tick before the next boundary of the lowest non-empty level, nothing
+            // can expire or cascade on the way there
+            size_t emptyLevels = 0;
+            while(emptyLevels < TIMING_WHEEL_LEVELS && m_levelSizes[emptyLevels] == 0)
+                ++emptyLevels;
+            if(emptyLevels == TIMING_WHEEL_LEVELS || TIMING_WHEEL_BITS * emptyLevels >= 64)
+            {
+                m_current = target;
+                break;
+            }
+            if(emptyLevels > 0)
+            {
+                const uint64_t skipTo = m_current | ((uint64_t(1) << (TIMING_WHEEL_BITS * emptyLevels)) - 1);
+                if(skipTo >= target)
+                {
+                    m_current = target;
+                    break;
+                }
+                m_current = skipTo;
+            }
+
+            ++m_current;
+            const size_t slot = static_cast<size_t>(m_current & SLOT_MASK);
+            if(slot == 0 && TIMING_WHEEL_LEVELS > 1)
+                cascade(1);
+
+            Record* list = m_wheel[0][slot];
+            m_wheel[0][slot] = nullptr;
+            for(Record* record = list; record != nullptr; record = record->next)
+                --m_levelSizes[0];
+            expire(list, out, expired);
+        }
+
+        Record* due = m_due;
+        m_due = nullptr;
+        expire(due, out, expired);
+
+        flushReleased();
+        return expired;
+    }
+
+}
\ No newline at end of file
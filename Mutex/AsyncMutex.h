@@ -0,0 +1,152 @@
+
+#pragma once
+
+#include "SpinMutex.h"
+#include "../Threading/Coroutine.h"
+
+#include <cassert>
+
+#ifdef DX_HAS_COROUTINES
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief AsyncMutex is a mutex for coroutines: co_await mutex.lockAsync() suspends the
+        coroutine instead of blocking the thread while the mutex is held. unlock() hands the mutex
+        straight to the longest waiting coroutine and resumes it on the executor it asked for, or
+        inline on the unlocking thread if it didn't. Waiting doesn't allocate.
+
+        Only available in C++20 code, it is header-only so the library itself can stay C++11.
+
+        \note AsyncMutex is not recursive, and since coroutines can move between threads, it isn't
+        tied to a thread either: any thread may unlock it.
+
+        \code
+        Task<void> appendRecord(AsyncMutex& logMutex, Log& log, Record record)
+        {
+            co_await logMutex.lockAsync(&ioExecutor);
+            log.append(record);
+            logMutex.unlock();
+        }
+        \endcode
+    */
+    class AsyncMutex
+    {
+    public:
+        class LockAwaiter : private AsyncWaiter
+        {
+        public:
+            LockAwaiter(AsyncMutex& mutex, Executor* executor) : m_mutex(mutex)
+            {
+                this->executor = executor;
+            }
+
+            bool await_ready()
+            {
+                return m_mutex.tryLock();
+            }
+
+            bool await_suspend(std::coroutine_handle<> handle)
+            {
+                setContinuation(*this, handle);
+                return m_mutex.suspendLock(*this);
+            }
+
+            void await_resume()
+            {
+            }
+
+        private:
+            AsyncMutex& m_mutex;
+        };
+
+        AsyncMutex();
+        ~AsyncMutex();
+
+        bool        tryLock();
+        LockAwaiter lockAsync(Executor* executor = nullptr);
+        void        unlock();
+
+    private:
+        // Queues waiter unless the mutex is free, returns false if it took the mutex instead
+        bool        suspendLock(AsyncWaiter& waiter);
+
+        SpinMutex       m_stateMutex;
+        bool            m_locked;
+        AsyncWaiter*    m_waitersHead;
+        AsyncWaiter*    m_waitersTail;
+
+        AsyncMutex(const AsyncMutex&);
+        AsyncMutex(AsyncMutex&&);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    inline AsyncMutex::AsyncMutex() : m_locked(false), m_waitersHead(nullptr), m_waitersTail(nullptr)
+    {
+    }
+
+    inline AsyncMutex::~AsyncMutex()
+    {
+        assert(!m_locked && m_waitersHead == nullptr);
+    }
+
+    inline bool AsyncMutex::tryLock()
+    {
+        SpinLock stateLock(m_stateMutex);
+        if(m_locked)
+            return false;
+        m_locked = true;
+        return true;
+    }
+
+    inline AsyncMutex::LockAwaiter AsyncMutex::lockAsync(Executor* executor)
+    {
+        return LockAwaiter(*this, executor);
+    }
+
+    inline bool AsyncMutex::suspendLock(AsyncWaiter& waiter)
+    {
+        SpinLock stateLock(m_stateMutex);
+        if(!m_locked)
+        {
+            m_locked = true;
+            return false;
+        }
+
+        waiter.next = nullptr;
+        if(m_waitersTail == nullptr)
+            m_waitersHead = &waiter;
+        else
+            m_waitersTail->next = &waiter;
+        m_waitersTail = &waiter;
+        return true;
+    }
+
+    inline void AsyncMutex::unlock()
+    {
+        AsyncWaiter* next = nullptr;
+        {
+            SpinLock stateLock(m_stateMutex);
+            assert(m_locked);
+            next = m_waitersHead;
+            if(next == nullptr)
+            {
+                m_locked = false;
+                return;
+            }
+            // Ownership goes straight to the waiter, m_locked stays set
+            m_waitersHead = next->next;
+            if(m_waitersHead == nullptr)
+                m_waitersTail = nullptr;
+        }
+        next->resume();
+    }
+
+}
+
+#endif
\ No newline at end of file
@@ -10,7 +10,7 @@ namespace DX
     ////////////////////////////////////////////////////////////////////////////////////////////////
     ////////////////////////////////////////////////////////////////////////////////////////////////
 
-    class Barrier
+    class DX_CACHE_ALIGNED Barrier
     {
     public:
         explicit Barrier(size_t numThreads);
@@ -19,9 +19,7 @@ namespace DX
         virtual void wait() const = 0;
 
     protected:
-        volatile char pad_0[CACHE_LINE_SIZE];
         mutable std::atomic<size_t> m_count;
-        volatile char pad_1[CACHE_LINE_SIZE - (sizeof(std::atomic<size_t>) % CACHE_LINE_SIZE)];
 
     private:
         Barrier(const Barrier&);
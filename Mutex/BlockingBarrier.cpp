@@ -0,0 +1,77 @@
+
+#include "BlockingBarrier.h"
+
+#include <cassert>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    BlockingBarrier::BlockingBarrier(size_t numThreads, const std::function<void()>& completion, size_t spinCount)
+        : Barrier(numThreads), m_completion(completion), m_spinCount(spinCount), m_expected(numThreads),
+        m_phase(0), m_sleepers(0)
+    {
+        assert(numThreads > 0);
+    }
+
+    BlockingBarrier::~BlockingBarrier()
+    {
+    }
+
+    void BlockingBarrier::wait() const
+    {
+        arriveAndWait();
+    }
+
+    size_t BlockingBarrier::arrive() const
+    {
+        // Our phase can't end before we've arrived, so reading it first is safe
+        const uint32_t phase = m_phase.load(std::memory_order_acquire);
+        assert(m_count > 0); // More arrivals than threads
+        if(m_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            complete(phase);
+        return phase;
+    }
+
+    void BlockingBarrier::arriveAndWait() const
+    {
+        wait(arrive());
+    }
+
+    void BlockingBarrier::arriveAndDrop() const
+    {
+        // Lowered before arriving so whoever completes this phase sees it when resetting
+        m_expected.fetch_sub(1, std::memory_order_relaxed);
+        arrive();
+    }
+
+    bool BlockingBarrier::hasCompleted(size_t token) const
+    {
+        return m_phase.load(std::memory_order_acquire) != static_cast<uint32_t>(token);
+    }
+
+    void BlockingBarrier::wait(size_t token) const
+    {
+        // Parks while the phase is still the one token was handed out in
+        futexPark(m_phase, static_cast<uint32_t>(token), m_sleepers, m_spinCount, [this, token]() { return hasCompleted(token); });
+    }
+
+    bool BlockingBarrier::waitFor(size_t token, std::chrono::nanoseconds timeout) const
+    {
+        return futexParkFor(m_phase, static_cast<uint32_t>(token), m_sleepers, m_spinCount, timeout,
+            [this, token]() { return hasCompleted(token); });
+    }
+
+    void BlockingBarrier::complete(uint32_t phase) const
+    {
+        // Nobody can arrive at the next phase before we release this one, so reset first
+        m_count.store(m_expected.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        if(m_completion)
+            m_completion();
+        m_phase.store(phase + 1);
+        futexWakeAllSleepers(m_phase, m_sleepers);
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+
+#pragma once
+
+#include "Barrier.h"
+#include "Futex.h"
+
+#include <functional>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief BlockingBarrier is a reusable barrier that spins for a short while and then parks
+        waiting threads in the kernel (futex / WaitOnAddress). Unlike SpinBarrier and
+        CyclicSpinBarrier, early arrivers give their CPU back, so the barrier keeps working when
+        there are more threads than cores to run them.
+
+        Arriving and waiting are separate steps: arrive() returns a token for the phase the thread
+        arrived in, which can then be waited on with wait() or waitFor(). arriveAndWait() does both.
+        A thread that is done for good calls arriveAndDrop(), which counts as its arrival for the
+        current phase and lowers the number of threads expected in every later phase.
+
+        An optional completion function is run exactly once per phase, by the last thread to arrive,
+        before any thread is released.
+
+        \code
+        BlockingBarrier barrier(numThreads);
+
+        void worker()
+        {
+            while(hasWork())
+            {
+                doWork();
+                const size_t token = barrier.arrive();
+                doIndependentWork(); // Overlaps with the stragglers
+                if(!barrier.waitFor(token, std::chrono::seconds(5)))
+                    reportStall();
+            }
+            barrier.arriveAndDrop();
+        }
+        \endcode
+    */
+    class BlockingBarrier : public Barrier
+    {
+    public:
+        /*! \param[in] numThreads The number of threads that have to arrive each phase
+            \param[in] completion Called once per phase by the last thread to arrive. May be empty.
+            \param[in] spinCount How many times to check for the phase to end before parking
+        */
+        explicit BlockingBarrier(size_t numThreads = 1, const std::function<void()>& completion = std::function<void()>(),
+            size_t spinCount = DEFAULT_PARK_SPINS);
+        ~BlockingBarrier();
+
+        /*! \brief Same as arriveAndWait()
+        */
+        void wait() const;
+
+        /*! \brief Arrives at the barrier without waiting and returns the token of the current phase
+        */
+        size_t arrive() const;
+        /*! \brief Blocks until the phase identified by token has completed
+        */
+        void wait(size_t token) const;
+        /*! \brief Blocks until the phase identified by token has completed or timeout has passed.
+            Returns false on timeout. The thread still counts as arrived either way.
+        */
+        bool waitFor(size_t token, std::chrono::nanoseconds timeout) const;
+
+        void arriveAndWait() const;
+        /*! \brief Arrives at the current phase and removes the caller from all further phases
+        */
+        void arriveAndDrop() const;
+
+    private:
+        bool hasCompleted(size_t token) const;
+        void complete(uint32_t phase) const;
+
+        const std::function<void()> m_completion;
+        const size_t m_spinCount;
+        // Number of threads taking part in the next phase, lowered by arriveAndDrop()
+        mutable std::atomic<size_t> m_expected;
+        // Futex word waiters block on, and how many of them are (about to be) parked
+        DX_CACHE_ALIGNED mutable std::atomic<uint32_t> m_phase;
+        mutable std::atomic<uint32_t> m_sleepers;
+
+        BlockingBarrier(const BlockingBarrier&);
+        BlockingBarrier(BlockingBarrier&&);
+    };
+
+}
\ No newline at end of file
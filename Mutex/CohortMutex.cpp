@@ -0,0 +1,179 @@
+
+#include "CohortMutex.h"
+#include "../Threading/Topology.h"
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    namespace
+    {
+        const size_t NO_NODE = ~size_t(0);
+
+        thread_local size_t t_threadNode = NO_NODE;
+    }
+
+    size_t CohortMutex::numNodes()
+    {
+        return Topology::instance().numNodes();
+    }
+
+    size_t CohortMutex::currentNode()
+    {
+        if(t_threadNode != NO_NODE)
+            return t_threadNode;
+        return Topology::currentNode();
+    }
+
+    void CohortMutex::setThreadNode(size_t node)
+    {
+        t_threadNode = node;
+    }
+
+    void CohortMutex::clearThreadNode()
+    {
+        t_threadNode = NO_NODE;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    CohortMutex::CohortMutex(size_t maxLocalHandoffs)
+        : m_globalNext(0), m_globalServing(0), m_cohorts(nullptr), m_numCohorts(numNodes()),
+          m_maxHandoffs(maxLocalHandoffs), m_ownerCohort(0)
+    #ifdef DX_LOCK_PROFILING
+        , m_stats("CohortMutex", this)
+    #endif
+    {
+        m_cohorts = new Cohort[m_numCohorts];
+        for(size_t i = 0; i < m_numCohorts; ++i)
+        {
+            m_cohorts[i].next = 0;
+            m_cohorts[i].serving = 0;
+            m_cohorts[i].ownsGlobal = false;
+            m_cohorts[i].handoffs = 0;
+        }
+    }
+
+    CohortMutex::~CohortMutex()
+    {
+        delete[] m_cohorts;
+    }
+
+    size_t CohortMutex::lockGlobal() const
+    {
+        size_t spins = 0;
+        const size_t ticket = m_globalNext.fetch_add(1, std::memory_order_relaxed);
+        while(m_globalServing.load(std::memory_order_acquire) != ticket)
+        {
+            // Spin out
+            ++spins;
+        }
+        return spins;
+    }
+
+    void CohortMutex::lock() const
+    {
+        #ifdef DX_LOCK_PROFILING
+            const uint64_t waitStart = LockStats::now();
+            size_t spins = 0;
+        #endif
+        const size_t cohortIndex = currentNode() % m_numCohorts;
+        Cohort& cohort = m_cohorts[cohortIndex];
+
+        const size_t ticket = cohort.next.fetch_add(1, std::memory_order_relaxed);
+        while(cohort.serving.load(std::memory_order_acquire) != ticket)
+        {
+            // Spin out
+            #ifdef DX_LOCK_PROFILING
+                ++spins;
+            #endif
+        }
+
+        // The previous owner from our node may have passed the global lock along with the local one
+        if(!cohort.ownsGlobal)
+        {
+            #ifdef DX_LOCK_PROFILING
+                spins += lockGlobal();
+            #else
+                lockGlobal();
+            #endif
+            cohort.ownsGlobal = true;
+        }
+        m_ownerCohort = cohortIndex;
+
+        #ifdef DX_LOCK_PROFILING
+            m_stats.acquired(waitStart, spins);
+        #endif
+    }
+
+    bool CohortMutex::tryLock() const
+    {
+        #ifdef DX_LOCK_PROFILING
+            const uint64_t waitStart = LockStats::now();
+        #endif
+        const size_t cohortIndex = currentNode() % m_numCohorts;
+        Cohort& cohort = m_cohorts[cohortIndex];
+
+        size_t serving = cohort.serving.load(std::memory_order_acquire);
+        if(cohort.next.load(std::memory_order_relaxed) != serving
+            || !cohort.next.compare_exchange_strong(serving, serving + 1, std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        if(!cohort.ownsGlobal)
+        {
+            size_t globalServing = m_globalServing.load(std::memory_order_acquire);
+            if(!m_globalNext.compare_exchange_strong(globalServing, globalServing + 1, std::memory_order_acquire))
+            {
+                // Another node has it, hand our local lock to whoever queued up behind us
+                cohort.serving.store(serving + 1, std::memory_order_release);
+                return false;
+            }
+            cohort.ownsGlobal = true;
+        }
+        m_ownerCohort = cohortIndex;
+
+        #ifdef DX_LOCK_PROFILING
+            m_stats.acquired(waitStart, 0);
+        #endif
+        return true;
+    }
+
+    void CohortMutex::unlock() const
+    {
+        #ifdef DX_LOCK_PROFILING
+            m_stats.released();
+        #endif
+        Cohort& cohort = m_cohorts[m_ownerCohort];
+        const size_t serving = cohort.serving.load(std::memory_order_relaxed);
+        const bool localWaiters = cohort.next.load(std::memory_order_relaxed) != serving + 1;
+
+        if(localWaiters && cohort.handoffs < m_maxHandoffs)
+        {
+            // Keep the global lock on this node and pass the local lock on
+            ++cohort.handoffs;
+            cohort.serving.store(serving + 1, std::memory_order_release);
+            return;
+        }
+
+        cohort.handoffs = 0;
+        cohort.ownsGlobal = false;
+        m_globalServing.store(m_globalServing.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        cohort.serving.store(serving + 1, std::memory_order_release);
+    }
+
+    void CohortMutex::setProfileName(const char* name)
+    {
+        #ifdef DX_LOCK_PROFILING
+            m_stats.setName(name);
+        #else
+            (void)name;
+        #endif
+    }
+
+}
\ No newline at end of file
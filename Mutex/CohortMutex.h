@@ -0,0 +1,103 @@
+
+#pragma once
+
+#include "../CacheLine.h"
+#include "Mutex.h"
+#include "LockProfiler.h"
+
+#include <atomic>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    // How many times in a row a CohortMutex may be handed to a waiter on the same node before it
+    // has to give the other nodes a turn
+    #ifndef DEFAULT_COHORT_HANDOFFS
+        #define DEFAULT_COHORT_HANDOFFS 64
+    #endif
+
+    /*! \brief CohortMutex is a NUMA-aware mutex. Every NUMA node has its own local ticket lock, and
+        a global ticket lock decides which node holds the mutex. When a thread unlocks and another
+        thread on the same node is waiting, the mutex goes straight to it without giving up the
+        global lock. The protected data then stays in that node's caches instead of crossing the
+        interconnect on every hand-off.
+
+        Up to maxLocalHandoffs consecutive hand-offs stay on one node, after that the global lock is
+        released so other nodes can't starve. On a single node machine it behaves like a fair ticket
+        lock.
+
+        The nodes come from Topology. Set the DX_NUMA_NODES environment variable to N to pretend
+        there are N nodes (cpu i belongs to node i % N), or call setThreadNode() to place individual
+        threads, e.g. to test on a single node machine.
+
+        \note CohortMutex is not recursive. It works with std::lock_guard and std::unique_lock.
+
+        \code
+        CohortMutex sessionsMutex;
+        ...
+        {
+            std::lock_guard<CohortMutex> lock(sessionsMutex);
+            sessions.insert(session);
+        }
+        \endcode
+    */
+    class DX_CACHE_ALIGNED CohortMutex : public Mutex
+    {
+    public:
+        explicit CohortMutex(size_t maxLocalHandoffs = DEFAULT_COHORT_HANDOFFS);
+        ~CohortMutex();
+
+        void lock() const;
+        bool tryLock() const;
+        void unlock() const;
+
+        /*! \brief Names the mutex in LockProfiler dumps. Does nothing unless DX_LOCK_PROFILING is
+            defined.
+        */
+        void setProfileName(const char* name);
+
+        /*! \brief Number of NUMA nodes, at least 1
+        */
+        static size_t numNodes();
+        /*! \brief NUMA node the calling thread is running on, or the one set by setThreadNode()
+        */
+        static size_t currentNode();
+        /*! \brief Makes the calling thread count as running on node, regardless of where it runs
+        */
+        static void setThreadNode(size_t node);
+        /*! \brief Undoes setThreadNode() for the calling thread
+        */
+        static void clearThreadNode();
+
+    private:
+        struct DX_CACHE_ALIGNED Cohort
+        {
+            std::atomic<size_t> next;
+            std::atomic<size_t> serving;
+            // Only touched by whoever holds this cohort's local lock
+            bool                ownsGlobal;
+            size_t              handoffs;
+        };
+
+        // Returns how many times it spun
+        size_t lockGlobal() const;
+
+        mutable std::atomic<size_t> m_globalNext;
+        mutable std::atomic<size_t> m_globalServing;
+        // Every acquisition writes m_ownerCohort, keep it off the line other nodes spin on
+        DX_CACHE_ALIGNED Cohort*    m_cohorts;
+        const size_t                m_numCohorts;
+        const size_t                m_maxHandoffs;
+        // Cohort of the current owner, so unlock() works even if the owner migrated to another node
+        mutable size_t              m_ownerCohort;
+    #ifdef DX_LOCK_PROFILING
+        mutable LockStats           m_stats;
+    #endif
+
+        CohortMutex(const CohortMutex&);
+        CohortMutex(CohortMutex&&);
+    };
+
+}
\ No newline at end of file
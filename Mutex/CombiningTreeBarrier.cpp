@@ -0,0 +1,92 @@
+
+#include "CombiningTreeBarrier.h"
+
+#include <cassert>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    CombiningTreeBarrier::CombiningTreeBarrier(size_t numThreads, size_t fanIn, const std::function<void()>& completion)
+        : Barrier(numThreads), m_initial(numThreads), m_fanIn(fanIn < 2 ? 2 : fanIn), m_completion(completion),
+        m_nodes(nullptr), m_phase(0)
+    {
+        assert(numThreads > 0);
+        assert(fanIn >= 2);
+
+        // Barrier::m_count hands out tickets for wait() without an index
+        m_count = 0;
+
+        size_t numNodes = 0;
+        for(size_t levelWidth = numThreads; ; )
+        {
+            levelWidth = (levelWidth + m_fanIn - 1) / m_fanIn;
+            numNodes += levelWidth;
+            if(levelWidth <= 1)
+                break;
+        }
+
+        m_nodes = new TreeNode[numNodes];
+
+        // Build the tree level by level, each node expects one arrival per child below it
+        size_t levelStart = 0;
+        size_t below = numThreads;
+        for(;;)
+        {
+            const size_t levelWidth = (below + m_fanIn - 1) / m_fanIn;
+            const size_t nextStart = levelStart + levelWidth;
+            for(size_t i = 0; i < levelWidth; ++i)
+            {
+                TreeNode& node = m_nodes[levelStart + i];
+                node.expected = (i + 1 < levelWidth) ? m_fanIn : below - i * m_fanIn;
+                node.count = node.expected;
+                node.parent = levelWidth > 1 ? &m_nodes[nextStart + i / m_fanIn] : nullptr;
+            }
+            if(levelWidth <= 1)
+                break;
+            levelStart = nextStart;
+            below = levelWidth;
+        }
+    }
+
+    CombiningTreeBarrier::~CombiningTreeBarrier()
+    {
+        delete [] m_nodes;
+        m_nodes = nullptr;
+    }
+
+    void CombiningTreeBarrier::wait() const
+    {
+        // A phase hands out exactly m_initial tickets before the next can start
+        wait(m_count.fetch_add(1, std::memory_order_relaxed) % m_initial);
+    }
+
+    void CombiningTreeBarrier::wait(size_t threadIndex) const
+    {
+        assert(threadIndex < m_initial);
+
+        const size_t phase = m_phase.load(std::memory_order_acquire);
+        TreeNode* node = &m_nodes[threadIndex / m_fanIn];
+        while(node->count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            // Last one in at this node, everyone below has arrived so it can be reset for the next phase
+            node->count.store(node->expected, std::memory_order_relaxed);
+            node = node->parent;
+            if(node == nullptr)
+            {
+                if(m_completion)
+                    m_completion();
+                m_phase.store(phase + 1, std::memory_order_release);
+                return;
+            }
+        }
+
+        while(m_phase.load(std::memory_order_acquire) == phase)
+        {
+            // Spin out
+        }
+    }
+
+}
\ No newline at end of file
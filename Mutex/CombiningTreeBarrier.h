@@ -0,0 +1,73 @@
+
+#pragma once
+
+#include "Barrier.h"
+
+#include <functional>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief CombiningTreeBarrier is a reusable, lock-free barrier for large thread counts. Threads
+        arrive at the leaves of a tree of counters, each on its own cache line, with at most fanIn
+        threads per node. The last thread to arrive at a node carries the arrival up to its parent,
+        so no counter is ever touched by more than fanIn threads. The thread completing the root
+        runs the completion function (if any) and releases the phase.
+
+        Threads should identify themselves with wait(threadIndex), where every thread passes a
+        distinct index in [0, numThreads). This keeps neighbouring threads on the same leaf and
+        avoids any shared counter on arrival. wait() without an index draws one from a shared ticket
+        counter instead, which is simpler but costs one contended increment per wait.
+
+        \note Within a single phase, either all threads call wait(threadIndex) or all call wait().
+
+        \code
+        CombiningTreeBarrier barrier(48);
+
+        void worker(size_t threadIndex)
+        {
+            for(size_t step = 0; step < numSteps; ++step)
+            {
+                simulate(threadIndex, step);
+                barrier.wait(threadIndex);
+            }
+        }
+        \endcode
+    */
+    class CombiningTreeBarrier : public Barrier
+    {
+    public:
+        /*! \param[in] numThreads The number of threads that have to call wait() each phase
+            \param[in] fanIn The number of arrivals combined at each node of the tree, at least 2
+            \param[in] completion Called once per phase by the last thread to arrive. May be empty.
+        */
+        explicit CombiningTreeBarrier(size_t numThreads = 1, size_t fanIn = 4, const std::function<void()>& completion = std::function<void()>());
+        ~CombiningTreeBarrier();
+
+        void wait() const;
+        /*! \param[in] threadIndex The caller's index, distinct per thread and less than numThreads
+        */
+        void wait(size_t threadIndex) const;
+
+    private:
+        struct DX_CACHE_ALIGNED TreeNode
+        {
+            std::atomic<size_t> count;
+            size_t              expected;
+            TreeNode*           parent;
+        };
+
+        const size_t m_initial;
+        const size_t m_fanIn;
+        const std::function<void()> m_completion;
+        // Leaves come first, the root is the last node
+        TreeNode* m_nodes;
+        DX_CACHE_ALIGNED mutable std::atomic<size_t> m_phase;
+
+        CombiningTreeBarrier(const CombiningTreeBarrier&);
+        CombiningTreeBarrier(CombiningTreeBarrier&&);
+    };
+
+}
\ No newline at end of file
@@ -1,6 +1,8 @@
 
 #include "CyclicSpinBarrier.h"
 
+#include <cassert>
+
 namespace DX
 {
     ////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,56 @@
+
+#include "Event.h"
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    Event::Event(ResetMode mode, bool set, size_t spinCount) : m_mode(mode), m_spinCount(spinCount), m_state(set ? 1 : 0), m_sleepers(0)
+    {
+    }
+
+    Event::~Event()
+    {
+    }
+
+    void Event::set() const
+    {
+        m_state.store(1);
+        // An auto reset event lets exactly one waiter through
+        if(m_mode == AUTO_RESET)
+            futexWakeOneSleeper(m_state, m_sleepers);
+        else
+            futexWakeAllSleepers(m_state, m_sleepers);
+    }
+
+    void Event::reset() const
+    {
+        m_state.store(0, std::memory_order_relaxed);
+    }
+
+    bool Event::isSet() const
+    {
+        return m_state.load(std::memory_order_acquire) != 0;
+    }
+
+    bool Event::tryWait() const
+    {
+        if(m_mode == MANUAL_RESET)
+            return isSet();
+        uint32_t expected = 1;
+        return m_state.compare_exchange_strong(expected, 0, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    void Event::wait() const
+    {
+        futexPark(m_state, 0, m_sleepers, m_spinCount, [this]() { return tryWait(); });
+    }
+
+    bool Event::waitFor(std::chrono::nanoseconds timeout) const
+    {
+        return futexParkFor(m_state, 0, m_sleepers, m_spinCount, timeout, [this]() { return tryWait(); });
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,81 @@
+
+#pragma once
+
+#include "../CacheLine.h"
+#include "Futex.h"
+
+#include <atomic>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief Event is a flag threads can wait on until another thread sets it.
+
+         - MANUAL_RESET: stays set, releasing every waiter, until reset()
+         - AUTO_RESET: each set() releases a single waiter, which clears the flag again. Setting an
+           event that is already set does nothing, so two set()s in a row may release only one.
+
+        Waiting on a set event is a single load (or compare-and-swap for AUTO_RESET), waiting on an
+        unset one spins briefly and then parks on a futex. set() only makes a system call when
+        somebody is parked.
+
+        \code
+        Event configLoaded(Event::MANUAL_RESET);
+
+        void loader()
+        {
+            loadConfig();
+            configLoaded.set();
+        }
+
+        void worker()
+        {
+            configLoaded.wait();
+            run();
+        }
+        \endcode
+    */
+    class DX_CACHE_ALIGNED Event
+    {
+    public:
+        enum ResetMode
+        {
+            MANUAL_RESET,
+            AUTO_RESET
+        };
+
+        /*! \param[in] mode Whether a released waiter clears the event
+            \param[in] set Whether the event starts out set
+            \param[in] spinCount How many times to check the event before parking
+        */
+        explicit Event(ResetMode mode = MANUAL_RESET, bool set = false, size_t spinCount = DEFAULT_PARK_SPINS);
+        ~Event();
+
+        void set() const;
+        void reset() const;
+        bool isSet() const;
+
+        /*! \brief Returns true if the event was set, clearing it for AUTO_RESET. Never blocks.
+        */
+        bool tryWait() const;
+        /*! \brief Blocks until the event is set
+        */
+        void wait() const;
+        /*! \brief Blocks until the event is set or timeout has passed. Returns false on timeout.
+        */
+        bool waitFor(std::chrono::nanoseconds timeout) const;
+
+    private:
+        const ResetMode m_mode;
+        const size_t m_spinCount;
+        // Futex word, 1 while set. m_sleepers counts (about to be) parked threads
+        mutable std::atomic<uint32_t> m_state;
+        mutable std::atomic<uint32_t> m_sleepers;
+
+        Event(const Event&);
+        Event(Event&&);
+    };
+
+}
\ No newline at end of file
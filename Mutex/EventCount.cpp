@@ -0,0 +1,88 @@
+
+#include "EventCount.h"
+
+#include <cassert>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    EventCount::EventCount(size_t spinCount) : m_spinCount(spinCount), m_epoch(0), m_waiters(0)
+    {
+    }
+
+    EventCount::~EventCount()
+    {
+    }
+
+    EventCount::Key EventCount::prepareWait() const
+    {
+        m_waiters.fetch_add(1);
+        const Key key = m_epoch.load(std::memory_order_acquire);
+        // Pairs with the fence in notify(): either the waiter's re-check sees the notifier's change,
+        // or the notifier sees the waiter
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return key;
+    }
+
+    void EventCount::cancelWait() const
+    {
+        const uint32_t previous = m_waiters.fetch_sub(1, std::memory_order_relaxed);
+        assert(previous != 0); // No matching prepareWait()
+        (void)previous;
+    }
+
+    void EventCount::wait(Key key) const
+    {
+        // A notifier that is already on its way is usually cheaper to wait out than a park
+        for(size_t i = 0; i < m_spinCount && m_epoch.load(std::memory_order_acquire) == key; ++i)
+        {
+            // Spin out
+        }
+        while(m_epoch.load(std::memory_order_acquire) == key)
+            futexWait(m_epoch, key);
+        cancelWait();
+    }
+
+    bool EventCount::waitFor(Key key, std::chrono::nanoseconds timeout) const
+    {
+        for(size_t i = 0; i < m_spinCount && m_epoch.load(std::memory_order_acquire) == key; ++i)
+        {
+            // Spin out
+        }
+        const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + timeout;
+        while(m_epoch.load(std::memory_order_acquire) == key)
+        {
+            const std::chrono::nanoseconds remaining = deadline - std::chrono::steady_clock::now();
+            if(remaining.count() <= 0)
+            {
+                cancelWait();
+                return false;
+            }
+            futexWaitFor(m_epoch, key, remaining);
+        }
+        cancelWait();
+        return true;
+    }
+
+    void EventCount::notify() const
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(m_waiters.load(std::memory_order_relaxed) == 0)
+            return;
+        m_epoch.fetch_add(1, std::memory_order_release);
+        futexWakeOne(m_epoch);
+    }
+
+    void EventCount::notifyAll() const
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(m_waiters.load(std::memory_order_relaxed) == 0)
+            return;
+        m_epoch.fetch_add(1, std::memory_order_release);
+        futexWakeAll(m_epoch);
+    }
+
+}
\ No newline at end of file
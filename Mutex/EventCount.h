@@ -0,0 +1,85 @@
+
+#pragma once
+
+#include "../CacheLine.h"
+#include "Futex.h"
+
+#include <atomic>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief EventCount turns any condition over lock-free data into something threads can block
+        on, without a mutex on either side. Think of it as a condition variable whose lock is the
+        data structure itself.
+
+        A waiter takes a key with prepareWait(), checks its condition once more, and either
+        cancelWait()s if it now holds or wait()s with the key. A notifier changes the data first and
+        then calls notify(). Any notify() after prepareWait() makes wait() return, so no wake-up is
+        lost between the check and the wait; wait() may also return spuriously, so re-check in a
+        loop. wait() spins briefly before parking the thread, notify() is a fence and a load when
+        nobody waits.
+
+        \code
+        EventCount notEmpty;
+
+        // Consumer
+        Item item;
+        while(!queue.tryPop(item))
+        {
+            const EventCount::Key key = notEmpty.prepareWait();
+            if(queue.tryPop(item))
+            {
+                notEmpty.cancelWait();
+                break;
+            }
+            notEmpty.wait(key);
+        }
+
+        // Producer
+        queue.push(item);
+        notEmpty.notify();
+        \endcode
+    */
+    class DX_CACHE_ALIGNED EventCount
+    {
+    public:
+        typedef uint32_t Key;
+
+        /*! \param[in] spinCount How many times wait() checks for a notify() before parking
+        */
+        explicit EventCount(size_t spinCount = DEFAULT_PARK_SPINS);
+        ~EventCount();
+
+        /*! \brief Announces a wait, check the condition after this and before wait()
+        */
+        Key  prepareWait() const;
+        /*! \brief Withdraws a prepareWait() that won't be followed by wait()
+        */
+        void cancelWait() const;
+        /*! \brief Blocks until a notify() after the prepareWait() that returned key
+        */
+        void wait(Key key) const;
+        /*! \brief Like wait(), but gives up after timeout. Returns false on timeout.
+        */
+        bool waitFor(Key key, std::chrono::nanoseconds timeout) const;
+
+        /*! \brief Wakes at least one waiter, if there are any
+        */
+        void notify() const;
+        void notifyAll() const;
+
+    private:
+        const size_t m_spinCount;
+        // Futex word, bumped by every notify() that finds waiters
+        mutable std::atomic<uint32_t> m_epoch;
+        // Threads between prepareWait() and the end of wait() / cancelWait()
+        mutable std::atomic<uint32_t> m_waiters;
+
+        EventCount(const EventCount&);
+        EventCount(EventCount&&);
+    };
+
+}
\ No newline at end of file
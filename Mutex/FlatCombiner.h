@@ -0,0 +1,231 @@
+
+#pragma once
+
+#include "../CacheLine.h"
+#include "../Threading/ThreadId.h"
+
+#include <atomic>
+#include <cassert>
+#include <type_traits>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    // Number of publication records per FlatCombiner, roughly the number of threads expected to use it
+    #ifndef DEFAULT_COMBINER_SLOTS
+        #define DEFAULT_COMBINER_SLOTS 64
+    #endif
+
+    // How many times the combiner re-scans the records for new work before giving up the lock
+    #ifndef DEFAULT_COMBINER_PASSES
+        #define DEFAULT_COMBINER_PASSES 3
+    #endif
+
+    /*! \brief FlatCombiner protects a T and applies operations to it on behalf of many threads. A
+        thread publishes its operation in a publication record and, if nobody is combining, becomes
+        the combiner and runs every published operation in one go. Everybody else just waits for
+        their record to be marked done.
+
+        With a regular mutex every critical section drags the protected data over to a new core.
+        With a FlatCombiner, a whole batch of operations runs on one core while the data is hot in
+        its cache, and the combiner lock changes hands once per batch instead of once per operation.
+        This pays off for tiny, heavily contended critical sections like shared counters and
+        histograms.
+
+        Operations are callables taking a T&. They must not throw, and must not call execute() on
+        the same FlatCombiner. Operations are never copied or allocated: the record points at the
+        caller's callable, which lives until execute() returns.
+
+        \note If more than NumSlots threads execute at once, the extra threads fall back to taking
+        the combiner lock themselves.
+
+        \code
+        FlatCombiner<std::vector<size_t>> histogram(std::vector<size_t>(numBuckets));
+
+        void record(size_t bucket)
+        {
+            histogram.execute([bucket](std::vector<size_t>& buckets) { ++buckets[bucket]; });
+        }
+        \endcode
+    */
+    template <typename T, size_t NumSlots = DEFAULT_COMBINER_SLOTS>
+    class FlatCombiner
+    {
+    public:
+        FlatCombiner();
+        explicit FlatCombiner(const T& initial);
+        ~FlatCombiner();
+
+        /*! \brief Runs operation(data) under mutual exclusion with every other operation, possibly
+            on another thread. Returns once the operation has run.
+        */
+        template <typename Operation>
+        void execute(Operation&& operation);
+
+        /*! \brief Direct access to the protected data. Only safe while no execute() is in flight.
+        */
+        T& unsafeData();
+
+    private:
+        struct DX_CACHE_ALIGNED Record
+        {
+            // Id of the thread currently using the record, 0 if free
+            std::atomic<size_t> owner;
+            // Set by the owner once published, cleared by the combiner once executed
+            std::atomic<bool>   pending;
+            void                (*invoke)(void* operation, T& data);
+            void*               operation;
+        };
+
+        template <typename Operation>
+        static void invokeOperation(void* operation, T& data);
+
+        Record* claimRecord();
+        bool    tryLockCombiner();
+        void    unlockCombiner();
+        void    combine();
+
+        DX_CACHE_ALIGNED std::atomic<bool> m_combinerLock;
+        Record              m_records[NumSlots];
+        DX_CACHE_ALIGNED T  m_data;
+
+        FlatCombiner(const FlatCombiner&);
+        FlatCombiner(FlatCombiner&&);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    template <typename T, size_t NumSlots>
+    FlatCombiner<T, NumSlots>::FlatCombiner() : m_combinerLock(false), m_data()
+    {
+        for(size_t i = 0; i < NumSlots; ++i)
+        {
+            m_records[i].owner = 0;
+            m_records[i].pending = false;
+            m_records[i].invoke = nullptr;
+            m_records[i].operation = nullptr;
+        }
+    }
+
+    template <typename T, size_t NumSlots>
+    FlatCombiner<T, NumSlots>::FlatCombiner(const T& initial) : m_combinerLock(false), m_data(initial)
+    {
+        for(size_t i = 0; i < NumSlots; ++i)
+        {
+            m_records[i].owner = 0;
+            m_records[i].pending = false;
+            m_records[i].invoke = nullptr;
+            m_records[i].operation = nullptr;
+        }
+    }
+
+    template <typename T, size_t NumSlots>
+    FlatCombiner<T, NumSlots>::~FlatCombiner()
+    {
+    }
+
+    template <typename T, size_t NumSlots>
+    T& FlatCombiner<T, NumSlots>::unsafeData()
+    {
+        return m_data;
+    }
+
+    template <typename T, size_t NumSlots>
+    template <typename Operation>
+    void FlatCombiner<T, NumSlots>::invokeOperation(void* operation, T& data)
+    {
+        (*static_cast<typename std::remove_reference<Operation>::type*>(operation))(data);
+    }
+
+    template <typename T, size_t NumSlots>
+    template <typename Operation>
+    void FlatCombiner<T, NumSlots>::execute(Operation&& operation)
+    {
+        Record* record = claimRecord();
+        if(record == nullptr)
+        {
+            // Every record is taken, just do it ourselves
+            while(!tryLockCombiner())
+            {
+                // Spin out
+            }
+            operation(m_data);
+            unlockCombiner();
+            return;
+        }
+
+        record->invoke = &invokeOperation<Operation>;
+        record->operation = const_cast<void*>(static_cast<const void*>(&operation));
+        record->pending.store(true, std::memory_order_release);
+
+        while(record->pending.load(std::memory_order_acquire))
+        {
+            if(tryLockCombiner())
+            {
+                // Our record was published before we got the lock, so this runs it
+                combine();
+                unlockCombiner();
+                assert(!record->pending.load(std::memory_order_relaxed));
+                break;
+            }
+            // Spin out until a combiner gets to us or the lock frees up
+        }
+
+        record->owner.store(0, std::memory_order_release);
+    }
+
+    template <typename T, size_t NumSlots>
+    typename FlatCombiner<T, NumSlots>::Record* FlatCombiner<T, NumSlots>::claimRecord()
+    {
+        // Threads start probing at their own slot, so it's usually free and already in our cache
+        const size_t self = currentThreadId();
+        for(size_t i = 0; i < NumSlots; ++i)
+        {
+            Record& record = m_records[(self + i) % NumSlots];
+            size_t unowned = 0;
+            if(record.owner.load(std::memory_order_relaxed) == 0
+                && record.owner.compare_exchange_strong(unowned, self, std::memory_order_acquire))
+            {
+                return &record;
+            }
+        }
+        return nullptr;
+    }
+
+    template <typename T, size_t NumSlots>
+    bool FlatCombiner<T, NumSlots>::tryLockCombiner()
+    {
+        return !m_combinerLock.load(std::memory_order_relaxed) && !m_combinerLock.exchange(true, std::memory_order_acquire);
+    }
+
+    template <typename T, size_t NumSlots>
+    void FlatCombiner<T, NumSlots>::unlockCombiner()
+    {
+        m_combinerLock.store(false, std::memory_order_release);
+    }
+
+    template <typename T, size_t NumSlots>
+    void FlatCombiner<T, NumSlots>::combine()
+    {
+        for(size_t pass = 0; pass < DEFAULT_COMBINER_PASSES; ++pass)
+        {
+            size_t executed = 0;
+            for(size_t i = 0; i < NumSlots; ++i)
+            {
+                Record& record = m_records[i];
+                if(!record.pending.load(std::memory_order_acquire))
+                    continue;
+                record.invoke(record.operation, m_data);
+                record.pending.store(false, std::memory_order_release);
+                ++executed;
+            }
+            if(executed == 0)
+                break;
+        }
+    }
+
+}
\ No newline at end of file
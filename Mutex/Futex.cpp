@@ -0,0 +1,111 @@
+
+#include "Futex.h"
+
+#if defined(__linux__)
+    #include <cerrno>
+    #include <climits>
+    #include <ctime>
+    #include <linux/futex.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#elif defined(_WIN32)
+    #include <Windows.h>
+    #pragma comment(lib, "Synchronization.lib")
+#else
+    #include <thread>
+#endif
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex words must be plain 32 bit integers");
+
+#if defined(__linux__)
+
+    static long futexCall(const std::atomic<uint32_t>& word, int op, uint32_t value, const timespec* timeout)
+    {
+        return syscall(SYS_futex, reinterpret_cast<const uint32_t*>(&word), op, value, timeout, nullptr, 0);
+    }
+
+    void futexWait(const std::atomic<uint32_t>& word, uint32_t expected)
+    {
+        futexCall(word, FUTEX_WAIT_PRIVATE, expected, nullptr);
+    }
+
+    bool futexWaitFor(const std::atomic<uint32_t>& word, uint32_t expected, std::chrono::nanoseconds timeout)
+    {
+        if(timeout.count() <= 0)
+            return word.load(std::memory_order_acquire) != expected;
+
+        timespec relative;
+        relative.tv_sec = static_cast<time_t>(timeout.count() / 1000000000);
+        relative.tv_nsec = static_cast<long>(timeout.count() % 1000000000);
+        return futexCall(word, FUTEX_WAIT_PRIVATE, expected, &relative) == 0 || errno != ETIMEDOUT;
+    }
+
+    void futexWakeOne(const std::atomic<uint32_t>& word)
+    {
+        futexCall(word, FUTEX_WAKE_PRIVATE, 1, nullptr);
+    }
+
+    void futexWakeAll(const std::atomic<uint32_t>& word)
+    {
+        futexCall(word, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr);
+    }
+
+#elif defined(_WIN32)
+
+    void futexWait(const std::atomic<uint32_t>& word, uint32_t expected)
+    {
+        WaitOnAddress(const_cast<std::atomic<uint32_t>*>(&word), &expected, sizeof(expected), INFINITE);
+    }
+
+    bool futexWaitFor(const std::atomic<uint32_t>& word, uint32_t expected, std::chrono::nanoseconds timeout)
+    {
+        const DWORD milliseconds = timeout.count() <= 0 ? 0 : static_cast<DWORD>((timeout.count() + 999999) / 1000000);
+        return WaitOnAddress(const_cast<std::atomic<uint32_t>*>(&word), &expected, sizeof(expected), milliseconds)
+            || GetLastError() != ERROR_TIMEOUT;
+    }
+
+    void futexWakeOne(const std::atomic<uint32_t>& word)
+    {
+        WakeByAddressSingle(const_cast<std::atomic<uint32_t>*>(&word));
+    }
+
+    void futexWakeAll(const std::atomic<uint32_t>& word)
+    {
+        WakeByAddressAll(const_cast<std::atomic<uint32_t>*>(&word));
+    }
+
+#else
+
+    // No address-based waiting available, sleep a little and let the caller re-check
+    void futexWait(const std::atomic<uint32_t>& word, uint32_t expected)
+    {
+        if(word.load(std::memory_order_acquire) == expected)
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+
+    bool futexWaitFor(const std::atomic<uint32_t>& word, uint32_t expected, std::chrono::nanoseconds timeout)
+    {
+        const std::chrono::nanoseconds slice = std::chrono::microseconds(50);
+        if(word.load(std::memory_order_acquire) != expected)
+            return true;
+        std::this_thread::sleep_for(timeout < slice ? timeout : slice);
+        return timeout > slice || word.load(std::memory_order_acquire) != expected;
+    }
+
+    void futexWakeOne(const std::atomic<uint32_t>&)
+    {
+    }
+
+    void futexWakeAll(const std::atomic<uint32_t>&)
+    {
+    }
+
+#endif
+
+}
\ No newline at end of file
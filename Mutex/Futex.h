@@ -0,0 +1,121 @@
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    // How many times blocking primitives re-check their condition before parking the thread
+    #ifndef DEFAULT_PARK_SPINS
+        #define DEFAULT_PARK_SPINS 128
+    #endif
+
+    /*! \brief Blocks the calling thread as long as word holds expected, or until woken by
+        futexWakeOne() / futexWakeAll() on the same word. Uses futex on Linux and WaitOnAddress on
+        Windows, other platforms fall back to a short sleep.
+
+        \note Wake-ups can be spurious, callers are expected to re-check their condition in a loop.
+    */
+    void futexWait(const std::atomic<uint32_t>& word, uint32_t expected);
+
+    /*! \brief Same as futexWait(), but gives up after timeout. Returns false if the timeout expired.
+    */
+    bool futexWaitFor(const std::atomic<uint32_t>& word, uint32_t expected, std::chrono::nanoseconds timeout);
+
+    /*! \brief Wakes at most one thread blocked in futexWait() on word
+    */
+    void futexWakeOne(const std::atomic<uint32_t>& word);
+
+    /*! \brief Wakes every thread blocked in futexWait() on word
+    */
+    void futexWakeAll(const std::atomic<uint32_t>& word);
+
+    /*! \brief The waiting side of the primitives built on futexes. Calls ready() up to spinCount
+        times, then parks on word for as long as it holds blocked, until ready() returns true.
+
+        ready() is the primitive's own check, it may consume what it finds (a permit, a signal).
+        Before parking, the thread counts itself in sleepers and then re-reads word: either the
+        waker's store is visible and we don't park, or our count is visible to the waker and it
+        makes the system call. The kernel compares word once more under its own lock, so nothing is
+        lost between the re-check and the sleep.
+    */
+    template <typename Ready>
+    void futexPark(const std::atomic<uint32_t>& word, uint32_t blocked, std::atomic<uint32_t>& sleepers, size_t spinCount, Ready ready);
+
+    /*! \brief Same as futexPark(), but gives up after timeout. Returns false if the timeout expired.
+    */
+    template <typename Ready>
+    bool futexParkFor(const std::atomic<uint32_t>& word, uint32_t blocked, std::atomic<uint32_t>& sleepers, size_t spinCount,
+        std::chrono::nanoseconds timeout, Ready ready);
+
+    /*! \brief The waking side of futexPark(). Call after changing word, it only pays for the system
+        call if sleepers says someone is (about to be) parked.
+    */
+    void futexWakeOneSleeper(const std::atomic<uint32_t>& word, const std::atomic<uint32_t>& sleepers);
+    void futexWakeAllSleepers(const std::atomic<uint32_t>& word, const std::atomic<uint32_t>& sleepers);
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    template <typename Ready>
+    void futexPark(const std::atomic<uint32_t>& word, uint32_t blocked, std::atomic<uint32_t>& sleepers, size_t spinCount, Ready ready)
+    {
+        for(size_t i = 0; i < spinCount; ++i)
+        {
+            if(ready())
+                return;
+        }
+
+        while(!ready())
+        {
+            sleepers.fetch_add(1);
+            if(word.load() == blocked)
+                futexWait(word, blocked);
+            sleepers.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    template <typename Ready>
+    bool futexParkFor(const std::atomic<uint32_t>& word, uint32_t blocked, std::atomic<uint32_t>& sleepers, size_t spinCount,
+        std::chrono::nanoseconds timeout, Ready ready)
+    {
+        for(size_t i = 0; i < spinCount; ++i)
+        {
+            if(ready())
+                return true;
+        }
+
+        const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + timeout;
+        while(!ready())
+        {
+            const std::chrono::nanoseconds remaining = deadline - std::chrono::steady_clock::now();
+            if(remaining.count() <= 0)
+                return false;
+            sleepers.fetch_add(1);
+            if(word.load() == blocked)
+                futexWaitFor(word, blocked, remaining);
+            sleepers.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    inline void futexWakeOneSleeper(const std::atomic<uint32_t>& word, const std::atomic<uint32_t>& sleepers)
+    {
+        if(sleepers.load() != 0)
+            futexWakeOne(word);
+    }
+
+    inline void futexWakeAllSleepers(const std::atomic<uint32_t>& word, const std::atomic<uint32_t>& sleepers)
+    {
+        if(sleepers.load() != 0)
+            futexWakeAll(word);
+    }
+
+}
\ No newline at end of file
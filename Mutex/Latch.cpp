@@ -0,0 +1,55 @@
+
+#include "Latch.h"
+
+#include <cassert>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    Latch::Latch(size_t count, size_t spinCount)
+        : m_spinCount(spinCount), m_count(count), m_released(count == 0 ? 1 : 0), m_sleepers(0)
+    {
+    }
+
+    Latch::~Latch()
+    {
+    }
+
+    void Latch::countDown(size_t n) const
+    {
+        if(n == 0)
+            return;
+        const size_t previous = m_count.fetch_sub(n, std::memory_order_acq_rel);
+        assert(previous >= n); // Counted down too many times
+        if(previous == n)
+        {
+            m_released.store(1);
+            futexWakeAllSleepers(m_released, m_sleepers);
+        }
+    }
+
+    bool Latch::tryWait() const
+    {
+        return m_released.load(std::memory_order_acquire) != 0;
+    }
+
+    void Latch::wait() const
+    {
+        futexPark(m_released, 0, m_sleepers, m_spinCount, [this]() { return tryWait(); });
+    }
+
+    bool Latch::waitFor(std::chrono::nanoseconds timeout) const
+    {
+        return futexParkFor(m_released, 0, m_sleepers, m_spinCount, timeout, [this]() { return tryWait(); });
+    }
+
+    void Latch::arriveAndWait(size_t n) const
+    {
+        countDown(n);
+        wait();
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+
+#pragma once
+
+#include "../CacheLine.h"
+#include "Futex.h"
+
+#include <atomic>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief Latch is a one-shot barrier: a counter that threads count down and can wait on until
+        it hits zero. Once released it stays released. Waiting spins briefly, then parks the thread
+        in the kernel, so it behaves well when threads outnumber cores.
+
+        \code
+        Latch workersReady(numWorkers);
+
+        void worker()
+        {
+            initialize();
+            workersReady.arriveAndWait(); // Nobody starts until everyone is initialized
+            run();
+        }
+
+        void supervisor()
+        {
+            if(!workersReady.waitFor(std::chrono::seconds(10)))
+                reportSlowStartup();
+        }
+        \endcode
+    */
+    class DX_CACHE_ALIGNED Latch
+    {
+    public:
+        /*! \param[in] count The number of count downs needed to release the latch
+            \param[in] spinCount How many times to check for the release before parking
+        */
+        explicit Latch(size_t count, size_t spinCount = DEFAULT_PARK_SPINS);
+        ~Latch();
+
+        /*! \brief Decrements the counter by n without waiting, releasing all waiters if it hits 0
+        */
+        void countDown(size_t n = 1) const;
+        /*! \brief Returns true if the latch has been released. Never blocks.
+        */
+        bool tryWait() const;
+        /*! \brief Blocks until the latch has been released
+        */
+        void wait() const;
+        /*! \brief Blocks until the latch has been released or timeout has passed. Returns false on
+            timeout.
+        */
+        bool waitFor(std::chrono::nanoseconds timeout) const;
+        /*! \brief Counts down by n, then waits for the latch to be released
+        */
+        void arriveAndWait(size_t n = 1) const;
+
+    private:
+        const size_t m_spinCount;
+        mutable std::atomic<size_t> m_count;
+        // Futex word, 1 once released. m_sleepers counts (about to be) parked threads
+        mutable std::atomic<uint32_t> m_released;
+        mutable std::atomic<uint32_t> m_sleepers;
+
+        Latch(const Latch&);
+        Latch(Latch&&);
+    };
+
+}
\ No newline at end of file
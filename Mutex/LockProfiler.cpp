@@ -0,0 +1,340 @@
+
+#include "LockProfiler.h"
+#include "StdLocks.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <ostream>
+#include <vector>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    // Copy of one lock's statistics, so dumping doesn't format while holding the registry
+    struct LockProfiler::Snapshot
+    {
+        std::string name;
+        const char* kind;
+        uint64_t    acquisitions;
+        uint64_t    contended;
+        uint64_t    spins;
+        uint64_t    waitNanoseconds;
+        uint64_t    holdNanoseconds;
+        uint64_t    waitHistogram[LOCK_PROFILE_BUCKETS];
+        uint64_t    holdHistogram[LOCK_PROFILE_BUCKETS];
+    };
+
+    namespace
+    {
+        struct Registry
+        {
+            Registry() : head(nullptr) {}
+
+            std::mutex  mutex;
+            LockStats*  head;
+        };
+
+        Registry& registry()
+        {
+            static Registry s_registry;
+            return s_registry;
+        }
+
+        std::string defaultName(const char* kind, const void* lock)
+        {
+            char unnamed[64];
+            std::snprintf(unnamed, sizeof(unnamed), "%s@%p", kind, lock);
+            return unnamed;
+        }
+
+        // Upper bound of the bucket holding the given fraction of samples
+        uint64_t percentile(const uint64_t (&histogram)[LOCK_PROFILE_BUCKETS], double fraction)
+        {
+            uint64_t total = 0;
+            for(size_t i = 0; i < LOCK_PROFILE_BUCKETS; ++i)
+                total += histogram[i];
+            if(total == 0)
+                return 0;
+
+            const uint64_t target = static_cast<uint64_t>(fraction * static_cast<double>(total - 1)) + 1;
+            uint64_t seen = 0;
+            for(size_t i = 0; i < LOCK_PROFILE_BUCKETS; ++i)
+            {
+                seen += histogram[i];
+                if(seen >= target)
+                    return i == 0 ? 0 : (uint64_t(1) << i) - 1;
+            }
+            return uint64_t(1) << (LOCK_PROFILE_BUCKETS - 1);
+        }
+
+        void writeJsonString(std::ostream& out, const std::string& value)
+        {
+            out << '"';
+            for(size_t i = 0; i < value.size(); ++i)
+            {
+                const char c = value[i];
+                if(c == '"' || c == '\\')
+                {
+                    out << '\\' << c;
+                }
+                else if(static_cast<unsigned char>(c) < 0x20)
+                {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+                    out << escaped;
+                }
+                else
+                {
+                    out << c;
+                }
+            }
+            out << '"';
+        }
+
+        void writeJsonHistogram(std::ostream& out, const uint64_t (&histogram)[LOCK_PROFILE_BUCKETS])
+        {
+            out << '[';
+            for(size_t i = 0; i < LOCK_PROFILE_BUCKETS; ++i)
+                out << (i == 0 ? "" : ",") << histogram[i];
+            out << ']';
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    LockStats::LockStats(const char* kind, const void* lock)
+        : m_lock(lock), m_kind(kind), m_holdStart(0), m_next(nullptr), m_prev(nullptr)
+    {
+        reset();
+        LockProfiler::add(this);
+    }
+
+    LockStats::~LockStats()
+    {
+        LockProfiler::remove(this);
+    }
+
+    void LockStats::setKind(const char* kind)
+    {
+        StdLock _lock(registry().mutex);
+        m_kind = kind;
+    }
+
+    void LockStats::setName(const char* name)
+    {
+        StdLock _lock(registry().mutex);
+        m_name = name ? name : "";
+    }
+
+    std::string LockStats::name() const
+    {
+        StdLock _lock(registry().mutex);
+        return m_name.empty() ? defaultName(m_kind, m_lock) : m_name;
+    }
+
+    const char* LockStats::kind() const
+    {
+        return m_kind;
+    }
+
+    uint64_t LockStats::now()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    size_t LockStats::bucketOf(uint64_t nanoseconds)
+    {
+        size_t bucket = 0;
+        while(nanoseconds != 0 && bucket < LOCK_PROFILE_BUCKETS - 1)
+        {
+            nanoseconds >>= 1;
+            ++bucket;
+        }
+        return bucket;
+    }
+
+    void LockStats::acquired(uint64_t waitStart, size_t spins, bool exclusive)
+    {
+        const uint64_t acquiredAt = now();
+        const uint64_t waited = acquiredAt - waitStart;
+
+        m_acquisitions.fetch_add(1, std::memory_order_relaxed);
+        if(spins != 0)
+        {
+            m_contended.fetch_add(1, std::memory_order_relaxed);
+            m_spins.fetch_add(spins, std::memory_order_relaxed);
+        }
+        m_waitNanoseconds.fetch_add(waited, std::memory_order_relaxed);
+        m_waitHistogram[bucketOf(waited)].fetch_add(1, std::memory_order_relaxed);
+
+        if(exclusive)
+            m_holdStart = acquiredAt;
+    }
+
+    void LockStats::upgraded(uint64_t waitStart, size_t spins)
+    {
+        const uint64_t upgradedAt = now();
+        m_spins.fetch_add(spins, std::memory_order_relaxed);
+        m_waitNanoseconds.fetch_add(upgradedAt - waitStart, std::memory_order_relaxed);
+        m_holdStart = upgradedAt;
+    }
+
+    void LockStats::released()
+    {
+        const uint64_t held = now() - m_holdStart;
+        m_holdNanoseconds.fetch_add(held, std::memory_order_relaxed);
+        m_holdHistogram[bucketOf(held)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void LockStats::reset()
+    {
+        m_acquisitions = 0;
+        m_contended = 0;
+        m_spins = 0;
+        m_waitNanoseconds = 0;
+        m_holdNanoseconds = 0;
+        for(size_t i = 0; i < LOCK_PROFILE_BUCKETS; ++i)
+        {
+            m_waitHistogram[i] = 0;
+            m_holdHistogram[i] = 0;
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    void LockProfiler::takeSnapshots(std::vector<Snapshot>& snapshots)
+    {
+        {
+            StdLock _lock(registry().mutex);
+            for(LockStats* stats = registry().head; stats != nullptr; stats = stats->m_next)
+            {
+                Snapshot snapshot;
+                snapshot.name = stats->m_name.empty() ? defaultName(stats->m_kind, stats->m_lock) : stats->m_name;
+                snapshot.kind = stats->m_kind;
+                snapshot.acquisitions = stats->m_acquisitions.load(std::memory_order_relaxed);
+                snapshot.contended = stats->m_contended.load(std::memory_order_relaxed);
+                snapshot.spins = stats->m_spins.load(std::memory_order_relaxed);
+                snapshot.waitNanoseconds = stats->m_waitNanoseconds.load(std::memory_order_relaxed);
+                snapshot.holdNanoseconds = stats->m_holdNanoseconds.load(std::memory_order_relaxed);
+                for(size_t i = 0; i < LOCK_PROFILE_BUCKETS; ++i)
+                {
+                    snapshot.waitHistogram[i] = stats->m_waitHistogram[i].load(std::memory_order_relaxed);
+                    snapshot.holdHistogram[i] = stats->m_holdHistogram[i].load(std::memory_order_relaxed);
+                }
+                snapshots.push_back(snapshot);
+            }
+        }
+        // Hottest locks first
+        std::sort(snapshots.begin(), snapshots.end(), [](const Snapshot& lhs, const Snapshot& rhs)
+        {
+            return lhs.waitNanoseconds > rhs.waitNanoseconds;
+        });
+    }
+
+    void LockProfiler::dumpText(std::ostream& out)
+    {
+        std::vector<Snapshot> snapshots;
+        takeSnapshots(snapshots);
+
+        out << std::left << std::setw(40) << "lock" << std::setw(16) << "kind" << std::right
+            << std::setw(14) << "acquisitions" << std::setw(12) << "contended" << std::setw(8) << "cont%"
+            << std::setw(14) << "spins" << std::setw(12) << "avgWaitNs" << std::setw(12) << "p99WaitNs"
+            << std::setw(12) << "avgHoldNs" << std::setw(12) << "p99HoldNs" << '\n';
+
+        for(size_t i = 0; i < snapshots.size(); ++i)
+        {
+            const Snapshot& s = snapshots[i];
+            const uint64_t acquisitions = s.acquisitions == 0 ? 1 : s.acquisitions;
+            uint64_t holds = 0;
+            for(size_t b = 0; b < LOCK_PROFILE_BUCKETS; ++b)
+                holds += s.holdHistogram[b];
+
+            out << std::left << std::setw(40) << s.name << std::setw(16) << s.kind << std::right
+                << std::setw(14) << s.acquisitions << std::setw(12) << s.contended
+                << std::setw(8) << std::fixed << std::setprecision(1) << (100.0 * s.contended / acquisitions)
+                << std::setw(14) << s.spins
+                << std::setw(12) << s.waitNanoseconds / acquisitions
+                << std::setw(12) << percentile(s.waitHistogram, 0.99)
+                << std::setw(12) << s.holdNanoseconds / (holds == 0 ? 1 : holds)
+                << std::setw(12) << percentile(s.holdHistogram, 0.99) << '\n';
+        }
+    }
+
+    void LockProfiler::dumpJson(std::ostream& out)
+    {
+        std::vector<Snapshot> snapshots;
+        takeSnapshots(snapshots);
+
+        // Bucket i holds durations up to 2^i - 1 nanoseconds, the last one is unbounded
+        out << "{\"bucketUpperBoundsNs\":[";
+        for(size_t i = 0; i + 1 < LOCK_PROFILE_BUCKETS; ++i)
+            out << (i == 0 ? "" : ",") << ((uint64_t(1) << i) - 1);
+        out << "],\"locks\":[";
+        for(size_t i = 0; i < snapshots.size(); ++i)
+        {
+            const Snapshot& s = snapshots[i];
+            out << (i == 0 ? "" : ",") << "{\"name\":";
+            writeJsonString(out, s.name);
+            out << ",\"kind\":\"" << s.kind << '"'
+                << ",\"acquisitions\":" << s.acquisitions
+                << ",\"contended\":" << s.contended
+                << ",\"spins\":" << s.spins
+                << ",\"waitNanoseconds\":" << s.waitNanoseconds
+                << ",\"holdNanoseconds\":" << s.holdNanoseconds
+                << ",\"waitHistogram\":";
+            writeJsonHistogram(out, s.waitHistogram);
+            out << ",\"holdHistogram\":";
+            writeJsonHistogram(out, s.holdHistogram);
+            out << '}';
+        }
+        out << "]}\n";
+    }
+
+    void LockProfiler::reset()
+    {
+        StdLock _lock(registry().mutex);
+        for(LockStats* stats = registry().head; stats != nullptr; stats = stats->m_next)
+            stats->reset();
+    }
+
+    size_t LockProfiler::numLocks()
+    {
+        StdLock _lock(registry().mutex);
+        size_t count = 0;
+        for(LockStats* stats = registry().head; stats != nullptr; stats = stats->m_next)
+            ++count;
+        return count;
+    }
+
+    void LockProfiler::add(LockStats* stats)
+    {
+        StdLock _lock(registry().mutex);
+        stats->m_prev = nullptr;
+        stats->m_next = registry().head;
+        if(registry().head != nullptr)
+            registry().head->m_prev = stats;
+        registry().head = stats;
+    }
+
+    void LockProfiler::remove(LockStats* stats)
+    {
+        StdLock _lock(registry().mutex);
+        if(stats->m_prev != nullptr)
+            stats->m_prev->m_next = stats->m_next;
+        else
+            registry().head = stats->m_next;
+        if(stats->m_next != nullptr)
+            stats->m_next->m_prev = stats->m_prev;
+    }
+
+}
\ No newline at end of file
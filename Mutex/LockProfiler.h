@@ -0,0 +1,125 @@
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/*
+    Define DX_LOCK_PROFILING (for the library and everything including it, since it changes the
+    layout of the locks) to have SpinMutex, SpinYieldMutex and SpinRWMutex record contention
+    statistics into the LockProfiler registry. Without it the locks carry no statistics at all and
+    LockProfiler dumps an empty registry.
+*/
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    // Histogram bucket i counts durations in [2^(i-1), 2^i) nanoseconds, the last one everything above
+    #ifndef LOCK_PROFILE_BUCKETS
+        #define LOCK_PROFILE_BUCKETS 36
+    #endif
+
+    /*! \brief LockStats holds the contention statistics of a single lock. Locks own one of these
+        when DX_LOCK_PROFILING is defined; it registers itself with LockProfiler for its lifetime.
+
+        All counters are updated with relaxed atomics, so a dump taken while the lock is in use is
+        approximate but never torn per counter.
+    */
+    class LockStats
+    {
+    public:
+        /*! \param[in] kind Type of the owning lock, e.g. "SpinMutex"
+            \param[in] lock Address of the owning lock, used for the default name
+        */
+        LockStats(const char* kind, const void* lock);
+        ~LockStats();
+
+        void        setKind(const char* kind);
+        void        setName(const char* name);
+        std::string name() const;
+        const char* kind() const;
+
+        /*! \brief Records an acquisition that started waiting at waitStart (see now()) and spun
+            spins times. Zero spins counts as uncontended. Starts the hold timer if exclusive.
+        */
+        void acquired(uint64_t waitStart, size_t spins, bool exclusive = true);
+        /*! \brief Records a holder upgrading to exclusive: the wait and spins count towards the
+            totals, but not as another acquisition. Starts the hold timer.
+        */
+        void upgraded(uint64_t waitStart, size_t spins);
+        /*! \brief Stops the hold timer started by an exclusive acquired()
+        */
+        void released();
+        void reset();
+
+        /*! \brief Monotonic timestamp in nanoseconds
+        */
+        static uint64_t now();
+
+    private:
+        friend class LockProfiler;
+
+        static size_t bucketOf(uint64_t nanoseconds);
+
+        const void*             m_lock;
+        const char*             m_kind;
+        std::string             m_name;
+        std::atomic<uint64_t>   m_acquisitions;
+        std::atomic<uint64_t>   m_contended;
+        std::atomic<uint64_t>   m_spins;
+        std::atomic<uint64_t>   m_waitNanoseconds;
+        std::atomic<uint64_t>   m_holdNanoseconds;
+        std::atomic<uint64_t>   m_waitHistogram[LOCK_PROFILE_BUCKETS];
+        std::atomic<uint64_t>   m_holdHistogram[LOCK_PROFILE_BUCKETS];
+        // Only written by the exclusive owner
+        uint64_t                m_holdStart;
+        // Intrusive registry list, guarded by the registry mutex
+        LockStats*              m_next;
+        LockStats*              m_prev;
+
+        LockStats(const LockStats&);
+        LockStats(LockStats&&);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief LockProfiler is the global registry of every live, profiled lock. It can be dumped at
+        any time from any thread, as a human readable table (hottest locks first, by total time spent
+        waiting) or as JSON for tooling.
+
+        \code
+        SpinMutex sessionsMutex;
+        sessionsMutex.setProfileName("sessions");
+        ...
+        LockProfiler::dumpText(std::cerr);
+        \endcode
+    */
+    class LockProfiler
+    {
+    public:
+        static void dumpText(std::ostream& out);
+        static void dumpJson(std::ostream& out);
+        /*! \brief Zeroes the statistics of every registered lock
+        */
+        static void reset();
+        static size_t numLocks();
+
+    private:
+        friend class LockStats;
+
+        struct Snapshot;
+
+        static void takeSnapshots(std::vector<Snapshot>& out);
+        static void add(LockStats* stats);
+        static void remove(LockStats* stats);
+
+        LockProfiler();
+    };
+
+}
\ No newline at end of file
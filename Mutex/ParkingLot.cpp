@@ -0,0 +1,168 @@
+
+#include "ParkingLot.h"
+#include "../CacheLine.h"
+#include "Futex.h"
+#include "SpinMutex.h"
+
+#include <cstdint>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    static_assert((DEFAULT_PARKING_BUCKETS & (DEFAULT_PARKING_BUCKETS - 1)) == 0, "DEFAULT_PARKING_BUCKETS must be a power of two");
+
+    namespace
+    {
+        // One per thread, queued in a bucket while the thread is parked
+        struct ParkedThread
+        {
+            ParkedThread() : parked(0), address(nullptr), next(nullptr) {}
+
+            // Futex word the thread sleeps on, 1 while parked
+            std::atomic<uint32_t>   parked;
+            const void*             address;
+            ParkedThread*           next;
+        };
+
+        struct DX_CACHE_ALIGNED Bucket
+        {
+            Bucket() : head(nullptr), tail(nullptr) {}
+
+            CompactSpinMutex    mutex;
+            ParkedThread*       head;
+            ParkedThread*       tail;
+        };
+
+        Bucket& bucketFor(const void* address)
+        {
+            static Bucket s_buckets[DEFAULT_PARKING_BUCKETS];
+
+            // Fibonacci hashing, neighbouring addresses of byte sized locks end up far apart
+            const uint64_t hash = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(address)) * 0x9E3779B97F4A7C15ULL;
+            return s_buckets[static_cast<size_t>(hash >> 32) & (DEFAULT_PARKING_BUCKETS - 1)];
+        }
+
+        ParkedThread& currentParkedThread()
+        {
+            static thread_local ParkedThread s_thread;
+            return s_thread;
+        }
+
+        // Unlinks the first thread parked on address, returns nullptr if there is none
+        ParkedThread* dequeue(Bucket& bucket, const void* address, bool& haveMoreThreads)
+        {
+            ParkedThread* previous = nullptr;
+            ParkedThread* thread = bucket.head;
+            while(thread != nullptr && thread->address != address)
+            {
+                previous = thread;
+                thread = thread->next;
+            }
+
+            haveMoreThreads = false;
+            if(thread == nullptr)
+                return nullptr;
+
+            if(previous == nullptr)
+                bucket.head = thread->next;
+            else
+                previous->next = thread->next;
+            if(bucket.tail == thread)
+                bucket.tail = previous;
+
+            for(ParkedThread* other = thread->next; other != nullptr; other = other->next)
+            {
+                if(other->address == address)
+                {
+                    haveMoreThreads = true;
+                    break;
+                }
+            }
+            thread->next = nullptr;
+            return thread;
+        }
+
+        void wake(ParkedThread* thread)
+        {
+            // The thread may return from park() and even exit as soon as the store lands. Waking a
+            // futex word that is gone is harmless, at worst someone reusing it wakes up spuriously.
+            thread->parked.store(0, std::memory_order_release);
+            futexWakeOne(thread->parked);
+        }
+    }
+
+    bool ParkingLot::parkImpl(const void* address, bool (*validate)(void*), void* context)
+    {
+        ParkedThread& self = currentParkedThread();
+        Bucket& bucket = bucketFor(address);
+
+        bucket.mutex.lock();
+        if(!validate(context))
+        {
+            bucket.mutex.unlock();
+            return false;
+        }
+        self.address = address;
+        self.next = nullptr;
+        self.parked.store(1, std::memory_order_relaxed);
+        if(bucket.tail == nullptr)
+            bucket.head = &self;
+        else
+            bucket.tail->next = &self;
+        bucket.tail = &self;
+        bucket.mutex.unlock();
+
+        while(self.parked.load(std::memory_order_acquire) != 0)
+            futexWait(self.parked, 1);
+        return true;
+    }
+
+    bool ParkingLot::unparkOneImpl(const void* address, void (*callback)(void*, bool), void* context)
+    {
+        Bucket& bucket = bucketFor(address);
+
+        bucket.mutex.lock();
+        bool haveMoreThreads = false;
+        ParkedThread* thread = dequeue(bucket, address, haveMoreThreads);
+        callback(context, haveMoreThreads);
+        bucket.mutex.unlock();
+
+        if(thread == nullptr)
+            return false;
+        wake(thread);
+        return true;
+    }
+
+    size_t ParkingLot::unparkAll(const void* address)
+    {
+        Bucket& bucket = bucketFor(address);
+
+        // Collect them first so nobody is woken while we still hold the bucket
+        ParkedThread* unparked = nullptr;
+        size_t count = 0;
+        bucket.mutex.lock();
+        bool haveMoreThreads = true;
+        while(haveMoreThreads)
+        {
+            ParkedThread* thread = dequeue(bucket, address, haveMoreThreads);
+            if(thread == nullptr)
+                break;
+            thread->next = unparked;
+            unparked = thread;
+            ++count;
+        }
+        bucket.mutex.unlock();
+
+        while(unparked != nullptr)
+        {
+            ParkedThread* thread = unparked;
+            unparked = thread->next;
+            wake(thread);
+        }
+        return count;
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,90 @@
+
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    // Number of buckets in the global parking table, a power of two. Every bucket is a cache line.
+    #ifndef DEFAULT_PARKING_BUCKETS
+        #define DEFAULT_PARKING_BUCKETS 512
+    #endif
+
+    /*! \brief ParkingLot keeps the wait queues for every address in the process in one global table,
+        hashed by address. A synchronization primitive built on it only has to store a couple of
+        bits of state - whether it is held and whether anyone is parked on it - while all the
+        bookkeeping for blocked threads lives here, and only while threads are actually blocked.
+
+        park() queues the calling thread on an address and puts it to sleep, unparkOne() and
+        unparkAll() wake threads queued on an address. Both take a callback that runs under the
+        lock of the address's bucket, which is what makes "check the state, then sleep" and "update
+        the state, then wake" atomic with respect to each other. See ParkingMutex for an example.
+
+        \note Callbacks run with a bucket lock held: keep them short and never park or unpark from
+        inside them.
+    */
+    class ParkingLot
+    {
+    public:
+        /*! \brief Parks the calling thread on address if validate() returns true. Returns false
+            without blocking if it didn't, and true once another thread unparked it.
+        */
+        template <typename Validate>
+        static bool park(const void* address, Validate&& validate);
+
+        /*! \brief Unparks the longest parked thread on address, if any. callback(haveMoreThreads)
+            runs before the thread is woken either way, haveMoreThreads tells whether other threads
+            are still parked on address. Returns true if a thread was unparked.
+        */
+        template <typename Callback>
+        static bool unparkOne(const void* address, Callback&& callback);
+
+        /*! \brief Unparks every thread parked on address and returns how many there were
+        */
+        static size_t unparkAll(const void* address);
+
+    private:
+        template <typename Function>
+        static bool invokeValidate(void* function);
+        template <typename Function>
+        static void invokeCallback(void* function, bool haveMoreThreads);
+
+        static bool parkImpl(const void* address, bool (*validate)(void*), void* context);
+        static bool unparkOneImpl(const void* address, void (*callback)(void*, bool), void* context);
+
+        ParkingLot();
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    template <typename Function>
+    bool ParkingLot::invokeValidate(void* function)
+    {
+        return (*static_cast<typename std::remove_reference<Function>::type*>(function))();
+    }
+
+    template <typename Function>
+    void ParkingLot::invokeCallback(void* function, bool haveMoreThreads)
+    {
+        (*static_cast<typename std::remove_reference<Function>::type*>(function))(haveMoreThreads);
+    }
+
+    template <typename Validate>
+    bool ParkingLot::park(const void* address, Validate&& validate)
+    {
+        return parkImpl(address, &invokeValidate<Validate>, const_cast<void*>(static_cast<const void*>(&validate)));
+    }
+
+    template <typename Callback>
+    bool ParkingLot::unparkOne(const void* address, Callback&& callback)
+    {
+        return unparkOneImpl(address, &invokeCallback<Callback>, const_cast<void*>(static_cast<const void*>(&callback)));
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+
+#include "ParkingMutex.h"
+#include "ParkingLot.h"
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    ParkingMutex::ParkingMutex() : m_state(0)
+    {
+    }
+
+    void ParkingMutex::lock() const
+    {
+        uint8_t expected = 0;
+        if(!m_state.compare_exchange_weak(expected, LOCKED, std::memory_order_acquire, std::memory_order_relaxed))
+            lockSlow();
+    }
+
+    bool ParkingMutex::tryLock() const
+    {
+        uint8_t state = m_state.load(std::memory_order_relaxed);
+        while(!(state & LOCKED))
+        {
+            if(m_state.compare_exchange_weak(state, state | LOCKED, std::memory_order_acquire, std::memory_order_relaxed))
+                return true;
+        }
+        return false;
+    }
+
+    void ParkingMutex::unlock() const
+    {
+        uint8_t expected = LOCKED;
+        if(!m_state.compare_exchange_strong(expected, 0, std::memory_order_release, std::memory_order_relaxed))
+            unlockSlow();
+    }
+
+    void ParkingMutex::lockSlow() const
+    {
+        size_t spins = 0;
+        for(;;)
+        {
+            uint8_t state = m_state.load(std::memory_order_relaxed);
+            if(!(state & LOCKED))
+            {
+                // Keep the parked bit, whoever is parked still needs waking
+                if(m_state.compare_exchange_weak(state, state | LOCKED, std::memory_order_acquire, std::memory_order_relaxed))
+                    return;
+                continue;
+            }
+
+            // Nobody is parked yet, so the owner may well be done soon
+            if(!(state & PARKED) && spins < DEFAULT_PARK_SPINS)
+            {
+                // Spin out
+                ++spins;
+                continue;
+            }
+
+            if(!(state & PARKED) && !m_state.compare_exchange_weak(state, state | PARKED, std::memory_order_relaxed))
+                continue;
+
+            // Only sleeps if the owner hasn't unlocked in the meantime, unlockSlow() clears the
+            // state under the same bucket lock
+            ParkingLot::park(this, [this]()
+            {
+                return m_state.load(std::memory_order_relaxed) == (LOCKED | PARKED);
+            });
+        }
+    }
+
+    void ParkingMutex::unlockSlow() const
+    {
+        ParkingLot::unparkOne(this, [this](bool haveMoreThreads)
+        {
+            m_state.store(haveMoreThreads ? PARKED : 0, std::memory_order_release);
+        });
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+
+#pragma once
+
+#include "Futex.h"
+
+#include <atomic>
+#include <cstdint>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief ParkingMutex is a one byte mutex that blocks instead of spinning forever. It spins
+        DEFAULT_PARK_SPINS times like a SpinMutex would, then parks the thread in the global
+        ParkingLot until the owner unlocks. The byte holds a locked bit and a parked bit, so an
+        uncontended lock() and unlock() are a single compare-exchange each and never go near the
+        ParkingLot.
+
+        Being a byte with no padding, it is meant to be embedded in every object or kept in large
+        arrays, see StripedLock. Locks that share a cache line still slow each other down when
+        they are contended at the same time.
+
+        \note ParkingMutex is not recursive, and it isn't fair: an unlock() wakes one parked thread,
+        but a running thread can take the mutex before it gets there. It works with std::lock_guard
+        and std::unique_lock.
+
+        \code
+        struct Account
+        {
+            ParkingMutex    mutex;
+            int64_t         balance;
+        };
+
+        void deposit(Account& account, int64_t amount)
+        {
+            std::lock_guard<ParkingMutex> lock(account.mutex);
+            account.balance += amount;
+        }
+        \endcode
+    */
+    class ParkingMutex
+    {
+    public:
+        ParkingMutex();
+
+        void lock() const;
+        bool tryLock() const;
+        void unlock() const;
+
+    private:
+        static const uint8_t LOCKED = 0x1;
+        static const uint8_t PARKED = 0x2;
+
+        void lockSlow() const;
+        void unlockSlow() const;
+
+        mutable std::atomic<uint8_t> m_state;
+
+        ParkingMutex(const ParkingMutex&);
+        ParkingMutex(ParkingMutex&&);
+    };
+
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+
+#include "Semaphore.h"
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    Semaphore::Semaphore(uint32_t count, size_t spinCount) : m_spinCount(spinCount), m_count(count), m_sleepers(0)
+    {
+    }
+
+    Semaphore::~Semaphore()
+    {
+    }
+
+    bool Semaphore::tryAcquire() const
+    {
+        uint32_t count = m_count.load(std::memory_order_relaxed);
+        while(count != 0)
+        {
+            if(m_count.compare_exchange_weak(count, count - 1, std::memory_order_acquire, std::memory_order_relaxed))
+                return true;
+        }
+        return false;
+    }
+
+    void Semaphore::acquire() const
+    {
+        // Parks while no permit is left
+        futexPark(m_count, 0, m_sleepers, m_spinCount, [this]() { return tryAcquire(); });
+    }
+
+    bool Semaphore::tryAcquireFor(std::chrono::nanoseconds timeout) const
+    {
+        return futexParkFor(m_count, 0, m_sleepers, m_spinCount, timeout, [this]() { return tryAcquire(); });
+    }
+
+    void Semaphore::release(uint32_t n) const
+    {
+        if(n == 0)
+            return;
+        m_count.fetch_add(n);
+        // A single permit can only satisfy one waiter
+        if(n == 1)
+            futexWakeOneSleeper(m_count, m_sleepers);
+        else
+            futexWakeAllSleepers(m_count, m_sleepers);
+    }
+
+    uint32_t Semaphore::available() const
+    {
+        return m_count.load(std::memory_order_relaxed);
+    }
+
+}
\ No newline at end of file
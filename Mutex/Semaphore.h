@@ -0,0 +1,66 @@
+
+#pragma once
+
+#include "../CacheLine.h"
+#include "Futex.h"
+
+#include <atomic>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief Semaphore is a counting semaphore: a number of permits threads acquire and release.
+        Taking an available permit is one compare-and-swap, only a thread finding none spins
+        briefly and then parks on a futex, and release() only makes a system call when somebody is
+        parked.
+
+        \code
+        Semaphore connections(maxConnections);
+
+        void handle(Request& request)
+        {
+            connections.acquire();
+            forward(request);
+            connections.release();
+        }
+        \endcode
+    */
+    class DX_CACHE_ALIGNED Semaphore
+    {
+    public:
+        /*! \param[in] count The number of permits available to begin with
+            \param[in] spinCount How many times to look for a permit before parking
+        */
+        explicit Semaphore(uint32_t count = 0, size_t spinCount = DEFAULT_PARK_SPINS);
+        ~Semaphore();
+
+        /*! \brief Takes a permit, blocking until one is available
+        */
+        void        acquire() const;
+        /*! \brief Takes a permit if one is available right now. Never blocks.
+        */
+        bool        tryAcquire() const;
+        /*! \brief Takes a permit, blocking at most timeout. Returns false on timeout.
+        */
+        bool        tryAcquireFor(std::chrono::nanoseconds timeout) const;
+        /*! \brief Adds n permits, waking up to n blocked threads
+        */
+        void        release(uint32_t n = 1) const;
+
+        /*! \brief Permits available right now, stale as soon as it returns
+        */
+        uint32_t    available() const;
+
+    private:
+        const size_t m_spinCount;
+        // Futex word, the number of available permits. m_sleepers counts (about to be) parked threads
+        mutable std::atomic<uint32_t> m_count;
+        mutable std::atomic<uint32_t> m_sleepers;
+
+        Semaphore(const Semaphore&);
+        Semaphore(Semaphore&&);
+    };
+
+}
\ No newline at end of file
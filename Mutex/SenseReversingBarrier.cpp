@@ -0,0 +1,42 @@
+
+#include "SenseReversingBarrier.h"
+
+#include <cassert>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    SenseReversingBarrier::SenseReversingBarrier(size_t numThreads, const std::function<void()>& completion)
+        : Barrier(numThreads), m_initial(numThreads), m_completion(completion), m_phase(0)
+    {
+        assert(numThreads > 0);
+    }
+
+    SenseReversingBarrier::~SenseReversingBarrier()
+    {
+    }
+
+    void SenseReversingBarrier::wait() const
+    {
+        // Our phase can't end before we've arrived, so reading it first is safe
+        const size_t phase = m_phase.load(std::memory_order_acquire);
+        if(m_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            // Last one in. Nobody can leave (and arrive again) before the phase flips, so reset first
+            m_count.store(m_initial, std::memory_order_relaxed);
+            if(m_completion)
+                m_completion();
+            m_phase.store(phase + 1, std::memory_order_release);
+            return;
+        }
+
+        while(m_phase.load(std::memory_order_acquire) == phase)
+        {
+            // Spin out
+        }
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+
+#pragma once
+
+#include "Barrier.h"
+
+#include <functional>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief SenseReversingBarrier is a reusable, lock-free centralized barrier. Every thread
+        decrements one shared counter; the last one to arrive resets the counter and flips a phase
+        word that everyone else is spinning on. Since a thread remembers which phase it arrived in,
+        there's no reset window like with CyclicSpinBarrier and the next phase can start straight away.
+
+        Best suited to small thread counts, where a single counter isn't a bottleneck yet. For many
+        threads see CombiningTreeBarrier.
+
+        An optional completion function is run exactly once per phase, by the last thread to arrive,
+        before any thread is released.
+
+        \code
+        SenseReversingBarrier barrier(numThreads, []{ swapBuffers(); });
+
+        void worker()
+        {
+            for(size_t step = 0; step < numSteps; ++step)
+            {
+                simulate(step);
+                barrier.wait(); // swapBuffers() has run once everyone gets past here
+            }
+        }
+        \endcode
+    */
+    class SenseReversingBarrier : public Barrier
+    {
+    public:
+        /*! \param[in] numThreads The number of threads that have to call wait() each phase
+            \param[in] completion Called once per phase by the last thread to arrive. May be empty.
+        */
+        explicit SenseReversingBarrier(size_t numThreads = 1, const std::function<void()>& completion = std::function<void()>());
+        ~SenseReversingBarrier();
+
+        void wait() const;
+
+    private:
+        const size_t m_initial;
+        const std::function<void()> m_completion;
+        // The phase word is what waiters spin on, keep it off of m_count's line
+        DX_CACHE_ALIGNED mutable std::atomic<size_t> m_phase;
+
+        SenseReversingBarrier(const SenseReversingBarrier&);
+        SenseReversingBarrier(SenseReversingBarrier&&);
+    };
+
+}
\ No newline at end of file
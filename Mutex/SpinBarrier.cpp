@@ -1,6 +1,8 @@
 
 #include "SpinBarrier.h"
 
+#include <cassert>
+
 namespace DX
 {
     ////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1,6 +1,8 @@
 
 #include "SpinMutex.h"
 
+#include <cassert>
+
 namespace DX
 {
     ////////////////////////////////////////////////////////////////////////////////////////////////
@@ -8,6 +10,9 @@ namespace DX
     // impl
 
     SpinMutex::SpinMutex() : m_lock(false)
+    #ifdef DX_LOCK_PROFILING
+        , m_stats("SpinMutex", this)
+    #endif
     {
     }
 
@@ -17,22 +22,82 @@ namespace DX
 
     void SpinMutex::lock() const
     {
+        #ifdef DX_LOCK_PROFILING
+            const uint64_t waitStart = LockStats::now();
+            size_t spins = 0;
+        #endif
         while(m_lock.exchange(true))
         {
             // Spin out
+            #ifdef DX_LOCK_PROFILING
+                ++spins;
+            #endif
         }
+        #ifdef DX_LOCK_PROFILING
+            m_stats.acquired(waitStart, spins);
+        #endif
     }
 
     bool SpinMutex::tryLock() const
     {
-        return !m_lock.exchange(true);
+        #ifdef DX_LOCK_PROFILING
+            const uint64_t waitStart = LockStats::now();
+            if(m_lock.exchange(true))
+                return false;
+            m_stats.acquired(waitStart, 0);
+            return true;
+        #else
+            return !m_lock.exchange(true);
+        #endif
     }
 
     void SpinMutex::unlock() const
     {
+        #ifdef DX_LOCK_PROFILING
+            m_stats.released();
+        #endif
         m_lock = false;
     }
 
+    void SpinMutex::setProfileName(const char* name)
+    {
+        #ifdef DX_LOCK_PROFILING
+            m_stats.setName(name);
+        #else
+            (void)name;
+        #endif
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    CompactSpinMutex::CompactSpinMutex() : m_lock(false)
+    {
+    }
+
+    void CompactSpinMutex::lock() const
+    {
+        // Test before test-and-set so waiters spin on their cached copy instead of stealing the line
+        while(m_lock.exchange(true, std::memory_order_acquire))
+        {
+            while(m_lock.load(std::memory_order_relaxed))
+            {
+                // Spin out
+            }
+        }
+    }
+
+    bool CompactSpinMutex::tryLock() const
+    {
+        return !m_lock.load(std::memory_order_relaxed) && !m_lock.exchange(true, std::memory_order_acquire);
+    }
+
+    void CompactSpinMutex::unlock() const
+    {
+        m_lock.store(false, std::memory_order_release);
+    }
+
     ////////////////////////////////////////////////////////////////////////////////////////////////
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // impl
@@ -3,6 +3,7 @@
 
 #include "../CacheLine.h"
 #include "Mutex.h"
+#include "LockProfiler.h"
 
 #include <atomic>
 
@@ -44,7 +45,7 @@ namespace DX
             Please note that the above example could also be accomplished by making the type of
             myProtectedValue std::atomic<int>, but the usage still stands.
     */
-    class SpinMutex : public Mutex
+    class DX_CACHE_ALIGNED SpinMutex : public Mutex
     {
     public:
         SpinMutex();
@@ -69,12 +70,16 @@ namespace DX
         */
         virtual void unlock() const; 
 
+        /*! \brief Names the mutex in LockProfiler dumps. Does nothing unless DX_LOCK_PROFILING is
+            defined.
+        */
+        void setProfileName(const char* name);
+
     protected:
-        // Initial padding so we aren't overlapping some other potentially contended cache
-        volatile char pad_0[CACHE_LINE_SIZE];
         mutable std::atomic<bool> m_lock;
-        // And then flesh out the rest of our pad
-        volatile char pad_1[CACHE_LINE_SIZE - (sizeof(std::atomic<bool>) % CACHE_LINE_SIZE)];
+    #ifdef DX_LOCK_PROFILING
+        mutable LockStats m_stats;
+    #endif
 
     private:
         SpinMutex(const SpinMutex&);
@@ -84,6 +89,36 @@ namespace DX
     ////////////////////////////////////////////////////////////////////////////////////////////////
     ////////////////////////////////////////////////////////////////////////////////////////////////
 
+    /*! \brief CompactSpinMutex is SpinMutex without the cache line to itself, the virtual functions
+        and the profiling: a single byte. It is meant to be embedded next to the data it protects,
+        or kept in large arrays (one per bucket, per row, ...) where a padded SpinMutex per element
+        would cost far more memory than the data.
+
+        Neighbouring CompactSpinMutexes share cache lines, so threads hammering different ones that
+        happen to be close together still slow each other down. Wrap it in CachePadded where that
+        matters more than the size.
+
+        \note CompactSpinMutex is not recursive. It works with std::lock_guard and std::unique_lock.
+    */
+    class CompactSpinMutex
+    {
+    public:
+        CompactSpinMutex();
+
+        void lock() const;
+        bool tryLock() const;
+        void unlock() const;
+
+    private:
+        mutable std::atomic<bool> m_lock;
+
+        CompactSpinMutex(const CompactSpinMutex&);
+        CompactSpinMutex(CompactSpinMutex&&);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
     /*! \brief SpinLock is a lock-guard style class that latches onto a mutex, locking it upon creation
         and unlocking it upon destruction.
 
@@ -1,13 +1,20 @@
 
 #include "SpinRWMutex.h"
 
+#include <cassert>
+
 namespace DX
 {
     ////////////////////////////////////////////////////////////////////////////////////////////////
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // impl
 
-    SpinRWMutex::SpinRWMutex() : m_readerLock(0)
+    SpinRWMutex::SpinRWMutex(Policy policy)
+        : m_policy(policy), m_state(0), m_readersIn(0), m_readersOut(0), m_writersIn(0),
+        m_writersOut(0), m_writePhase(0)
+    #ifdef DX_LOCK_PROFILING
+        , m_stats("SpinRWMutex", this)
+    #endif
     {
     }
 
@@ -15,47 +22,365 @@ namespace DX
     {
     }
 
-    void SpinRWMutex::lock(bool isWriter) const
+    SpinRWMutex::Policy SpinRWMutex::policy() const
     {
-        SpinLock _lock(m_lockMutex);
+        return m_policy;
+    }
 
+    void SpinRWMutex::setProfileName(const char* name)
+    {
+        #ifdef DX_LOCK_PROFILING
+            m_stats.setName(name);
+        #else
+            (void)name;
+        #endif
+    }
+
+    size_t SpinRWMutex::readerBlockMask() const
+    {
         // Once a writer attempts to access, no more readers will be able to read
+        return m_policy == PreferWriters ? (WRITER | WRITER_PENDING) : WRITER;
+    }
+
+    void SpinRWMutex::lock(bool isWriter) const
+    {
+        #ifdef DX_LOCK_PROFILING
+            const uint64_t waitStart = LockStats::now();
+            m_stats.acquired(waitStart, lockImpl(isWriter), isWriter);
+        #else
+            lockImpl(isWriter);
+        #endif
+    }
+
+    size_t SpinRWMutex::lockImpl(bool isWriter) const
+    {
+        size_t spins = 0;
+        if(m_policy == PhaseFair)
+        {
+            if(isWriter)
+            {
+                spins += pfLockWriterTicket(m_writersIn.fetch_add(1, std::memory_order_relaxed));
+                spins += pfBlockReaders(0);
+            }
+            else
+            {
+                const size_t writerBits = m_readersIn.fetch_add(PF_READER, std::memory_order_acquire) & PF_WRITER_BITS;
+                // A writer is present, wait for its phase to end
+                while(writerBits != 0 && writerBits == (m_readersIn.load(std::memory_order_acquire) & PF_WRITER_BITS))
+                {
+                    // Spin out
+                    ++spins;
+                }
+            }
+            return spins;
+        }
+
         if(isWriter)
         {
-            // TODO: SpinBarrierLock
-            m_writerMutex.lock();
-            while(m_readerLock > 0) 
+            for(;; ++spins)
             {
+                size_t state = m_state.load(std::memory_order_relaxed);
+                if((state & ~WRITER_PENDING) == 0)
+                {
+                    // Acquiring also clears the pending flag, other waiting writers set it again
+                    if(m_state.compare_exchange_weak(state, WRITER, std::memory_order_acquire))
+                        return spins;
+                }
+                else if(m_policy == PreferWriters && (state & WRITER_PENDING) == 0)
+                {
+                    m_state.fetch_or(WRITER_PENDING, std::memory_order_relaxed);
+                }
                 // Spin out waiting for readers to finish
             }
         }
-        else
+
+        const size_t blockMask = readerBlockMask();
+        for(;; ++spins)
         {
-            SpinLock _readLock(m_writerMutex);
-            ++m_readerLock;
+            if((m_state.load(std::memory_order_relaxed) & blockMask) == 0)
+            {
+                if((m_state.fetch_add(READER, std::memory_order_acquire) & blockMask) == 0)
+                    return spins;
+                // Lost the race to a writer, back out
+                m_state.fetch_sub(READER, std::memory_order_release);
+            }
+            // Spin out
         }
     }
 
+    bool SpinRWMutex::tryLock(bool isWriter) const
+    {
+        #ifdef DX_LOCK_PROFILING
+            const uint64_t waitStart = LockStats::now();
+            if(!tryLockImpl(isWriter))
+                return false;
+            m_stats.acquired(waitStart, 0, isWriter);
+            return true;
+        #else
+            return tryLockImpl(isWriter);
+        #endif
+    }
+
+    bool SpinRWMutex::tryLockImpl(bool isWriter) const
+    {
+        if(m_policy == PhaseFair)
+        {
+            if(isWriter)
+            {
+                size_t ticket = m_writersOut.load(std::memory_order_acquire);
+                if(!m_writersIn.compare_exchange_strong(ticket, ticket + 1, std::memory_order_acquire))
+                    return false;
+                const size_t entered = m_readersIn.fetch_add(pfNextWriterBits(), std::memory_order_acq_rel);
+                if(m_readersOut.load(std::memory_order_acquire) == entered)
+                    return true;
+                // Readers are still in, back out as if we'd held the lock
+                pfUnlockWriter();
+                return false;
+            }
+            if((m_readersIn.load(std::memory_order_relaxed) & PF_WRITER_BITS) != 0)
+                return false;
+            lockImpl(false);
+            return true;
+        }
+
+        size_t state = m_state.load(std::memory_order_relaxed);
+        if(isWriter)
+            return (state & ~WRITER_PENDING) == 0 && m_state.compare_exchange_strong(state, WRITER, std::memory_order_acquire);
+
+        const size_t blockMask = readerBlockMask();
+        if((state & blockMask) != 0)
+            return false;
+        if((m_state.fetch_add(READER, std::memory_order_acquire) & blockMask) == 0)
+            return true;
+        m_state.fetch_sub(READER, std::memory_order_release);
+        return false;
+    }
+
     void SpinRWMutex::unlock(bool isWriter) const
     {
-        if(!isWriter)
+        #ifdef DX_LOCK_PROFILING
+            if(isWriter)
+                m_stats.released();
+        #endif
+        if(m_policy == PhaseFair)
         {
-            assert(m_readerLock > 0); // unlock called too many times
-            if(m_readerLock > 0)
-                --m_readerLock;
+            if(isWriter)
+                pfUnlockWriter();
+            else
+                m_readersOut.fetch_add(PF_READER, std::memory_order_release);
+        }
+        else if(!isWriter)
+        {
+            assert(m_state >= READER); // unlock called too many times
+            m_state.fetch_sub(READER, std::memory_order_release);
         }
         else
         {
-            m_writerMutex.unlock();
+            // Readers backing out and pending writers may touch the other bits, only clear ours
+            assert((m_state & WRITER) != 0);
+            m_state.fetch_and(~WRITER, std::memory_order_release);
+        }
+    }
+
+    void SpinRWMutex::lockUpgradable() const
+    {
+        #ifdef DX_LOCK_PROFILING
+            const uint64_t waitStart = LockStats::now();
+            m_stats.acquired(waitStart, lockUpgradableImpl(), false);
+        #else
+            lockUpgradableImpl();
+        #endif
+    }
+
+    size_t SpinRWMutex::lockUpgradableImpl() const
+    {
+        if(m_policy == PhaseFair)
+        {
+            // The upgrader holds a writer ticket so it's never queued behind a writer waiting on it
+            const size_t spins = pfLockWriterTicket(m_writersIn.fetch_add(1, std::memory_order_relaxed));
+            m_readersIn.fetch_add(PF_READER, std::memory_order_acquire);
+            return spins;
+        }
+
+        const size_t blockMask = readerBlockMask() | WRITER | UPGRADER;
+        for(size_t spins = 0; ; ++spins)
+        {
+            size_t state = m_state.load(std::memory_order_relaxed);
+            if((state & blockMask) == 0 && m_state.compare_exchange_weak(state, state | UPGRADER, std::memory_order_acquire))
+                return spins;
+            // Spin out
+        }
+    }
+
+    bool SpinRWMutex::tryLockUpgradable() const
+    {
+        #ifdef DX_LOCK_PROFILING
+            const uint64_t waitStart = LockStats::now();
+            if(!tryLockUpgradableImpl())
+                return false;
+            m_stats.acquired(waitStart, 0, false);
+            return true;
+        #else
+            return tryLockUpgradableImpl();
+        #endif
+    }
+
+    bool SpinRWMutex::tryLockUpgradableImpl() const
+    {
+        if(m_policy == PhaseFair)
+        {
+            size_t ticket = m_writersOut.load(std::memory_order_acquire);
+            if(!m_writersIn.compare_exchange_strong(ticket, ticket + 1, std::memory_order_acquire))
+                return false;
+            m_readersIn.fetch_add(PF_READER, std::memory_order_acquire);
+            return true;
+        }
+
+        size_t state = m_state.load(std::memory_order_relaxed);
+        return (state & (readerBlockMask() | WRITER | UPGRADER)) == 0
+            && m_state.compare_exchange_strong(state, state | UPGRADER, std::memory_order_acquire);
+    }
+
+    void SpinRWMutex::unlockUpgradable() const
+    {
+        if(m_policy == PhaseFair)
+        {
+            m_readersOut.fetch_add(PF_READER, std::memory_order_release);
+            m_writersOut.fetch_add(1, std::memory_order_release);
+            return;
+        }
+
+        assert((m_state & UPGRADER) != 0);
+        m_state.fetch_and(~UPGRADER, std::memory_order_release);
+    }
+
+    void SpinRWMutex::upgrade() const
+    {
+        #ifdef DX_LOCK_PROFILING
+            const uint64_t waitStart = LockStats::now();
+            m_stats.upgraded(waitStart, upgradeImpl());
+        #else
+            upgradeImpl();
+        #endif
+    }
+
+    size_t SpinRWMutex::upgradeImpl() const
+    {
+        if(m_policy == PhaseFair)
+        {
+            // Our own read is still counted in m_readersIn, release it once everyone else is out
+            const size_t spins = pfBlockReaders(1);
+            m_readersOut.fetch_add(PF_READER, std::memory_order_relaxed);
+            return spins;
+        }
+
+        for(size_t spins = 0; ; ++spins)
+        {
+            size_t state = m_state.load(std::memory_order_relaxed);
+            if((state & ~WRITER_PENDING) == UPGRADER)
+            {
+                if(m_state.compare_exchange_weak(state, WRITER, std::memory_order_acquire))
+                    return spins;
+            }
+            else if(m_policy == PreferWriters && (state & WRITER_PENDING) == 0)
+            {
+                m_state.fetch_or(WRITER_PENDING, std::memory_order_relaxed);
+            }
+            // Spin out waiting for readers to finish
+        }
+    }
+
+    void SpinRWMutex::downgrade() const
+    {
+        #ifdef DX_LOCK_PROFILING
+            m_stats.released();
+        #endif
+        if(m_policy == PhaseFair)
+        {
+            m_readersIn.fetch_add(PF_READER, std::memory_order_relaxed);
+            pfUnlockWriter();
+            return;
+        }
+
+        // WRITER is set, so adding READER - WRITER sets a reader and clears WRITER in one step
+        assert((m_state & WRITER) != 0);
+        m_state.fetch_add(READER - WRITER, std::memory_order_release);
+    }
+
+    void SpinRWMutex::downgradeToUpgradable() const
+    {
+        #ifdef DX_LOCK_PROFILING
+            m_stats.released();
+        #endif
+        if(m_policy == PhaseFair)
+        {
+            // Keep our writer ticket, just let readers back in
+            m_readersIn.fetch_add(PF_READER, std::memory_order_relaxed);
+            m_readersIn.fetch_and(~PF_WRITER_BITS, std::memory_order_release);
+            return;
+        }
+
+        // WRITER is set and UPGRADER is clear, so this carries WRITER over into UPGRADER
+        assert((m_state & WRITER) != 0);
+        m_state.fetch_add(UPGRADER - WRITER, std::memory_order_release);
+    }
+
+    void SpinRWMutex::downgradeUpgradable() const
+    {
+        if(m_policy == PhaseFair)
+        {
+            // Already counted as a reader, just hand the writer ticket on
+            m_writersOut.fetch_add(1, std::memory_order_release);
+            return;
         }
+
+        assert((m_state & UPGRADER) != 0);
+        m_state.fetch_add(READER - UPGRADER, std::memory_order_release);
+    }
+
+    size_t SpinRWMutex::pfLockWriterTicket(size_t ticket) const
+    {
+        size_t spins = 0;
+        while(m_writersOut.load(std::memory_order_acquire) != ticket)
+        {
+            // Spin out waiting for our turn
+            ++spins;
+        }
+        return spins;
+    }
+
+    size_t SpinRWMutex::pfNextWriterBits() const
+    {
+        // A reader from an earlier phase may have missed that phase ending, so every phase has to
+        // look different to it, including a second one by an upgrader that downgraded in between
+        return PF_WRITER_PRESENT | (m_writePhase++ & PF_PHASE_ID);
+    }
+
+    size_t SpinRWMutex::pfBlockReaders(size_t ownReaders) const
+    {
+        // Readers arriving from here on wait for this phase, the ones already in are waited out
+        const size_t entered = m_readersIn.fetch_add(pfNextWriterBits(), std::memory_order_acq_rel) - ownReaders * PF_READER;
+        size_t spins = 0;
+        while(m_readersOut.load(std::memory_order_acquire) != entered)
+        {
+            // Spin out waiting for readers to finish
+            ++spins;
+        }
+        return spins;
+    }
+
+    void SpinRWMutex::pfUnlockWriter() const
+    {
+        m_readersIn.fetch_and(~PF_WRITER_BITS, std::memory_order_release);
+        m_writersOut.fetch_add(1, std::memory_order_release);
     }
 
     ////////////////////////////////////////////////////////////////////////////////////////////////
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // impl
 
-    SpinRWLock::SpinRWLock(const SpinRWMutex& _mutex, bool _writer) 
-        : m_lock(&_mutex), isWriter(_writer)
+    SpinRWLock::SpinRWLock(const SpinRWMutex& _mutex, bool _writer)
+        : isWriter(_writer), m_lock(&_mutex)
     {
         assert(m_lock); // We should have a handle on a valid mutex
         if(m_lock)
@@ -69,4 +394,50 @@ namespace DX
             m_lock->unlock(isWriter);
     }
 
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    SpinUpgradableLock::SpinUpgradableLock(const SpinRWMutex& _mutex)
+        : m_isWriter(false), m_lock(&_mutex)
+    {
+        assert(m_lock); // We should have a handle on a valid mutex
+        if(m_lock)
+            m_lock->lockUpgradable();
+    }
+
+    SpinUpgradableLock::~SpinUpgradableLock()
+    {
+        assert(m_lock); // We should have a handle on a valid mutex
+        if(!m_lock)
+            return;
+        if(m_isWriter)
+            m_lock->unlock(true);
+        else
+            m_lock->unlockUpgradable();
+    }
+
+    void SpinUpgradableLock::upgrade()
+    {
+        if(m_lock && !m_isWriter)
+        {
+            m_lock->upgrade();
+            m_isWriter = true;
+        }
+    }
+
+    void SpinUpgradableLock::downgrade()
+    {
+        if(m_lock && m_isWriter)
+        {
+            m_lock->downgradeToUpgradable();
+            m_isWriter = false;
+        }
+    }
+
+    bool SpinUpgradableLock::isWriter() const
+    {
+        return m_isWriter;
+    }
+
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include "../CacheLine.h"
 #include "SpinMutex.h"
+#include "LockProfiler.h"
 
 #include <atomic>
 
@@ -12,15 +13,26 @@ namespace DX
     ////////////////////////////////////////////////////////////////////////////////////////////////
 
     /*! \brief SpinRWMutex is a leightweight mutex that supports multiple readers (const-only access)
-        and a single writer. Supports readers up to the maximum value of size_t for your system. 
+        and a single writer. Supports readers up to the maximum value of size_t for your system.
 
         Calls to lock() from readers will block if a writer holds the lock. Calls to lock() from
         writers will block if there are any readers or writers holding onto the lock.
 
-        \note SpinRWMutex is favored towards writers attempting to get the lock
+        Which side wins when readers and writers are both waiting is chosen at construction:
+            - PreferWriters (default): once a writer is waiting, no new readers are let in.
+            - PreferReaders: readers are let in whenever no writer holds the lock. Best read
+              throughput, but writers can starve under a constant stream of readers.
+            - PhaseFair: readers and writers alternate phases. A waiting writer blocks new readers,
+              and every reader that arrives while a writer holds the lock gets in as soon as that
+              writer leaves, so neither side can starve the other. Writers are served in FIFO order.
 
-        \note SpinRWMutex is easiest to use with SpinRWLock. SpinRWLock lets you "set-it-and-forget-it" 
-        in regards to remembering if you're a reader/writer.
+        In addition to reader and writer locks, SpinRWMutex supports a single upgradable lock. An
+        upgradable lock coexists with readers but excludes writers and other upgradable locks, and
+        can be atomically upgraded to a writer lock (and downgraded again) without ever releasing
+        the mutex. This is the lock to use for check-then-modify paths.
+
+        \note SpinRWMutex is easiest to use with SpinRWLock and SpinUpgradableLock. They let you
+        "set-it-and-forget-it" in regards to remembering if you're a reader/writer.
 
         \note SpinRWMutex does *NOT* check to ensure that calls to lock/unlock are called with the same
         boolean. It does handle these cases (crash-wise), but calling lock(true) and unlock(false) from
@@ -34,7 +46,7 @@ namespace DX
         {
             myRWMutex.lock(true); // true indicates a writer
             myClass = other;
-            myRWMutex.unlock(true); // unlock my writer reference            
+            myRWMutex.unlock(true); // unlock my writer reference
         }
 
         MyClass getMyClass() const
@@ -48,32 +60,124 @@ namespace DX
         }
         \endcode
     */
-    class SpinRWMutex
+    class DX_CACHE_ALIGNED SpinRWMutex
     {
     public:
-        SpinRWMutex();
+        /*! \brief Which waiters SpinRWMutex favors when both readers and writers want the lock
+        */
+        enum Policy
+        {
+            PreferReaders,
+            PreferWriters,
+            PhaseFair
+        };
+
+        /*! \param[in] policy The fairness policy used to arbitrate between readers and writers
+        */
+        explicit SpinRWMutex(Policy policy = PreferWriters);
         ~SpinRWMutex();
-    
+
         /*! \brief  Locks the mutex as a writer or a reader
             \param[in] isWriter true indicates the caller is attempting to lock this as a writer,
                                 false indicates the caller is attempting to lock as a reader.
             \note lock() is not recursive.
             \note lock() is blocking.
         */
-        void lock(bool isWriter) const;    
+        void lock(bool isWriter) const;
+
+        /*! \brief  Attempts to lock the mutex as a writer or a reader. Returns true if the lock
+            was acquired.
+            \note With the PhaseFair policy a reader that races a writer for the lock may wait for
+            that writer to finish instead of failing.
+        */
+        bool tryLock(bool isWriter) const;
 
         /*! \brief Unlocks the mutex as a writer or a reader
         */
         void unlock(bool isWriter) const;
-    
+
+        /*! \brief Locks the mutex as the upgradable reader. Blocks while a writer or another
+            upgradable reader holds the lock, plain readers are unaffected.
+        */
+        void lockUpgradable() const;
+
+        /*! \brief Attempts to lock the mutex as the upgradable reader
+        */
+        bool tryLockUpgradable() const;
+
+        /*! \brief Releases an upgradable lock
+        */
+        void unlockUpgradable() const;
+
+        /*! \brief Turns the caller's upgradable lock into a writer lock, blocking until the
+            remaining readers have left. The mutex is never released in between, so anything
+            checked under the upgradable lock still holds once upgrade() returns.
+        */
+        void upgrade() const;
+
+        /*! \brief Turns the caller's writer lock into a reader lock without releasing the mutex
+        */
+        void downgrade() const;
+
+        /*! \brief Turns the caller's writer lock back into an upgradable lock without releasing
+            the mutex
+        */
+        void downgradeToUpgradable() const;
+
+        /*! \brief Turns the caller's upgradable lock into a plain reader lock, letting the next
+            writer or upgradable reader queue up behind it
+        */
+        void downgradeUpgradable() const;
+
+        Policy policy() const;
+
+        /*! \brief Names the mutex in LockProfiler dumps. Does nothing unless DX_LOCK_PROFILING is
+            defined. Only writer hold times are recorded, readers overlap.
+        */
+        void setProfileName(const char* name);
+
     private:
-        // Initial padding so we aren't overlapping some other potentially contended cache
-        volatile char pad_0[CACHE_LINE_SIZE];
-        // Keeps track of the number of readers
-        mutable std::atomic<size_t> m_readerLock;
-        // SpinMutex is already padded
-        SpinMutex m_lockMutex;
-        SpinMutex m_writerMutex;
+        // Bits of m_state, used by the PreferReaders and PreferWriters policies
+        static const size_t WRITER          = 1;
+        static const size_t UPGRADER        = 2;
+        static const size_t WRITER_PENDING  = 4;
+        static const size_t READER          = 8;
+
+        // Bits of m_readersIn / m_readersOut, used by the PhaseFair policy
+        static const size_t PF_WRITER_PRESENT   = 2;
+        static const size_t PF_PHASE_ID         = 1;
+        static const size_t PF_WRITER_BITS      = PF_WRITER_PRESENT | PF_PHASE_ID;
+        static const size_t PF_READER           = 0x100;
+
+        size_t  readerBlockMask() const;
+
+        // The *Impl functions do the actual locking and return how many times they spun
+        size_t  lockImpl(bool isWriter) const;
+        bool    tryLockImpl(bool isWriter) const;
+        size_t  lockUpgradableImpl() const;
+        bool    tryLockUpgradableImpl() const;
+        size_t  upgradeImpl() const;
+
+        size_t  pfLockWriterTicket(size_t ticket) const;
+        // Writer bits of the next write phase, called by the holder of the writer ticket
+        size_t  pfNextWriterBits() const;
+        size_t  pfBlockReaders(size_t ownReaders) const;
+        void    pfUnlockWriter() const;
+
+        const Policy m_policy;
+        // Reader count and writer / upgrader / pending flags
+        mutable std::atomic<size_t> m_state;
+        // Phase-fair reader entry and exit counters, low bits of m_readersIn hold the writer bits
+        mutable std::atomic<size_t> m_readersIn;
+        mutable std::atomic<size_t> m_readersOut;
+        // Phase-fair writer tickets, the current writer / upgrader keeps its ticket through upgrade()
+        DX_CACHE_ALIGNED mutable std::atomic<size_t> m_writersIn;
+        mutable std::atomic<size_t> m_writersOut;
+        // Phase-fair write phases entered so far, only touched by the holder of the writer ticket
+        mutable size_t m_writePhase;
+    #ifdef DX_LOCK_PROFILING
+        mutable LockStats m_stats;
+    #endif
 
         SpinRWMutex(const SpinRWMutex&);
         SpinRWMutex(SpinRWMutex&&);
@@ -81,10 +185,10 @@ namespace DX
 
     ////////////////////////////////////////////////////////////////////////////////////////////////
     ////////////////////////////////////////////////////////////////////////////////////////////////
-    
-    /*! \brief SpinRWLock is the preferred way of interacting with a SpinRWMutex. SpinRWLock is a 
+
+    /*! \brief SpinRWLock is the preferred way of interacting with a SpinRWMutex. SpinRWLock is a
         lock-guard style class, locking the SpinRWMutex upon construction and releasing the lock upon
-        destruction. SpinRWMutex remembers whether it is a reader or writer lock, and releases the 
+        destruction. SpinRWMutex remembers whether it is a reader or writer lock, and releases the
         same kind of lock that it was constructed with.
 
         The big advantage of using SpinRWLocks over SpinRWMutex is the automatic unlock on destruction:
@@ -115,7 +219,7 @@ namespace DX
         /*! \param[in] mutex The SpinRWMutex that the lock should be locking/unlocking
             \param[in] isWriter True indicates a writer lock, False indicates a reader lock
         */
-        SpinRWLock(const SpinRWMutex& mutex, bool isWriter); 
+        SpinRWLock(const SpinRWMutex& mutex, bool isWriter);
         ~SpinRWLock();
     private:
         bool isWriter;
@@ -125,4 +229,54 @@ namespace DX
         SpinRWLock(SpinRWLock&&);
     };
 
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief SpinUpgradableLock is a lock-guard that holds the upgradable lock of a SpinRWMutex.
+        It can be upgraded to a writer lock and downgraded back as many times as needed, and releases
+        whichever kind of lock it holds upon destruction.
+
+        Readers keep running while the upgradable lock is held, so the common "already there" case
+        of a check-then-insert never blocks them:
+        \code
+        std::map<Key, Value> myCache;
+        mutable SpinRWMutex myRWMutex;
+
+        const Value& getOrInsert(const Key& key)
+        {
+            SpinUpgradableLock _lock(myRWMutex);
+            std::map<Key, Value>::iterator it = myCache.find(key);
+            if(it == myCache.end())
+            {
+                _lock.upgrade(); // Nobody could have inserted key in the meantime
+                it = myCache.insert(std::make_pair(key, makeValue(key))).first;
+            }
+            return it->second;
+        }
+        \endcode
+    */
+    class SpinUpgradableLock
+    {
+    public:
+        /*! \param[in] mutex The SpinRWMutex that the lock should be locking/unlocking
+        */
+        SpinUpgradableLock(const SpinRWMutex& mutex);
+        ~SpinUpgradableLock();
+
+        /*! \brief Upgrades to a writer lock. Does nothing if already upgraded.
+        */
+        void upgrade();
+        /*! \brief Downgrades back to an upgradable lock. Does nothing if not upgraded.
+        */
+        void downgrade();
+
+        bool isWriter() const;
+    private:
+        bool m_isWriter;
+        const SpinRWMutex* m_lock;
+
+        SpinUpgradableLock(const SpinUpgradableLock&);
+        SpinUpgradableLock(SpinUpgradableLock&&);
+    };
+
 }
\ No newline at end of file
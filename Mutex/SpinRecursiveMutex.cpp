@@ -1,16 +1,20 @@
 
 #include "SpinRecursiveMutex.h"
+#include "../Threading/ThreadId.h"
 
-#include <thread>
+#include <cassert>
 
 namespace DX
 {
     ////////////////////////////////////////////////////////////////////////////////////////////////
-    ////////////////////////////////////////////////////////////////////////////////////////////////   
+    ////////////////////////////////////////////////////////////////////////////////////////////////
     // impl
 
     SpinRecursiveMutex::SpinRecursiveMutex() : SpinMutex(), m_owner(0), m_count(0)
     {
+        #ifdef DX_LOCK_PROFILING
+            m_stats.setKind("SpinRecursiveMutex");
+        #endif
     }
 
     SpinRecursiveMutex::~SpinRecursiveMutex()
@@ -19,51 +23,73 @@ namespace DX
 
     void SpinRecursiveMutex::lock() const
     {
-        const size_t queryingThread = std::this_thread::get_id().hash();
-        #if defined _DEBUG || defined DEBUG 
-            const bool wasLocked = m_lock.load();
-            assert(wasLocked ? queryingThread == m_owner : m_count == 0);
+        const size_t queryingThread = currentThreadId();
+        // Only we could have stored our own id, so a relaxed load is enough to tell if we own it
+        if(m_owner.load(std::memory_order_relaxed) == queryingThread)
+        {
+            ++m_count;
+            return;
+        }
+
+        #ifdef DX_LOCK_PROFILING
+            const uint64_t waitStart = LockStats::now();
+            size_t spins = 0;
         #endif
-        while(m_lock.exchange(true) && queryingThread != m_owner)
+        size_t unowned = 0;
+        while(!m_owner.compare_exchange_weak(unowned, queryingThread, std::memory_order_acquire))
         {
-            // Spin out
+            while(m_owner.load(std::memory_order_relaxed) != 0)
+            {
+                // Spin out
+                #ifdef DX_LOCK_PROFILING
+                    ++spins;
+                #endif
+            }
+            unowned = 0;
         }
 
         // Here we have exclusive ownership
-        SpinLock _lock(m_assignmentMutex);
-        m_owner = queryingThread;
-        ++m_count;
+        assert(m_count == 0);
+        m_count = 1;
+        #ifdef DX_LOCK_PROFILING
+            m_stats.acquired(waitStart, spins);
+        #endif
     }
 
     bool SpinRecursiveMutex::tryLock() const
     {
-        const size_t queryingThread = std::this_thread::get_id().hash();
-
-        const bool wasLocked = m_lock.exchange(true);
-        const size_t owner = m_owner;
-        if(!wasLocked || (wasLocked && queryingThread == owner))
+        const size_t queryingThread = currentThreadId();
+        if(m_owner.load(std::memory_order_relaxed) == queryingThread)
         {
-            SpinLock _lock(m_assignmentMutex);
-            assert(wasLocked ? queryingThread == m_owner : m_count == 0);
-            m_owner = queryingThread;
             ++m_count;
             return true;
         }
-        return false;        
+
+        #ifdef DX_LOCK_PROFILING
+            const uint64_t waitStart = LockStats::now();
+        #endif
+        size_t unowned = 0;
+        if(!m_owner.compare_exchange_strong(unowned, queryingThread, std::memory_order_acquire))
+            return false;
+
+        assert(m_count == 0);
+        m_count = 1;
+        #ifdef DX_LOCK_PROFILING
+            m_stats.acquired(waitStart, 0);
+        #endif
+        return true;
     }
 
     void SpinRecursiveMutex::unlock() const
     {
-        #if defined(_DEBUG) || defined(DEBUG)
-            const size_t queryingThread = std::this_thread::get_id().hash();
-            assert(m_owner == queryingThread);
-        #endif
-
+        assert(m_owner.load(std::memory_order_relaxed) == currentThreadId());
         assert(m_count > 0); // Make sure unlock() isn't called more than lock()
         if(--m_count == 0)
         {
-            m_lock = false;
-            m_owner = 0;
+            #ifdef DX_LOCK_PROFILING
+                m_stats.released();
+            #endif
+            m_owner.store(0, std::memory_order_release);
         }
     }
 
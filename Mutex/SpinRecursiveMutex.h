@@ -11,6 +11,14 @@ namespace DX
     ////////////////////////////////////////////////////////////////////////////////////////////////
     ////////////////////////////////////////////////////////////////////////////////////////////////
 
+    /*! \brief SpinRecursiveMutex is a SpinMutex that the owning thread can lock any number of times,
+        as long as every lock() is matched by an unlock().
+
+        The whole lock state is a single owner word holding the id of the owning thread (see
+        currentThreadId()). Taking the mutex for the first time is one compare-exchange, and
+        re-entering it from the owner is a relaxed load plus a plain increment of a counter that
+        only the owner ever touches.
+    */
     class SpinRecursiveMutex : public SpinMutex
     {
     public:
@@ -24,10 +32,10 @@ namespace DX
         void unlock() const;
 
     private:
-        mutable SpinMutex m_assignmentMutex;
-        mutable std::atomic<size_t> m_count;
+        // Id of the owning thread, 0 when unlocked. SpinMutex::m_lock is unused.
         mutable std::atomic<size_t> m_owner;
-        volatile char pad_0[CACHE_LINE_SIZE - ((sizeof(std::atomic<size_t>) + sizeof(std::atomic<bool>)) % CACHE_LINE_SIZE)];
+        // Recursion depth, only read or written by the owner
+        mutable size_t m_count;
 
         SpinRecursiveMutex(const SpinRecursiveMutex&);
         SpinRecursiveMutex(SpinRecursiveMutex&&);
@@ -11,6 +11,9 @@ namespace DX
 
     SpinYieldMutex::SpinYieldMutex(const size_t maxYieldTicks) : SpinMutex(), m_maxYieldTicks(maxYieldTicks)
     {
+        #ifdef DX_LOCK_PROFILING
+            m_stats.setKind("SpinYieldMutex");
+        #endif
     }
 
     SpinYieldMutex::~SpinYieldMutex()
@@ -19,25 +22,35 @@ namespace DX
 
     void SpinYieldMutex::lock() const
     {
+        #ifdef DX_LOCK_PROFILING
+            const uint64_t waitStart = LockStats::now();
+            size_t spins = 0;
+        #endif
         size_t numTries = 0;
         while(m_lock.exchange(true))
         {
+            #ifdef DX_LOCK_PROFILING
+                ++spins;
+            #endif
             if(++numTries >= m_maxYieldTicks)   // >= just for sanity
             {
                 numTries = 0;
                 std::this_thread::yield();
             }
         }
+        #ifdef DX_LOCK_PROFILING
+            m_stats.acquired(waitStart, spins);
+        #endif
     }
 
     bool SpinYieldMutex::tryLock() const
     {
-        return !m_lock.exchange(true);
+        return SpinMutex::tryLock();
     }
 
     void SpinYieldMutex::unlock() const
     {
-        m_lock = false;
+        SpinMutex::unlock();
     }
 
 }
\ No newline at end of file
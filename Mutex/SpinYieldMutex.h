@@ -1,4 +1,6 @@
 
+#pragma once
+
 #include "SpinMutex.h"
 
 namespace DX
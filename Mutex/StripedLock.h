@@ -0,0 +1,141 @@
+
+#pragma once
+
+#include "ParkingMutex.h"
+
+#include <cassert>
+#include <cstdint>
+#include <functional>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    // Default number of stripes of a StripedLock
+    #ifndef DEFAULT_LOCK_STRIPES
+        #define DEFAULT_LOCK_STRIPES 256
+    #endif
+
+    /*! \brief StripedLock guards an unbounded set of keys with a fixed array of mutexes: every key
+        hashes to one stripe, and two keys only contend if they land on the same one. Memory stays
+        the same no matter how many records are locked, and with the default ParkingMutex stripes
+        a thousand locks fit in a kilobyte.
+
+        The stripe count is rounded up to a power of two. Keys are hashed with std::hash<Key> and
+        then mixed, since std::hash is the identity for integers on most standard libraries.
+
+        \note Holding two stripes at once can deadlock unless every thread takes them in the same
+        order, so lock them by increasing indexOf() (lockAll() does).
+
+        \code
+        StripedLock<> recordLocks(1024);
+        ...
+        {
+            std::lock_guard<ParkingMutex> lock(recordLocks.stripe(record.id));
+            record.update(change);
+        }
+        \endcode
+    */
+    template <typename MutexT = ParkingMutex>
+    class StripedLock
+    {
+    public:
+        explicit StripedLock(size_t numStripes = DEFAULT_LOCK_STRIPES);
+        ~StripedLock();
+
+        /*! \brief The mutex guarding key
+        */
+        template <typename Key>
+        MutexT& stripe(const Key& key) const;
+        /*! \brief Index of the stripe guarding key, for ordering when taking several
+        */
+        template <typename Key>
+        size_t  indexOf(const Key& key) const;
+        MutexT& stripeAt(size_t index) const;
+        size_t  numStripes() const;
+
+        /*! \brief Locks every stripe in index order, e.g. to resize the structure being guarded
+        */
+        void lockAll() const;
+        void unlockAll() const;
+
+    private:
+        MutexT*         m_stripes;
+        const size_t    m_mask;
+
+        static size_t roundUp(size_t numStripes);
+
+        StripedLock(const StripedLock&);
+        StripedLock(StripedLock&&);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    template <typename MutexT>
+    StripedLock<MutexT>::StripedLock(size_t numStripes) : m_stripes(nullptr), m_mask(roundUp(numStripes) - 1)
+    {
+        m_stripes = new MutexT[m_mask + 1];
+    }
+
+    template <typename MutexT>
+    StripedLock<MutexT>::~StripedLock()
+    {
+        delete[] m_stripes;
+    }
+
+    template <typename MutexT>
+    size_t StripedLock<MutexT>::roundUp(size_t numStripes)
+    {
+        size_t rounded = 1;
+        while(rounded < numStripes)
+            rounded <<= 1;
+        return rounded;
+    }
+
+    template <typename MutexT>
+    template <typename Key>
+    size_t StripedLock<MutexT>::indexOf(const Key& key) const
+    {
+        // Fibonacci hashing, the high bits of the product depend on all of the hash
+        const uint64_t hash = static_cast<uint64_t>(std::hash<Key>()(key)) * 0x9E3779B97F4A7C15ULL;
+        return static_cast<size_t>(hash >> 32) & m_mask;
+    }
+
+    template <typename MutexT>
+    template <typename Key>
+    MutexT& StripedLock<MutexT>::stripe(const Key& key) const
+    {
+        return m_stripes[indexOf(key)];
+    }
+
+    template <typename MutexT>
+    MutexT& StripedLock<MutexT>::stripeAt(size_t index) const
+    {
+        assert(index <= m_mask);
+        return m_stripes[index];
+    }
+
+    template <typename MutexT>
+    size_t StripedLock<MutexT>::numStripes() const
+    {
+        return m_mask + 1;
+    }
+
+    template <typename MutexT>
+    void StripedLock<MutexT>::lockAll() const
+    {
+        for(size_t i = 0; i <= m_mask; ++i)
+            m_stripes[i].lock();
+    }
+
+    template <typename MutexT>
+    void StripedLock<MutexT>::unlockAll() const
+    {
+        for(size_t i = m_mask + 1; i > 0; --i)
+            m_stripes[i - 1].unlock();
+    }
+
+}
\ No newline at end of file
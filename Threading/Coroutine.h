@@ -0,0 +1,39 @@
+
+#pragma once
+
+#include "Executor.h"
+
+/*
+    DX_HAS_COROUTINES is defined when the translation unit including this is compiled with C++20
+    coroutine support. The awaitables (ConcurrentQueue::popAsync(), AsyncMutex) only exist then, but
+    everything they rely on is always compiled in, so C++11 and C++20 code can share the library
+    and the same queues.
+*/
+#if defined __has_include
+    #if __has_include(<coroutine>) && defined __cpp_impl_coroutine
+        #include <coroutine>
+        #define DX_HAS_COROUTINES
+    #endif
+#endif
+
+#ifdef DX_HAS_COROUTINES
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief Points waiter at a suspended coroutine, resuming the waiter resumes the coroutine
+    */
+    inline void setContinuation(AsyncWaiter& waiter, std::coroutine_handle<> handle)
+    {
+        waiter.task = [](void* address)
+        {
+            std::coroutine_handle<>::from_address(address).resume();
+        };
+        waiter.context = handle.address();
+    }
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,191 @@
+
+#include "Epoch.h"
+#include "../CacheLine.h"
+#include "../Mutex/SpinMutex.h"
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    namespace
+    {
+        struct Retired
+        {
+            void*       object;
+            void        (*deleter)(void*);
+            uint64_t    epoch;
+        };
+
+        // One per thread. Records are never freed, a thread that exits leaves its record for the
+        // next new thread to adopt.
+        struct DX_CACHE_ALIGNED Record
+        {
+            Record() : state(0), inUse(true), next(nullptr), nesting(0), sinceCollect(0) {}
+
+            // Pinned epoch << 1 | 1 while pinned, 0 otherwise
+            std::atomic<uint64_t>   state;
+            std::atomic<bool>       inUse;
+            Record*                 next;
+            // Owner only
+            size_t                  nesting;
+            size_t                  sinceCollect;
+            std::vector<Retired>    retired;
+        };
+
+        struct DX_CACHE_ALIGNED Global
+        {
+            Global() : epoch(1), records(nullptr) {}
+
+            std::atomic<uint64_t>   epoch;
+            std::atomic<Record*>    records;
+            // Retired objects of threads that exited before they could be freed
+            SpinMutex               orphansMutex;
+            std::vector<Retired>    orphans;
+        };
+
+        Global& global()
+        {
+            static Global s_global;
+            return s_global;
+        }
+
+        Record* acquireRecord()
+        {
+            Global& state = global();
+            for(Record* record = state.records.load(std::memory_order_acquire); record != nullptr; record = record->next)
+            {
+                bool expected = false;
+                if(!record->inUse.load(std::memory_order_relaxed) && record->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire))
+                    return record;
+            }
+
+            Record* record = new Record();
+            Record* head = state.records.load(std::memory_order_relaxed);
+            do
+            {
+                record->next = head;
+            }
+            while(!state.records.compare_exchange_weak(head, record, std::memory_order_release, std::memory_order_relaxed));
+            return record;
+        }
+
+        // Frees the front of retired that is at least two epochs old
+        void freeExpired(std::vector<Retired>& retired, uint64_t epoch)
+        {
+            size_t kept = 0;
+            for(size_t i = 0; i < retired.size(); ++i)
+            {
+                if(retired[i].epoch + 2 <= epoch)
+                    retired[i].deleter(retired[i].object);
+                else
+                    retired[kept++] = retired[i];
+            }
+            retired.resize(kept);
+        }
+
+        struct ThreadRecord
+        {
+            ThreadRecord() : record(acquireRecord()) {}
+
+            ~ThreadRecord()
+            {
+                if(!record->retired.empty())
+                {
+                    Global& state = global();
+                    SpinLock lock(state.orphansMutex);
+                    state.orphans.insert(state.orphans.end(), record->retired.begin(), record->retired.end());
+                    record->retired.clear();
+                }
+                record->state.store(0, std::memory_order_release);
+                record->inUse.store(false, std::memory_order_release);
+            }
+
+            Record* record;
+        };
+
+        Record& currentRecord()
+        {
+            static thread_local ThreadRecord s_record;
+            return *s_record.record;
+        }
+
+        // Advances the epoch if every pinned thread has seen the current one
+        uint64_t tryAdvance()
+        {
+            Global& state = global();
+            // Pairs with the fence in pin(): a thread we see as unpinned will see the new epoch
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const uint64_t epoch = state.epoch.load(std::memory_order_acquire);
+            for(Record* record = state.records.load(std::memory_order_acquire); record != nullptr; record = record->next)
+            {
+                const uint64_t recordState = record->state.load(std::memory_order_acquire);
+                if((recordState & 1) && (recordState >> 1) != epoch)
+                    return epoch;
+            }
+
+            uint64_t expected = epoch;
+            state.epoch.compare_exchange_strong(expected, epoch + 1, std::memory_order_acq_rel);
+            return expected == epoch ? epoch + 1 : expected;
+        }
+
+        void pin(Record& record)
+        {
+            if(record.nesting++ != 0)
+                return;
+            record.state.store(global().epoch.load(std::memory_order_relaxed) << 1 | 1, std::memory_order_relaxed);
+            // The pin has to be visible before we read anything the guard protects
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+
+    Epoch::Guard::Guard()
+    {
+        pin(currentRecord());
+    }
+
+    Epoch::Guard::Guard(const Guard&)
+    {
+        pin(currentRecord());
+    }
+
+    Epoch::Guard::~Guard()
+    {
+        Record& record = currentRecord();
+        if(--record.nesting == 0)
+            record.state.store(0, std::memory_order_release);
+    }
+
+    void Epoch::retire(void* object, void (*deleter)(void*))
+    {
+        Record& record = currentRecord();
+        Retired retired = { object, deleter, global().epoch.load(std::memory_order_acquire) };
+        record.retired.push_back(retired);
+
+        if(++record.sinceCollect >= DEFAULT_EPOCH_COLLECT_PERIOD)
+        {
+            record.sinceCollect = 0;
+            collect();
+        }
+    }
+
+    void Epoch::collect()
+    {
+        Record& record = currentRecord();
+        const uint64_t epoch = tryAdvance();
+        freeExpired(record.retired, epoch);
+
+        Global& state = global();
+        if(state.orphansMutex.tryLock())
+        {
+            freeExpired(state.orphans, epoch);
+            state.orphansMutex.unlock();
+        }
+    }
+
+}
\ No newline at end of file
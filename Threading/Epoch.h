@@ -0,0 +1,90 @@
+
+#pragma once
+
+#include <cstddef>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    // Retires a thread collects after, trying to advance the epoch and free what is safe to free
+    #ifndef DEFAULT_EPOCH_COLLECT_PERIOD
+        #define DEFAULT_EPOCH_COLLECT_PERIOD 64
+    #endif
+
+    /*! \brief Epoch is process-wide epoch based reclamation for lock-free structures: memory that
+        was unlinked while other threads may still be reading it is retired instead of deleted, and
+        freed once every thread has moved on.
+
+        Readers pin the current epoch with a Guard for as long as they hold pointers into the
+        structure. The global epoch only advances when every pinned thread has seen it, and
+        something retired in epoch e is freed once the epoch reaches e + 2, by which time no
+        pinned thread can still have it.
+
+        Pinning is a store and a fence on a thread-local record, so keep guards around whole
+        operations rather than single loads. A thread that stays pinned holds up all reclamation.
+
+        \code
+        {
+            Epoch::Guard guard;
+            Node* node = head.load(std::memory_order_acquire);
+            ... // node stays valid until the guard goes
+        }
+        ...
+        // After unlinking node
+        Epoch::retire(node);
+        \endcode
+    */
+    class Epoch
+    {
+    public:
+        /*! \brief Pins the calling thread while alive. Guards nest, and copies pin the thread
+            again, so they must stay on the thread that made them.
+        */
+        class Guard
+        {
+        public:
+            Guard();
+            Guard(const Guard&);
+            ~Guard();
+
+        private:
+            Guard& operator=(const Guard&);
+        };
+
+        /*! \brief Frees object with deleter(object) once no pinned thread can still see it
+        */
+        static void retire(void* object, void (*deleter)(void*));
+        template <typename T>
+        static void retire(T* object);
+
+        /*! \brief Tries to advance the epoch and frees whatever is safe, normally done every
+            DEFAULT_EPOCH_COLLECT_PERIOD retires
+        */
+        static void collect();
+
+    private:
+        template <typename T>
+        static void deleteObject(void* object);
+
+        Epoch();
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    template <typename T>
+    void Epoch::deleteObject(void* object)
+    {
+        delete static_cast<T*>(object);
+    }
+
+    template <typename T>
+    void Epoch::retire(T* object)
+    {
+        retire(object, &deleteObject<T>);
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+
+#include "Executor.h"
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    Executor::Executor()
+    {
+    }
+
+    Executor::~Executor()
+    {
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    InlineExecutor::InlineExecutor()
+    {
+    }
+
+    InlineExecutor::~InlineExecutor()
+    {
+    }
+
+    void InlineExecutor::execute(void (*task)(void* context), void* context)
+    {
+        task(context);
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    AsyncWaiter::AsyncWaiter() : next(nullptr), executor(nullptr), task(nullptr), context(nullptr)
+    {
+    }
+
+    void AsyncWaiter::resume()
+    {
+        if(executor != nullptr)
+            executor->execute(task, context);
+        else
+            task(context);
+    }
+
+}
\ No newline at end of file
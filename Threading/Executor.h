@@ -0,0 +1,67 @@
+
+#pragma once
+
+#include <cstddef>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief Executor is where asynchronous waits continue once they are satisfied, e.g. a thread
+        pool or an event loop. Implementations only have to run task(context) at some point, on
+        whatever thread they like.
+
+        Primitives never allocate to hand work to an executor, so if execute() has to queue the
+        task it should do so without allocating either where it can.
+    */
+    class Executor
+    {
+    public:
+        Executor();
+        virtual ~Executor() = 0;
+
+        virtual void execute(void (*task)(void* context), void* context) = 0;
+
+    private:
+        Executor(const Executor&);
+        Executor(Executor&&);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief InlineExecutor runs every task right away on the calling thread, i.e. on whichever
+        thread satisfied the wait. This is also what happens when no executor is given at all.
+    */
+    class InlineExecutor : public Executor
+    {
+    public:
+        InlineExecutor();
+        ~InlineExecutor();
+
+        void execute(void (*task)(void* context), void* context);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief AsyncWaiter is the intrusive list node of a suspended asynchronous wait. It lives in
+        the waiting coroutine's frame, so queueing a waiter never allocates.
+    */
+    struct AsyncWaiter
+    {
+        AsyncWaiter();
+
+        /*! \brief Hands the waiter's continuation to its executor, or runs it inline if it has none.
+            The waiter may be gone once this returns.
+        */
+        void resume();
+
+        AsyncWaiter*    next;
+        Executor*       executor;
+        void            (*task)(void* context);
+        void*           context;
+    };
+
+}
\ No newline at end of file
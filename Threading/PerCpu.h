@@ -0,0 +1,108 @@
+
+#pragma once
+
+#include "../CacheLine.h"
+#include "Topology.h"
+
+#include <cassert>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief PerCpu keeps one value-initialized T per logical cpu, each on its own cache line,
+        and local() returns the one of the cpu the calling thread runs on. Threads on different
+        cpus then work on different lines, so a hot counter or free list scales with cores instead
+        of bouncing one line between them.
+
+        A thread can be migrated, or preempted by another thread on its cpu, right after local()
+        returns, so two threads can still end up on the same slot: T has to be safe to share (use
+        atomics or a lock in it), PerCpu only makes sharing rare. Read a total by going over every
+        slot with at().
+
+        \code
+        PerCpu<std::atomic<uint64_t> > requests;
+        ...
+        requests.local().fetch_add(1, std::memory_order_relaxed);
+        ...
+        uint64_t total = 0;
+        for(size_t cpu = 0; cpu < requests.size(); ++cpu)
+            total += requests.at(cpu).load(std::memory_order_relaxed);
+        \endcode
+    */
+    template <typename T>
+    class PerCpu
+    {
+    public:
+        PerCpu();
+        ~PerCpu();
+
+        /*! \brief The slot of the cpu the calling thread is running on
+        */
+        T&          local();
+        const T&    local() const;
+        T&          at(size_t cpu);
+        const T&    at(size_t cpu) const;
+        /*! \brief Number of slots, Topology::numCpus()
+        */
+        size_t      size() const;
+
+    private:
+        CachePadded<T>* m_slots;
+        const size_t    m_size;
+
+        PerCpu(const PerCpu&);
+        PerCpu(PerCpu&&);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    template <typename T>
+    PerCpu<T>::PerCpu() : m_slots(nullptr), m_size(Topology::instance().numCpus())
+    {
+        m_slots = new CachePadded<T>[m_size];
+    }
+
+    template <typename T>
+    PerCpu<T>::~PerCpu()
+    {
+        delete[] m_slots;
+    }
+
+    template <typename T>
+    T& PerCpu<T>::local()
+    {
+        // Cpus brought online after startup can have higher ids
+        return *m_slots[Topology::currentCpu() % m_size];
+    }
+
+    template <typename T>
+    const T& PerCpu<T>::local() const
+    {
+        return *m_slots[Topology::currentCpu() % m_size];
+    }
+
+    template <typename T>
+    T& PerCpu<T>::at(size_t cpu)
+    {
+        assert(cpu < m_size);
+        return *m_slots[cpu];
+    }
+
+    template <typename T>
+    const T& PerCpu<T>::at(size_t cpu) const
+    {
+        assert(cpu < m_size);
+        return *m_slots[cpu];
+    }
+
+    template <typename T>
+    size_t PerCpu<T>::size() const
+    {
+        return m_size;
+    }
+
+}
\ No newline at end of file
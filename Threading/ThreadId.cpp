@@ -0,0 +1,21 @@
+
+#include "ThreadId.h"
+
+#include <atomic>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    namespace Detail
+    {
+        size_t nextThreadId()
+        {
+            static std::atomic<size_t> s_nextId(1);
+            return s_nextId.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+}
\ No newline at end of file
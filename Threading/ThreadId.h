@@ -0,0 +1,31 @@
+
+#pragma once
+
+#include <cstddef>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    namespace Detail
+    {
+        size_t nextThreadId();
+    }
+
+    /*! \brief Returns a small, non-zero integer that identifies the calling thread. Ids are handed
+        out in the order threads first ask for one and are never reused, so 0 can safely be used as
+        "no thread".
+
+        The id is cached in thread-local storage, so after the first call this is a plain TLS read
+        as opposed to std::this_thread::get_id() plus a hash.
+    */
+    inline size_t currentThreadId()
+    {
+        static thread_local size_t id = 0;
+        if(id == 0)
+            id = Detail::nextThreadId();
+        return id;
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,336 @@
+
+#include "Topology.h"
+#include "ThreadId.h"
+#include "../CacheLine.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <utility>
+
+#if defined(__linux__)
+    #include <dirent.h>
+    #include <fstream>
+    #include <pthread.h>
+    #include <sched.h>
+#elif defined(_WIN32)
+    #define NOMINMAX
+    #include <Windows.h>
+#endif
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    namespace
+    {
+        size_t hardwareThreads()
+        {
+            return std::max<size_t>(1, std::thread::hardware_concurrency());
+        }
+
+    #if defined(__linux__)
+        // Parses the kernel's cpu list format, e.g. "0-3,8-11"
+        void parseCpuList(const std::string& list, std::vector<size_t>& cpus)
+        {
+            size_t i = 0;
+            while(i < list.size())
+            {
+                char* end = nullptr;
+                const size_t first = std::strtoul(list.c_str() + i, &end, 10);
+                size_t last = first;
+                i = end - list.c_str();
+                if(i < list.size() && list[i] == '-')
+                {
+                    last = std::strtoul(list.c_str() + i + 1, &end, 10);
+                    i = end - list.c_str();
+                }
+                for(size_t cpu = first; cpu <= last; ++cpu)
+                    cpus.push_back(cpu);
+                if(i < list.size() && list[i] != ',')
+                    break;
+                ++i;
+            }
+        }
+
+        bool readLine(const std::string& path, std::string& line)
+        {
+            std::ifstream file(path.c_str());
+            return static_cast<bool>(std::getline(file, line)) && !line.empty();
+        }
+
+        bool readNumber(const std::string& path, size_t& value)
+        {
+            std::string line;
+            if(!readLine(path, line))
+                return false;
+            value = std::strtoul(line.c_str(), nullptr, 10);
+            return true;
+        }
+    #endif
+    }
+
+    Topology::Topology() : m_numCpus(1), m_numCores(1), m_numNodes(1), m_cacheLineSize(CACHE_LINE_SIZE), m_fakeNodes(0)
+    {
+        read();
+    }
+
+    const Topology& Topology::instance()
+    {
+        static const Topology s_topology;
+        return s_topology;
+    }
+
+    void Topology::read()
+    {
+    #if defined(__linux__)
+        std::string line;
+        std::vector<size_t> cpus;
+        if(readLine("/sys/devices/system/cpu/possible", line))
+            parseCpuList(line, cpus);
+        m_numCpus = cpus.empty() ? hardwareThreads() : *std::max_element(cpus.begin(), cpus.end()) + 1;
+
+        // Cores are (package, core id) pairs, cpus without topology (offline) get a core each
+        std::vector<std::pair<size_t, size_t> > cores;
+        m_cpuToCore.resize(m_numCpus);
+        for(size_t cpu = 0; cpu < m_numCpus; ++cpu)
+        {
+            const std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+            std::pair<size_t, size_t> core(~size_t(0), cpu);
+            if(readNumber(path + "core_id", core.second) && !readNumber(path + "physical_package_id", core.first))
+                core.first = 0;
+
+            const std::vector<std::pair<size_t, size_t> >::iterator found = std::find(cores.begin(), cores.end(), core);
+            m_cpuToCore[cpu] = found - cores.begin();
+            if(found == cores.end())
+                cores.push_back(core);
+        }
+
+        // Node ids can have holes, so number the ones we find densely
+        m_cpuToNode.assign(m_numCpus, 0);
+        size_t numNodes = 0;
+        if(DIR* nodes = opendir("/sys/devices/system/node"))
+        {
+            while(dirent* entry = readdir(nodes))
+            {
+                const std::string name = entry->d_name;
+                if(name.size() <= 4 || name.compare(0, 4, "node") != 0
+                    || name.find_first_not_of("0123456789", 4) != std::string::npos)
+                {
+                    continue;
+                }
+
+                std::vector<size_t> nodeCpus;
+                if(readLine("/sys/devices/system/node/" + name + "/cpulist", line))
+                    parseCpuList(line, nodeCpus);
+                if(nodeCpus.empty())
+                    continue;
+                for(size_t i = 0; i < nodeCpus.size(); ++i)
+                {
+                    if(nodeCpus[i] < m_numCpus)
+                        m_cpuToNode[nodeCpus[i]] = numNodes;
+                }
+                ++numNodes;
+            }
+            closedir(nodes);
+        }
+        m_numNodes = numNodes == 0 ? 1 : numNodes;
+
+        size_t lineSize = 0;
+        if(readNumber("/sys/devices/system/cpu/cpu0/cache/index0/coherency_line_size", lineSize) && lineSize != 0)
+            m_cacheLineSize = lineSize;
+    #elif defined(_WIN32)
+        m_numCpus = hardwareThreads();
+        m_cpuToNode.assign(m_numCpus, 0);
+
+        DWORD bytes = 0;
+        GetLogicalProcessorInformation(nullptr, &bytes);
+        std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> entries(bytes / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+        if(!entries.empty() && GetLogicalProcessorInformation(&entries[0], &bytes))
+        {
+            m_cpuToCore.assign(m_numCpus, 0);
+            size_t numCores = 0;
+            size_t numNodes = 0;
+            for(size_t i = 0; i < entries.size(); ++i)
+            {
+                const SYSTEM_LOGICAL_PROCESSOR_INFORMATION& entry = entries[i];
+                if(entry.Relationship == RelationProcessorCore || entry.Relationship == RelationNumaNode)
+                {
+                    std::vector<size_t>& map = entry.Relationship == RelationProcessorCore ? m_cpuToCore : m_cpuToNode;
+                    const size_t index = entry.Relationship == RelationProcessorCore ? numCores++ : numNodes++;
+                    for(size_t cpu = 0; cpu < m_numCpus && cpu < sizeof(ULONG_PTR) * 8; ++cpu)
+                    {
+                        if(entry.ProcessorMask & (ULONG_PTR(1) << cpu))
+                            map[cpu] = index;
+                    }
+                }
+                else if(entry.Relationship == RelationCache && entry.Cache.Level == 1 && entry.Cache.LineSize != 0)
+                {
+                    m_cacheLineSize = entry.Cache.LineSize;
+                }
+            }
+            m_numNodes = numNodes == 0 ? 1 : numNodes;
+        }
+    #else
+        m_numCpus = hardwareThreads();
+    #endif
+
+        if(m_cpuToCore.size() != m_numCpus)
+        {
+            m_cpuToCore.resize(m_numCpus);
+            for(size_t cpu = 0; cpu < m_numCpus; ++cpu)
+                m_cpuToCore[cpu] = cpu;
+        }
+        m_cpuToNode.resize(m_numCpus, 0);
+        m_numCores = *std::max_element(m_cpuToCore.begin(), m_cpuToCore.end()) + 1;
+
+        const char* fake = std::getenv("DX_NUMA_NODES");
+        if(fake != nullptr && std::atoi(fake) > 0)
+        {
+            m_fakeNodes = static_cast<size_t>(std::atoi(fake));
+            m_numNodes = m_fakeNodes;
+            for(size_t cpu = 0; cpu < m_numCpus; ++cpu)
+                m_cpuToNode[cpu] = cpu % m_fakeNodes;
+        }
+
+        m_nodeCpus.resize(m_numNodes);
+        for(size_t cpu = 0; cpu < m_numCpus; ++cpu)
+            m_nodeCpus[m_cpuToNode[cpu]].push_back(cpu);
+    }
+
+    size_t Topology::numCpus() const
+    {
+        return m_numCpus;
+    }
+
+    size_t Topology::numCores() const
+    {
+        return m_numCores;
+    }
+
+    size_t Topology::numNodes() const
+    {
+        return m_numNodes;
+    }
+
+    size_t Topology::cacheLineSize() const
+    {
+        return m_cacheLineSize;
+    }
+
+    size_t Topology::coreOf(size_t cpu) const
+    {
+        return cpu < m_numCpus ? m_cpuToCore[cpu] : 0;
+    }
+
+    size_t Topology::nodeOf(size_t cpu) const
+    {
+        if(m_fakeNodes != 0)
+            return cpu % m_fakeNodes;
+        return cpu < m_numCpus ? m_cpuToNode[cpu] : 0;
+    }
+
+    const std::vector<size_t>& Topology::cpusOfNode(size_t node) const
+    {
+        return m_nodeCpus[node < m_numNodes ? node : 0];
+    }
+
+    size_t Topology::currentCpu()
+    {
+    #if defined(__linux__)
+        const int cpu = sched_getcpu();
+        if(cpu >= 0)
+            return static_cast<size_t>(cpu);
+    #elif defined(_WIN32)
+        return static_cast<size_t>(GetCurrentProcessorNumber());
+    #endif
+        return currentThreadId() % instance().numCpus();
+    }
+
+    size_t Topology::currentNode()
+    {
+        const Topology& topology = instance();
+        // Skip the getcpu on the common single node machine
+        if(topology.m_numNodes == 1)
+            return 0;
+        return topology.nodeOf(currentCpu());
+    }
+
+    bool setCurrentThreadAffinity(const std::vector<size_t>& cpus)
+    {
+    #if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for(size_t i = 0; i < cpus.size(); ++i)
+        {
+            if(cpus[i] < CPU_SETSIZE)
+                CPU_SET(cpus[i], &set);
+        }
+        return CPU_COUNT(&set) != 0 && pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+    #elif defined(_WIN32)
+        DWORD_PTR mask = 0;
+        for(size_t i = 0; i < cpus.size(); ++i)
+        {
+            if(cpus[i] < sizeof(DWORD_PTR) * 8)
+                mask |= DWORD_PTR(1) << cpus[i];
+        }
+        return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+    #else
+        (void)cpus;
+        return false;
+    #endif
+    }
+
+    bool getCurrentThreadAffinity(std::vector<size_t>& cpus)
+    {
+        cpus.clear();
+    #if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if(pthread_getaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+            return false;
+        for(size_t cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if(CPU_ISSET(cpu, &set))
+                cpus.push_back(cpu);
+        }
+        return true;
+    #elif defined(_WIN32)
+        // There is no getter, but setting a mask returns the previous one. Anything outside the
+        // process' mask is rejected, so set that.
+        DWORD_PTR processMask = 0;
+        DWORD_PTR systemMask = 0;
+        if(!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask))
+            return false;
+        const DWORD_PTR mask = SetThreadAffinityMask(GetCurrentThread(), processMask);
+        if(mask == 0)
+            return false;
+        SetThreadAffinityMask(GetCurrentThread(), mask);
+        for(size_t cpu = 0; cpu < sizeof(DWORD_PTR) * 8; ++cpu)
+        {
+            if(mask & (DWORD_PTR(1) << cpu))
+                cpus.push_back(cpu);
+        }
+        return true;
+    #else
+        return false;
+    #endif
+    }
+
+    bool pinCurrentThread(size_t cpu)
+    {
+        return setCurrentThreadAffinity(std::vector<size_t>(1, cpu));
+    }
+
+    bool pinCurrentThreadToNode(size_t node)
+    {
+        const Topology& topology = Topology::instance();
+        if(node >= topology.numNodes())
+            return false;
+        return setCurrentThreadAffinity(topology.cpusOfNode(node));
+    }
+
+}
\ No newline at end of file
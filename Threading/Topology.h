@@ -0,0 +1,90 @@
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief Topology describes the machine's cpus: which core and NUMA node every logical cpu
+        belongs to, and the cache line size. It is read once, on first use, from /sys/devices/system
+        on Linux and from GetLogicalProcessorInformation on Windows (first processor group only).
+        Elsewhere every cpu counts as its own core on node 0.
+
+        Cores and nodes are numbered densely from 0, whatever ids the system uses. Set the
+        DX_NUMA_NODES environment variable to N to pretend there are N nodes, cpu i belonging to
+        node i % N, e.g. to test NUMA aware code on a single node machine.
+
+        CACHE_LINE_SIZE stays a compile time constant since alignas needs one, cacheLineSize() is
+        what the hardware reports, to check it against.
+
+        \code
+        const Topology& topology = Topology::instance();
+        for(size_t node = 0; node < topology.numNodes(); ++node)
+            startShard(node, topology.cpusOfNode(node));
+        ...
+        // In the shard's thread
+        pinCurrentThreadToNode(node);
+        \endcode
+    */
+    class Topology
+    {
+    public:
+        static const Topology& instance();
+
+        /*! \brief One more than the highest cpu id, at least 1
+        */
+        size_t  numCpus() const;
+        /*! \brief Physical cores, logical cpus sharing a core (SMT siblings) count once
+        */
+        size_t  numCores() const;
+        size_t  numNodes() const;
+        size_t  cacheLineSize() const;
+
+        size_t  coreOf(size_t cpu) const;
+        size_t  nodeOf(size_t cpu) const;
+        const std::vector<size_t>& cpusOfNode(size_t node) const;
+
+        /*! \brief The cpu the calling thread is running on. Uses getcpu where there is one (which
+            glibc answers from rseq without a system call), otherwise spreads threads by
+            currentThreadId(). The thread may have moved on by the time this returns.
+        */
+        static size_t currentCpu();
+        static size_t currentNode();
+
+    private:
+        Topology();
+        void read();
+
+        size_t              m_numCpus;
+        size_t              m_numCores;
+        size_t              m_numNodes;
+        size_t              m_cacheLineSize;
+        std::vector<size_t> m_cpuToCore;
+        std::vector<size_t> m_cpuToNode;
+        std::vector<std::vector<size_t> > m_nodeCpus;
+        // Set by DX_NUMA_NODES
+        size_t              m_fakeNodes;
+
+        Topology(const Topology&);
+        Topology(Topology&&);
+    };
+
+    /*! \brief Restricts the calling thread to cpus. Returns false if the platform can't, or none of
+        cpus is usable.
+    */
+    bool setCurrentThreadAffinity(const std::vector<size_t>& cpus);
+    /*! \brief Fills cpus with the ones the calling thread may run on
+    */
+    bool getCurrentThreadAffinity(std::vector<size_t>& cpus);
+    /*! \brief Pins the calling thread to a single cpu
+    */
+    bool pinCurrentThread(size_t cpu);
+    /*! \brief Restricts the calling thread to the cpus of a NUMA node
+    */
+    bool pinCurrentThreadToNode(size_t node);
+
+}
\ No newline at end of file
@@ -0,0 +1,111 @@
+
+#include "WorkerTeam.h"
+
+#include "Topology.h"
+
+#include <algorithm>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    namespace
+    {
+        size_t teamSize(size_t numThreads)
+        {
+            if(numThreads != 0)
+                return numThreads;
+            return std::max<size_t>(1, std::thread::hardware_concurrency());
+        }
+    }
+
+    WorkerTeam::WorkerTeam(size_t numThreads, bool pinThreads)
+        : m_size(teamSize(numThreads)), m_phases(nullptr), m_numPhases(0), m_count(0), m_stopping(false),
+    #if defined _DEBUG || defined DEBUG
+          m_running(false),
+    #endif
+          m_generation(0), m_sleepers(0), m_barrier(m_size)
+    {
+        m_threads.reserve(m_size - 1);
+        for(size_t i = 1; i < m_size; ++i)
+            m_threads.push_back(std::thread(&WorkerTeam::workerMain, this, i, pinThreads));
+    }
+
+    WorkerTeam::~WorkerTeam()
+    {
+        m_stopping = true;
+        m_generation.fetch_add(1, std::memory_order_release);
+        futexWakeAll(m_generation);
+        for(size_t i = 0; i < m_threads.size(); ++i)
+            m_threads[i].join();
+    }
+
+    size_t WorkerTeam::size() const
+    {
+        return m_size;
+    }
+
+    void WorkerTeam::runImpl(size_t count, const Phase* phases, size_t numPhases)
+    {
+        #if defined _DEBUG || defined DEBUG
+            assert(!m_running.exchange(true)); // run() isn't reentrant
+        #endif
+
+        m_phases = phases;
+        m_numPhases = numPhases;
+        m_count = count;
+        m_generation.fetch_add(1);
+        futexWakeAllSleepers(m_generation, m_sleepers);
+
+        runPhases(0);
+
+        #if defined _DEBUG || defined DEBUG
+            m_running = false;
+        #endif
+    }
+
+    void WorkerTeam::runPhases(size_t threadIndex) const
+    {
+        // Copy the job, the caller may start the next one as soon as the last barrier opens
+        const Phase* phases = m_phases;
+        const size_t numPhases = m_numPhases;
+
+        const size_t chunk = m_count / m_size;
+        const size_t remainder = m_count % m_size;
+        const size_t begin = threadIndex * chunk + std::min(threadIndex, remainder);
+        const size_t end = begin + chunk + (threadIndex < remainder ? 1 : 0);
+
+        for(size_t i = 0; i < numPhases; ++i)
+        {
+            if(begin != end)
+                phases[i].invoke(phases[i].phase, begin, end, threadIndex);
+            m_barrier.arriveAndWait();
+        }
+    }
+
+    void WorkerTeam::workerMain(size_t threadIndex, bool pin)
+    {
+        if(pin)
+            pinCurrentThread(threadIndex % Topology::instance().numCpus());
+
+        uint32_t seen = 0;
+        for(;;)
+        {
+            // Spins first, back-to-back jobs shouldn't pay for a wake-up
+            uint32_t generation = 0;
+            futexPark(m_generation, seen, m_sleepers, DEFAULT_PARK_SPINS, [&]()
+            {
+                generation = m_generation.load(std::memory_order_acquire);
+                return generation != seen;
+            });
+            seen = generation;
+
+            if(m_stopping)
+                return;
+            runPhases(threadIndex);
+        }
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,214 @@
+
+#pragma once
+
+#include "../CacheLine.h"
+#include "../Mutex/BlockingBarrier.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace DX
+{
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief WorkerTeam is a fixed team of threads for bulk-synchronous jobs. The threads are
+        started once and then sleep between jobs, so a job costs a wake-up instead of spawning
+        threads, and the team can be reused for as many jobs as needed.
+
+        run(count, phases...) runs each phase over the index range [0, count), split into one
+        contiguous chunk per thread, with a barrier between phases: no thread starts phase i + 1
+        before every thread has finished phase i. A phase is anything callable as
+        phase(begin, end, threadIndex). The calling thread works as thread 0 and run() returns once
+        the last phase is done everywhere.
+
+        Pass pinThreads to pin worker i to cpu i, keeping every thread's chunk in the same caches
+        from phase to phase.
+
+        \note Phases must not throw. Only one run() may be in progress at a time.
+
+        \code
+        WorkerTeam team(8);
+        ReductionSlots<double> residuals(team);
+        for(size_t iteration = 0; iteration < maxIterations; ++iteration)
+        {
+            residuals.reset(0.0);
+            team.run(grid.size(),
+                [&](size_t begin, size_t end, size_t thread)
+                {
+                    for(size_t i = begin; i < end; ++i)
+                        residuals[thread] += relax(grid, next, i);
+                },
+                [&](size_t begin, size_t end, size_t)
+                {
+                    std::copy(next.begin() + begin, next.begin() + end, grid.begin() + begin);
+                });
+            if(residuals.reduce(0.0, std::plus<double>()) < tolerance)
+                break;
+        }
+        \endcode
+    */
+    class WorkerTeam
+    {
+    public:
+        /*! \param[in] numThreads Team size including the calling thread, 0 for one per hardware thread
+            \param[in] pinThreads Pin worker i to cpu i (the calling thread is left alone)
+        */
+        explicit WorkerTeam(size_t numThreads = 0, bool pinThreads = false);
+        ~WorkerTeam();
+
+        size_t size() const;
+
+        template <typename... Phases>
+        void run(size_t count, Phases&&... phases);
+
+    private:
+        struct Phase
+        {
+            void    (*invoke)(void* phase, size_t begin, size_t end, size_t threadIndex);
+            void*   phase;
+        };
+
+        template <typename PhaseT>
+        static void invokePhase(void* phase, size_t begin, size_t end, size_t threadIndex);
+        template <typename PhaseT>
+        static Phase makePhase(PhaseT& phase);
+
+        void runImpl(size_t count, const Phase* phases, size_t numPhases);
+        void runPhases(size_t threadIndex) const;
+        void workerMain(size_t threadIndex, bool pin);
+
+        const size_t                m_size;
+        std::vector<std::thread>    m_threads;
+        // Current job, published to the workers by bumping m_generation
+        const Phase*                m_phases;
+        size_t                      m_numPhases;
+        size_t                      m_count;
+        bool                        m_stopping;
+    #if defined _DEBUG || defined DEBUG
+        std::atomic<bool>           m_running;
+    #endif
+        // Futex word the idle workers sleep on, and how many of them are (about to be) asleep
+        DX_CACHE_ALIGNED std::atomic<uint32_t> m_generation;
+        std::atomic<uint32_t>       m_sleepers;
+        BlockingBarrier             m_barrier;
+
+        WorkerTeam(const WorkerTeam&);
+        WorkerTeam(WorkerTeam&&);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+
+    /*! \brief ReductionSlots gives every thread of a WorkerTeam its own cache line sized slot to
+        accumulate into, so phases can reduce without sharing anything. Combine the slots with
+        reduce() after run() returns, or in a later phase of the same job.
+    */
+    template <typename T>
+    class ReductionSlots
+    {
+    public:
+        explicit ReductionSlots(const WorkerTeam& team, const T& initial = T());
+        ~ReductionSlots();
+
+        T&          operator[](size_t threadIndex);
+        const T&    operator[](size_t threadIndex) const;
+        size_t      size() const;
+
+        void        reset(const T& value);
+        /*! \brief Folds every slot into initial with combine(accumulated, slot), in thread order
+        */
+        template <typename Combine>
+        T           reduce(T initial, Combine combine) const;
+
+    private:
+        CachePadded<T>* m_slots;
+        const size_t    m_size;
+
+        ReductionSlots(const ReductionSlots&);
+        ReductionSlots(ReductionSlots&&);
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    template <typename PhaseT>
+    void WorkerTeam::invokePhase(void* phase, size_t begin, size_t end, size_t threadIndex)
+    {
+        (*static_cast<PhaseT*>(phase))(begin, end, threadIndex);
+    }
+
+    template <typename PhaseT>
+    WorkerTeam::Phase WorkerTeam::makePhase(PhaseT& phase)
+    {
+        Phase result = { &invokePhase<PhaseT>, const_cast<void*>(static_cast<const void*>(&phase)) };
+        return result;
+    }
+
+    template <typename... Phases>
+    void WorkerTeam::run(size_t count, Phases&&... phases)
+    {
+        static_assert(sizeof...(Phases) > 0, "run() needs at least one phase");
+        const Phase erased[] = { makePhase(phases)... };
+        runImpl(count, erased, sizeof...(Phases));
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    ////////////////////////////////////////////////////////////////////////////////////////////////
+    // impl
+
+    template <typename T>
+    ReductionSlots<T>::ReductionSlots(const WorkerTeam& team, const T& initial)
+        : m_slots(new CachePadded<T>[team.size()]), m_size(team.size())
+    {
+        reset(initial);
+    }
+
+    template <typename T>
+    ReductionSlots<T>::~ReductionSlots()
+    {
+        delete[] m_slots;
+    }
+
+    template <typename T>
+    T& ReductionSlots<T>::operator[](size_t threadIndex)
+    {
+        assert(threadIndex < m_size);
+        return m_slots[threadIndex].value;
+    }
+
+    template <typename T>
+    const T& ReductionSlots<T>::operator[](size_t threadIndex) const
+    {
+        assert(threadIndex < m_size);
+        return m_slots[threadIndex].value;
+    }
+
+    template <typename T>
+    size_t ReductionSlots<T>::size() const
+    {
+        return m_size;
+    }
+
+    template <typename T>
+    void ReductionSlots<T>::reset(const T& value)
+    {
+        for(size_t i = 0; i < m_size; ++i)
+            m_slots[i].value = value;
+    }
+
+    template <typename T>
+    template <typename Combine>
+    T ReductionSlots<T>::reduce(T initial, Combine combine) const
+    {
+        for(size_t i = 0; i < m_size; ++i)
+            initial = combine(initial, m_slots[i].value);
+        return initial;
+    }
+
+}
\ No newline at end of file